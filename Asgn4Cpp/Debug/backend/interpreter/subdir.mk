@@ -4,13 +4,16 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
-../backend/interpreter/Executor.cpp 
+../backend/interpreter/Executor.cpp \
+../backend/interpreter/SamplingProfiler.cpp 
 
 OBJS += \
-./backend/interpreter/Executor.o 
+./backend/interpreter/Executor.o \
+./backend/interpreter/SamplingProfiler.o 
 
 CPP_DEPS += \
-./backend/interpreter/Executor.d 
+./backend/interpreter/Executor.d \
+./backend/interpreter/SamplingProfiler.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
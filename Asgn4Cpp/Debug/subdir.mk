@@ -4,13 +4,16 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
-../Pcl4.cpp 
+../Pcl4.cpp \
+../../Simple/src/Stats.cpp 
 
 OBJS += \
-./Pcl4.o 
+./Pcl4.o \
+./Stats.o 
 
 CPP_DEPS += \
-./Pcl4.d 
+./Pcl4.d \
+./Stats.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -21,4 +24,11 @@ CPP_DEPS += \
 	@echo 'Finished building: $<'
 	@echo ' '
 
+Stats.o: ../../Simple/src/Stats.cpp
+	@echo 'Building file: $<'
+	@echo 'Invoking: GCC C++ Compiler'
+	g++ -std=c++0x -I"/Users/sowmyabijjala/eclipse-workspace/Asgn4Cpp" -I"/Users/sowmyabijjala/eclipse-workspace/Asgn4Cpp/target/generated-sources/antlr4" -I/Users/sowmyabijjala/ANTLR-4.7.2/antlr4-runtime -O0 -g3 -Wall -c -fmessage-length=0 -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
 
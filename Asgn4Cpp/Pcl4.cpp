@@ -7,6 +7,8 @@
 #include "Pcl4Lexer.h"
 #include "Pcl4Parser.h"
 #include "Executor.h"
+#include "SamplingProfiler.h"
+#include "../Simple/src/Stats.h"
 
 using namespace antlrcpp;
 using namespace antlr4;
@@ -16,21 +18,59 @@ using namespace std;
 /**
  * Execute the source program.
  * @param tree the parse tree root.
+ * @param stats the statistics, to count the variables.
  */
-void executeProgram(tree::ParseTree *tree);
+void executeProgram(tree::ParseTree *tree, Stats &stats);
+
+/**
+ * Execute the source program under the sampling profiler and write
+ * the samples in folded-stack format to sourceFileName.folded.
+ * @param tree the parse tree root.
+ * @param sourceFileName the source file name.
+ * @param stats the statistics, to count the variables.
+ */
+void profileProgram(tree::ParseTree *tree, string sourceFileName,
+                    Stats &stats);
+
+/**
+ * Count the nodes of a parse tree.
+ * @param tree the parse tree root.
+ * @return the count.
+ */
+long countNodes(tree::ParseTree *tree);
 
 int main(int argc, const char *args[])
 {
+    // An optional -stats {text, json} precedes the option.
+    int statsFormat = -1;
+    if ((argc == 5) && (string(args[1]) == "-stats"))
+    {
+        string format = args[2];
+        if      (format == "text") statsFormat = Stats::TEXT;
+        else if (format == "json") statsFormat = Stats::JSON;
+        else cout << "*** Unknown statistics format " << format << endl;
+
+        args += 2;
+        argc -= 2;
+    }
+
     if (argc != 3)
     {
-        cout << "USAGE: PascalJava option sourceFileName" << endl;
-        cout << "   option: -execute, -convert, or -compile" << endl;
+        cout << "USAGE: PascalJava [-stats {text, json}] option sourceFileName"
+             << endl;
+        cout << "   option: -execute, -profile, -convert, or -compile" << endl;
         return -1;
     }
 
     string operation = toLowerCase(args[1]);
     string sourceFileName = args[2];
 
+    // The heap is counted only for statistics.
+    if (statsFormat >= 0) Stats::countHeap();
+
+    Stats stats;
+    stats.start("load");
+
     ifstream source;
 
     // Create the input stream.
@@ -38,30 +78,89 @@ int main(int argc, const char *args[])
     ANTLRInputStream input(source);
 
     // Create a lexer which scans the input stream
-    // to create a token stream.
+    // to create a token stream. Fill it up front
+    // so that scanning is timed apart from parsing.
+    stats.start("scan");
     Pcl4Lexer lexer(&input);
     CommonTokenStream tokens(&lexer);
+    tokens.fill();
 
     // Create a parser which parses the token stream
     // to create a parse tree.
+    stats.start("parse");
     Pcl4Parser parser(&tokens);
     tree::ParseTree *tree = parser.program();
 
     // Backend operation.
-    if (operation == "-execute") executeProgram(tree);
+    stats.start("execute");
+    if (operation == "-execute") executeProgram(tree, stats);
+    else if (operation == "-profile")
+    {
+        profileProgram(tree, sourceFileName, stats);
+    }
     else
     {
-        cout << "USAGE: PascalJava option sourceFileName" << endl;
-        cout << "   option: -execute, -convert, or -compile" << endl;
+        cout << "USAGE: PascalJava [-stats {text, json}] option sourceFileName"
+             << endl;
+        cout << "   option: -execute, -profile, -convert, or -compile" << endl;
         return -1;
     }
 
+    // After the program's output, and apart from it.
+    if (statsFormat >= 0)
+    {
+        stats.count("tokens", tokens.size());
+        stats.count("nodes", countNodes(tree));
+
+        cout.flush();
+        stats.print(cerr, statsFormat);
+    }
+
     return 0;
 }
 
-void executeProgram(tree::ParseTree *tree)
+void executeProgram(tree::ParseTree *tree, Stats &stats)
 {
     cout << "Execution:" << endl << endl;
     Executor executor;
     executor.visit(tree);
+
+    stats.count("symtabEntries", executor.getVariableCount());
+}
+
+void profileProgram(tree::ParseTree *tree, string sourceFileName,
+                    Stats &stats)
+{
+    cout << "Execution:" << endl << endl;
+
+    Pcl4Parser::ProgramContext *programCtx =
+                                    (Pcl4Parser::ProgramContext *) tree;
+    SamplingProfiler profiler(programCtx->programHeader()
+                                        ->IDENTIFIER()->getText());
+    Executor executor;
+
+    executor.setProfiler(&profiler);
+    profiler.start();
+    executor.visit(tree);
+    profiler.stop();
+    stats.count("symtabEntries", executor.getVariableCount());
+
+    string foldedFileName = sourceFileName + ".folded";
+    ofstream folded(foldedFileName);
+    profiler.writeFolded(folded);
+
+    cout << endl << "Profile written to " << foldedFileName;
+    if (profiler.getDroppedCount() > 0)
+    {
+        cout << " (" << profiler.getDroppedCount() << " samples dropped)";
+    }
+    cout << endl;
+}
+
+long countNodes(tree::ParseTree *tree)
+{
+    long count = 1;
+    for (tree::ParseTree *child : tree->children) count += countNodes(child);
+
+    return count;
 }
@@ -10,16 +10,40 @@ namespace backend { namespace interpreter {
 using namespace std;
 using namespace intermediate::symtab;
 
+// For each relational operator, which outcomes of comparing
+// two values (bit 0 <, bit 1 =, bit 2 >) make it true.
+static const int RELATIONAL_MASKS[] =
+{
+    0x2,  // =
+    0x5,  // <>
+    0x1,  // <
+    0x3,  // <=
+    0x4,  // >
+    0x6   // >=
+};
+
 Object Executor::visitProgram(Pcl4Parser::ProgramContext *ctx)
 {
     cout << "Visiting program" << endl;
 
-    return visit(ctx->block());
+    try
+    {
+        visit(ctx->block());
+    }
+    catch (RuntimeError &)
+    {
+        // Already reported.
+    }
+
+    return nullptr;
 }
 
 Object Executor::visitStatement(Pcl4Parser::StatementContext *ctx)
 {
-    cout << "Line " << ctx->getStart()->getLine() << ": ";
+    int line = ctx->getStart()->getLine();
+    if (profiler != nullptr) profiler->setLine(line);
+
+    cout << "Line " << line << ": ";
     return visitChildren(ctx);
 }
 
@@ -47,9 +71,12 @@ Object Executor::visitAssignmentStatement(Pcl4Parser::AssignmentStatementContext
     string variableName = ctx->lhs()->variable()->getText();
     visit(ctx->lhs());
     Object value = visit(ctx->rhs());
+    symtab[variableName] = value;
 
-    cout << "Will assign value " << value.as<int>()
-         << " to variable " << variableName << endl;
+    cout << "Will assign value ";
+    if (value.is<bool>()) cout << (value.as<bool>() ? "true" : "false");
+    else                  cout << toNumber(value);
+    cout << " to variable " << variableName << endl;
     return nullptr;
 }
 
@@ -62,12 +89,15 @@ Object Executor::visitRepeatStatement(Pcl4Parser::RepeatStatementContext *ctx)
     Pcl4Parser::StatementListContext *listCtx = ctx->statementList();
     bool value = false;
 
+    if (profiler != nullptr)
+        profiler->pushLoop(FrameKind::REPEAT, ctx->getStart()->getLine());
+
     do {
         visit(listCtx);
-        string exprValue = visit(ctx->expression()).as<string>();
-        value = (exprValue=="T");
+        value = toBool(visit(ctx->expression()));
     } while(!value);
 
+    if (profiler != nullptr) profiler->popLoop();
     return nullptr;
 
 }
@@ -77,44 +107,57 @@ Object Executor::visitForStatement(Pcl4Parser::ForStatementContext *ctx) {
 
 	cout << "Visiting for statement" << endl;
 
-    //Pcl4Parser::VariableContext *listCtx = ctx->variable(); //i
-	Pcl4Parser::ExpressionContext *ctx1 = ctx->expression(0);
+    string variableName = ctx->variable()->getText();
+    Pcl4Parser::StatementContext *stmtCtx = ctx->statement();
 
-    int start = stoi(ctx1->getText());
-    cout << "Will assign value " << start;
+    // Evaluate both bounds once.
+    long start = (long) toNumber(visit(ctx->expression(0)));
+    long end   = (long) toNumber(visit(ctx->expression(1)));
+    long step  = ctx->TO() != nullptr ? 1 : -1;
 
+    // Count in a local. Store the control variable into the
+    // symbol table only if the loop body can read it.
+    bool observable = referencesVariable(stmtCtx, variableName);
 
-    Pcl4Parser::ExpressionContext *simpleCtx = ctx->expression(0); //= 5?
-    int end = stoi(simpleCtx->getText());
-    cout << "Will assign value " << end;
+    if (profiler != nullptr)
+        profiler->pushLoop(FrameKind::FOR, ctx->getStart()->getLine());
 
-    if(ctx->TO()->getText() == "TO")
-    {
-    	for(int i = start; i < end; i++)
-    	{
-    		Pcl4Parser::StatementContext *stmtCtx = ctx->statement();
-    		visit(stmtCtx);
-    	}
-    }
-    else if(ctx->DOWNTO()->getText()=="DOWNTO")
+    long i = start;
+    for (; (step > 0) ? (i <= end) : (i >= end); i += step)
     {
-    	for(int i = start; i < end; i--)
-    	{
-    	    Pcl4Parser::StatementContext *stmtCtx = ctx->statement();
-    	    visit(stmtCtx);
-    	}
+        if (observable) symtab[variableName] = (double) i;
+        visit(stmtCtx);
     }
 
+    // Leave the control variable at its final value.
+    if (i != start) symtab[variableName] = (double) (i - step);
+
+    if (profiler != nullptr) profiler->popLoop();
     return nullptr;
 
 }
 
+bool Executor::referencesVariable(antlr4::tree::ParseTree *tree, const string &name)
+{
+    Pcl4Parser::VariableContext *varCtx =
+                            dynamic_cast<Pcl4Parser::VariableContext *>(tree);
+    if (varCtx != nullptr) return toLowerCase(varCtx->getText())
+                                                        == toLowerCase(name);
+
+    for (antlr4::tree::ParseTree *child : tree->children)
+    {
+        if (referencesVariable(child, name)) return true;
+    }
+
+    return false;
+}
+
 Object Executor::visitCaseStatement(Pcl4Parser::CaseStatementContext *ctx)
 {
 	cout << "Visiting case statement" << endl;
 
     bool match = false;
-    long caseValue = (long) stod(visit(ctx->expression()).as<string>());
+    long caseValue = (long) toNumber(visit(ctx->expression()));
 
     Pcl4Parser::CaseBranchListContext *branchlistCtx = ctx->caseBranchList();
     for (Pcl4Parser::CaseBranchContext *branchCtx : branchlistCtx->caseBranch())
@@ -124,7 +167,7 @@ Object Executor::visitCaseStatement(Pcl4Parser::CaseStatementContext *ctx)
         for (Pcl4Parser::CaseConstantContext *caseConstCtx : constListCtx->caseConstant())
         {
             bool negate = (caseConstCtx->sign() != nullptr) && (caseConstCtx->sign()->getText() == "-");
-            long constValue = (long) stod(visit(caseConstCtx->unsignedNumber()).as<string>());
+            long constValue = (long) toNumber(visit(caseConstCtx->unsignedNumber()));
             if (negate)
             {
                 constValue = -constValue;
@@ -152,12 +195,15 @@ Object Executor::visitWhileStatement(Pcl4Parser::WhileStatementContext *ctx) {
 
 	cout << "Visiting while statement" << endl;
 
+    if (profiler != nullptr)
+        profiler->pushLoop(FrameKind::WHILE, ctx->getStart()->getLine());
+
     Pcl4Parser::StatementContext *stmtCtx = ctx->statement();
-    bool value = visit(ctx->expression()).as<string>() == "T";
-    while (value) {
+    while (toBool(visit(ctx->expression()))) {
         visit(stmtCtx);
-        value = visit(ctx->expression()).as<string>() == "T";
     }
+
+    if (profiler != nullptr) profiler->popLoop();
     return nullptr;
 }
 
@@ -183,35 +229,22 @@ Object Executor::visitExpression(Pcl4Parser::ExpressionContext *ctx)
 
     Pcl4Parser::SimpleExpressionContext *simpleCtx1 = ctx->simpleExpression(0);
     Pcl4Parser::RelOpContext *relOpCtx = ctx->relOp();
-    string operand1 = visit(simpleCtx1).as<string>();
+    Object operand1 = visit(simpleCtx1);
 
     if (relOpCtx != nullptr) {
-        string op = relOpCtx->getText();
+        Operator op = decode(relOpCtx);
         Pcl4Parser::SimpleExpressionContext *simpleCtx2 = ctx->simpleExpression(1);
-        string operand2 = visit(simpleCtx2).as<string>();
-
-        double val1 = stod(operand1);
-        double val2 = stod(operand2);
-        //Expressions have relational operators, so the result will be a bool
-        bool result=false;
-
-        if(op == "=")
-            result = (val1 == val2);
-        else if (op == "<>")
-            result = (val1 != val2);
-        else if (op == "<")
-            result = (val1 < val2);
-        else if (op == ">")
-            result = (val1 > val2);
-        else if (op == "<=")
-            result = (val1 <= val2);
-        else if (op == ">=")
-            result = val1 >= val2;
-        //no default case
-
-        if(result)
-            return string("T");
-        return string("F");
+        Object operand2 = visit(simpleCtx2);
+
+        double val1 = toNumber(operand1);
+        double val2 = toNumber(operand2);
+
+        //Expressions have relational operators, so the result will be a bool.
+        //Select the outcome bit (<, =, >) from the operator's mask.
+        int outcome = (val1 > val2) - (val1 < val2) + 1;
+        bool result = (RELATIONAL_MASKS[(int) op] >> outcome) & 1;
+
+        return result;
     }
 
     return operand1; //occurs if the expr was just a simple expr
@@ -229,11 +262,9 @@ Object Executor::visitIfStatement(Pcl4Parser::IfStatementContext *ctx)
 	Pcl4Parser::TruestatementContext *truectx = ctx->truestatement();
 	Pcl4Parser::FalsestatementContext *falsectx = ctx->falsestatement();
 
-	visit(ctx1);
-
-	visit(truectx);
-
-	if(falsectx != nullptr)
+	if (toBool(visit(ctx1)))
+		visit(truectx);
+	else if(falsectx != nullptr)
 		visit(falsectx);
 
 	return nullptr;
@@ -252,35 +283,30 @@ Object Executor::visitSimpleExpression(Pcl4Parser::SimpleExpressionContext *ctx)
     bool negative = (ctx->sign() != nullptr) && (ctx->sign()->getText()=="-");
 
     Pcl4Parser::TermContext *termCtx1 = ctx->term(0);
-    string operand1 = visit(termCtx1).as<string>();
+    Object operand1 = visit(termCtx1);
     if(negative) {
-        operand1 = "-" + operand1;
+        operand1 = -toNumber(operand1);
     }
 
     for(int i=1; i<count; i++) {
-        string op = toLowerCase(ctx->addOp(i-1)->getText());
+        Operator op = decode(ctx->addOp(i-1));
         Pcl4Parser::TermContext *termCtx2 = ctx->term(i);
 
-        string operand2 = visit(termCtx2).as<string>();
         //remember that possible operators are only OR, +, -
-        if( (operand2=="T")||(operand2=="F") ) { //opd2 is a bool
-            bool value = (operand1=="T") || (operand2=="T"); //if either opd is true
-            operand1 = string(value? "T" : "F");//then opd1 is T (else F)
+        if (op == Operator::OR) {
+            //short-circuit: don't evaluate the term if already true
+            bool value = toBool(operand1) || toBool(visit(termCtx2));
+            operand1 = value;
         }
         else {
-            double value1 = stod(operand1);
-            double value2 = stod(operand2);
+            double value1 = toNumber(operand1);
+            double value2 = toNumber(visit(termCtx2));
 
-            if(negative) {
-                value1 *= -1;
-                negative = false;
-            }
-
-            if(op=="+"){
-                operand1 = to_string(value1+value2);
+            if(op == Operator::ADD){
+                operand1 = value1+value2;
             }
             else {
-                operand1 = to_string(value1-value2);
+                operand1 = value1-value2;
             }
         }
     }
@@ -293,41 +319,105 @@ Object Executor::visitTerm(Pcl4Parser::TermContext *ctx) {
     int count = ctx->factor().size();
 
     Pcl4Parser::FactorContext *factorCtx1 = ctx->factor(0);
-    string operand1 = visit(factorCtx1).as<string>();
+    Object operand1 = visit(factorCtx1);
 
     for(int i=1; i<count; i++) {
-        string op = toLowerCase(ctx->mulOp(i-1)->getText());
+        Operator op = decode(ctx->mulOp(i-1));
         Pcl4Parser::FactorContext *factorCtx2 = ctx->factor(i);
-        string operand2 = visit(factorCtx2).as<string>();
 
         //remember that possible operators are only AND, *, / DIV, MOD
-        if( (operand2=="T")||(operand2=="F") ) { //if opd2 is a bool
-            if( (operand1=="T") && (operand2=="T") ) //AND op1 and op2
-                operand1 = string("T");
-            else
-                operand1 = string("F");
+        if (op == Operator::AND) {
+            //short-circuit: don't evaluate the factor if already false
+            bool value = toBool(operand1) && toBool(visit(factorCtx2));
+            operand1 = value;
         }
         else {
-            double val1 = stod(operand1);
-            double val2 = stod(operand2);
+            double val1 = toNumber(operand1);
+            double val2 = toNumber(visit(factorCtx2));
 
-            if(op=="*") {
-                operand1 = to_string( val1*val2 );
+            if(op == Operator::MULTIPLY) {
+                operand1 = val1*val2;
+            }
+            //check /, DIV, MOD operations
+            //MOD divides whole numbers, so 0.5 is a zero divisor too
+            else if((val2 == 0) || ((op == Operator::MOD) && (long(val2) == 0))) {
+                runtimeError(ctx, "Division by zero");
             }
-            else if(op=="/") { //check /, DIV, MOD operations
-                operand1 = to_string( val1/val2 );
+            else if(op == Operator::DIVIDE) {
+                operand1 = val1/val2;
             }
-            else if(op=="div") {
-                operand1 = to_string( trunc(val1/val2) );
+            else if(op == Operator::DIV) {
+                operand1 = trunc(val1/val2);
             }
-            else if(op=="mod") {
-                operand1 = to_string (int(val1) % int(val2));
+            else if(op == Operator::MOD) {
+                //x mod -1 is 0, and the one case that would trap
+                long divisor = long(val2);
+                operand1 = divisor == -1 ? 0.0 : (double) (long(val1) % divisor);
             }
         }
     }
     return operand1;
 }
 
+Object Executor::visitNotFactor(Pcl4Parser::NotFactorContext *ctx) {
+    return !toBool(visit(ctx->factor()));
+}
+
+Object Executor::visitParenthesizedExpression(Pcl4Parser::ParenthesizedExpressionContext *ctx) {
+    return visit(ctx->expression());
+}
+
+Executor::Operator Executor::decode(antlr4::ParserRuleContext *opCtx)
+{
+    // An operator context is a single token, whose type tells
+    // the operator apart without a lookup by context or by text.
+    size_t type = opCtx->getStart()->getType();
+    if ((type < operators.size()) && (operators[type] != Operator::UNKNOWN))
+    {
+        return operators[type];
+    }
+
+    // First visit: decode the operator text and remember it.
+    string text = toLowerCase(opCtx->getText());
+    Operator op = text == "="   ? Operator::EQ
+                : text == "<>"  ? Operator::NE
+                : text == "<"   ? Operator::LT
+                : text == "<="  ? Operator::LE
+                : text == ">"   ? Operator::GT
+                : text == ">="  ? Operator::GE
+                : text == "+"   ? Operator::ADD
+                : text == "-"   ? Operator::SUBTRACT
+                : text == "or"  ? Operator::OR
+                : text == "*"   ? Operator::MULTIPLY
+                : text == "/"   ? Operator::DIVIDE
+                : text == "div" ? Operator::DIV
+                : text == "mod" ? Operator::MOD
+                :                 Operator::AND;
+
+    if (type >= operators.size()) operators.resize(type + 1, Operator::UNKNOWN);
+    operators[type] = op;
+    return op;
+}
+
+void Executor::runtimeError(antlr4::ParserRuleContext *ctx, string message)
+{
+    cout << "RUNTIME ERROR at line " << ctx->getStart()->getLine() << ": "
+         << message << ": " << ctx->getText() << endl;
+    throw RuntimeError();
+}
+
+bool Executor::toBool(Object value)
+{
+    return value.is<bool>() && value.as<bool>();
+}
+
+double Executor::toNumber(Object value)
+{
+    // An unassigned variable is 0.
+    if (value.is<double>()) return value.as<double>();
+    return value.is<bool>() && value.as<bool>() ? 1.0 : 0.0;
+}
+
 
 
 Object Executor::visitVariable(Pcl4Parser::VariableContext *ctx)
@@ -362,11 +452,11 @@ Object Executor::visitUnsignedNumber(Pcl4Parser::UnsignedNumberContext *ctx) {
 }
 
 Object Executor::visitIntegerConstant(Pcl4Parser::IntegerConstantContext *ctx) {
-    return ctx->getText();
+    return stod(ctx->getText());
 }
 
 Object Executor::visitRealConstant(Pcl4Parser::RealConstantContext *ctx) {
-    return ctx->getText();
+    return stod(ctx->getText());
 }
 
 Object Executor::visitCharacterConstant(Pcl4Parser::CharacterConstantContext *ctx) {
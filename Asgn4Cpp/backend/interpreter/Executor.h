@@ -3,11 +3,13 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 #include "antlr4-runtime.h"
 #include "Pcl4BaseVisitor.h"
 #include "Symtab.h"
 #include "SymtabEntry.h"
+#include "SamplingProfiler.h"
 
 #include "Object.h"
 
@@ -22,7 +24,7 @@ typedef antlrcpp::Any Object;
 class Executor : public Pcl4BaseVisitor
 {
 public:
-    Executor() {}
+    Executor() : profiler(nullptr) {}
     virtual ~Executor() {}
 
     Object visitProgram(Pcl4Parser::ProgramContext *ctx) override;
@@ -47,12 +49,80 @@ public:
     Object visitExpression(Pcl4Parser::ExpressionContext *ctx) override;
     Object visitVariable(Pcl4Parser::VariableContext *ctx) override;
     Object visitNumber(Pcl4Parser::NumberContext *ctx) override;
-   // Object visitParenthesizedExpression(Pcl4Parser::ParenthesizedExpressionContext *ctx) override;
+    Object visitParenthesizedExpression(Pcl4Parser::ParenthesizedExpressionContext *ctx) override;
+    Object visitNotFactor(Pcl4Parser::NotFactorContext *ctx) override;
+
+    /**
+     * Attach a sampling profiler.
+     * @param profiler the profiler, or null to run without one.
+     */
+    void setProfiler(SamplingProfiler *profiler) { this->profiler = profiler; }
+
+    /**
+     * Get the number of variables that the program has assigned.
+     * @return the number of variables.
+     */
+    int getVariableCount() const { return symtab.size(); }
 
     // Complete this class!
 
 private:
+    /**
+     * Operators, decoded once per operator token type.
+     * The relational operators come first, in RELATIONAL_MASKS order.
+     */
+    enum class Operator
+    {
+        EQ, NE, LT, LE, GT, GE,
+        ADD, SUBTRACT, OR,
+        MULTIPLY, DIVIDE, DIV, MOD, AND,
+        UNKNOWN  // not decoded yet
+    };
+
+    /**
+     * Thrown after a runtime error is reported, to stop the program.
+     */
+    struct RuntimeError {};
+
     map<string,Object> symtab;
+    SamplingProfiler *profiler;
+    vector<Operator> operators;  // by the operator's token type
+
+    /**
+     * Decode an operator, remembering the result for its token type.
+     * @param opCtx the relOp, addOp or mulOp context.
+     * @return the operator.
+     */
+    Operator decode(antlr4::ParserRuleContext *opCtx);
+
+    /**
+     * Convert an expression value to a native boolean.
+     * @param value a bool.
+     * @return the boolean.
+     */
+    static bool toBool(Object value);
+
+    /**
+     * Report a runtime error and stop the program.
+     * @param ctx the context where the error happened.
+     * @param message the error message.
+     */
+    void runtimeError(antlr4::ParserRuleContext *ctx, string message);
+
+    /**
+     * Convert an expression value to a number.
+     * @param value a double, or a bool as 1 or 0.
+     * @return the number.
+     */
+    static double toNumber(Object value);
+
+    /**
+     * Does a subtree read or write a variable?
+     * @param tree the subtree.
+     * @param name the variable name.
+     * @return true if it does.
+     */
+    bool referencesVariable(antlr4::tree::ParseTree *tree, const string &name);
 };
 
 }}  // namespace backend::interpreter
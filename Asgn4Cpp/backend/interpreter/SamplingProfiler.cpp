@@ -0,0 +1,115 @@
+#include <string>
+#include <map>
+#include <atomic>
+#include <iostream>
+#include <csignal>
+#include <sys/time.h>
+
+#include "SamplingProfiler.h"
+
+namespace backend { namespace interpreter {
+
+using namespace std;
+
+SamplingProfiler *SamplingProfiler::active = nullptr;
+
+SamplingProfiler::SamplingProfiler(string programName, int intervalMicros)
+    : programName(programName), intervalMicros(intervalMicros),
+      depth(0), head(0), tail(0), dropped(0)
+{
+    frames[0].kind = FrameKind::PROGRAM;
+    frames[0].header = 0;
+    frames[0].line = 0;
+}
+
+SamplingProfiler::~SamplingProfiler()
+{
+    if (active == this) stop();
+}
+
+void SamplingProfiler::start()
+{
+    active = this;
+
+    struct sigaction action;
+    action.sa_handler = handler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, nullptr);
+
+    struct itimerval timer;
+    timer.it_interval.tv_sec  = intervalMicros/1000000;
+    timer.it_interval.tv_usec = intervalMicros%1000000;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, nullptr);
+}
+
+void SamplingProfiler::stop()
+{
+    struct itimerval timer = {};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    signal(SIGPROF, SIG_IGN);
+
+    active = nullptr;
+    drain();
+}
+
+void SamplingProfiler::handler(int)
+{
+    if (active != nullptr) active->sample();
+}
+
+void SamplingProfiler::sample()
+{
+    // Runs in the signal handler: no allocation, no locks.
+    unsigned h = head.load(memory_order_relaxed);
+    if (h - tail.load(memory_order_acquire) >= (unsigned) RING_SIZE)
+    {
+        dropped = dropped + 1;
+        return;
+    }
+
+    atomic_signal_fence(memory_order_acquire);
+
+    Sample &slot = ring[h & (RING_SIZE - 1)];
+    int d = top();
+    slot.depth = d;
+    for (int i = 0; i <= d; i++) slot.frames[i] = frames[i];
+
+    head.store(h + 1, memory_order_release);
+}
+
+void SamplingProfiler::drain()
+{
+    unsigned t = tail.load(memory_order_relaxed);
+    unsigned h = head.load(memory_order_acquire);
+
+    for (; t != h; t++)
+    {
+        Sample &slot = ring[t & (RING_SIZE - 1)];
+
+        // Root, then each enclosing loop, then the executing line.
+        string stack = programName;
+        for (int i = 1; i <= slot.depth; i++)
+        {
+            stack += ";" + FRAME_KIND_STRINGS[(int) slot.frames[i].kind]
+                   + " line " + to_string(slot.frames[i].header);
+        }
+        stack += ";line " + to_string(slot.frames[slot.depth].line);
+
+        folded[stack]++;
+    }
+
+    tail.store(t, memory_order_release);
+}
+
+void SamplingProfiler::writeFolded(ostream &out)
+{
+    drain();
+    for (auto &entry : folded)
+    {
+        out << entry.first << " " << entry.second << endl;
+    }
+}
+
+}}  // namespace backend::interpreter
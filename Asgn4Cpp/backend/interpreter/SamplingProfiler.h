@@ -0,0 +1,153 @@
+/**
+ * <h1>SamplingProfiler</h1>
+ *
+ * <p>Statement-level sampling profiler for the interpreter.
+ * The executor keeps a shadow stack of the executing loops and the
+ * current source line. A SIGPROF timer samples that stack into a
+ * lock-free ring buffer, and the samples are written in folded-stack
+ * format for flame graph tools.</p>
+ *
+ * <p>Copyright (c) 2020 by Ronald Mak</p>
+ * <p>For instructional purposes only.  No warranties.</p>
+ */
+#ifndef SAMPLINGPROFILER_H_
+#define SAMPLINGPROFILER_H_
+
+#include <string>
+#include <map>
+#include <atomic>
+#include <iostream>
+#include <csignal>
+
+namespace backend { namespace interpreter {
+
+using namespace std;
+
+enum class FrameKind
+{
+    PROGRAM, WHILE, REPEAT, FOR
+};
+
+static const string FRAME_KIND_STRINGS[] =
+{
+    "program", "while", "repeat", "for"
+};
+
+class SamplingProfiler
+{
+public:
+    static const int MAX_DEPTH = 32;    // deeper loops share the top frame
+    static const int RING_SIZE = 1024;  // must be a power of 2
+
+    /**
+     * Constructor.
+     * @param programName the name for the stack root.
+     * @param intervalMicros the sampling interval in microseconds.
+     */
+    SamplingProfiler(string programName, int intervalMicros = 1000);
+    ~SamplingProfiler();
+
+    /**
+     * Start the sampling timer.
+     */
+    void start();
+
+    /**
+     * Stop the sampling timer and collect the remaining samples.
+     */
+    void stop();
+
+    /**
+     * Record the line of the statement about to execute.
+     * @param line the source line number.
+     */
+    void setLine(int line)
+    {
+        frames[top()].line = line;
+        if (pending() > RING_SIZE/2) drain();
+    }
+
+    /**
+     * Enter a loop.
+     * @param kind the kind of loop.
+     * @param line the source line number of the loop statement.
+     */
+    void pushLoop(FrameKind kind, int line)
+    {
+        int d = depth + 1;
+        if (d < MAX_DEPTH)
+        {
+            frames[d].kind = kind;
+            frames[d].header = line;
+            frames[d].line = line;
+        }
+
+        atomic_signal_fence(memory_order_release);
+        depth = d;
+    }
+
+    /**
+     * Leave a loop.
+     */
+    void popLoop() { depth = depth - 1; }
+
+    /**
+     * Write the aggregated samples in folded-stack format:
+     * one "frame;frame;...;leaf count" line per distinct stack.
+     * @param out the output stream.
+     */
+    void writeFolded(ostream &out);
+
+    /**
+     * Getter.
+     * @return the number of samples dropped because the ring was full.
+     */
+    unsigned long getDroppedCount() const { return dropped; }
+
+private:
+    struct Frame
+    {
+        FrameKind kind;
+        int header;  // line of the loop statement
+        int line;    // line of the statement executing in the loop
+    };
+
+    struct Sample
+    {
+        int depth;
+        Frame frames[MAX_DEPTH];
+    };
+
+    static SamplingProfiler *active;  // the profiler the signal samples
+
+    string programName;
+    int intervalMicros;
+
+    Frame frames[MAX_DEPTH];   // the shadow stack
+    volatile sig_atomic_t depth;
+
+    // Single producer (the signal handler), single consumer (drain).
+    Sample ring[RING_SIZE];
+    atomic<unsigned> head;
+    atomic<unsigned> tail;
+    volatile unsigned long dropped;
+
+    map<string, unsigned long> folded;  // stack -> sample count
+
+    int top() const { return depth < MAX_DEPTH ? depth : MAX_DEPTH - 1; }
+
+    unsigned pending() const
+    {
+        return head.load(memory_order_relaxed)
+             - tail.load(memory_order_relaxed);
+    }
+
+    static void handler(int signal);
+
+    void sample();
+    void drain();
+};
+
+}}  // namespace backend::interpreter
+
+#endif /* SAMPLINGPROFILER_H_ */
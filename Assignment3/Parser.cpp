@@ -17,10 +17,9 @@ using namespace std;
 
 set<TokenType> Parser::statementStarters;
 set<TokenType> Parser::statementFollowers;
-set<TokenType> Parser::relationalOperators;
-set<TokenType> Parser::simpleExpressionOperators;
-set<TokenType> Parser::termOperators;
 set<TokenType> Parser::factorOperators;
+int Parser::precedences[TOKEN_TYPES];
+NodeType Parser::operatorNodes[TOKEN_TYPES];
 
 void Parser::initialize() {
 	// Tokens that can start a statement.
@@ -39,15 +38,22 @@ void Parser::initialize() {
 	statementFollowers.insert(UNTIL);
 	statementFollowers.insert(END_OF_FILE);
 
-	relationalOperators.insert(EQUALS);
-	relationalOperators.insert(LESS_THAN);
-	relationalOperators.insert(GREATER_THAN);
-
-	simpleExpressionOperators.insert(PLUS);
-	simpleExpressionOperators.insert(MINUS);
-
-	termOperators.insert(STAR);
-	termOperators.insert(SLASH);
+	// Binary operators. Every other token type has NO_OPERATOR.
+	precedences[(int) EQUALS] = RELATIONAL;
+	precedences[(int) LESS_THAN] = RELATIONAL;
+	precedences[(int) GREATER_THAN] = RELATIONAL;
+	precedences[(int) PLUS] = ADDITIVE;
+	precedences[(int) MINUS] = ADDITIVE;
+	precedences[(int) STAR] = MULTIPLICATIVE;
+	precedences[(int) SLASH] = MULTIPLICATIVE;
+
+	operatorNodes[(int) EQUALS] = EQ;
+	operatorNodes[(int) LESS_THAN] = LT;
+	operatorNodes[(int) GREATER_THAN] = GT;
+	operatorNodes[(int) PLUS] = ADD;
+	operatorNodes[(int) MINUS] = SUBTRACT;
+	operatorNodes[(int) STAR] = MULTIPLY;
+	operatorNodes[(int) SLASH] = DIVIDE;
 
 	factorOperators.insert(TokenType::NOT);
 	factorOperators.insert(TokenType::IF);
@@ -495,108 +501,99 @@ if (currentToken->type == RPAREN) {
 }
 
 Node *Parser::parseExpression() {
-// The current token should now be an identifier or a number.
-
-// The expression's root node->
-Node *exprNode = parseSimpleExpression();
-
-// The current token might now be a relational operator.
-if (relationalOperators.find(currentToken->type) != relationalOperators.end()) {
-	TokenType tokenType = currentToken->type;
-	Node *opNode = tokenType == EQUALS ? new Node(EQ) :
-					tokenType == LESS_THAN ? new Node(LT) : nullptr;
-
-	currentToken = scanner->nextToken();  // consume relational operator
-
-	// The relational operator node adopts the first simple expression
-	// node as its first child and the second simple expression node
-	// as its second child. Then it becomes the expression's root node.
-	if (opNode != nullptr) {
-		opNode->adopt(exprNode);
-		opNode->adopt(parseSimpleExpression());
-		exprNode = opNode;
-	}
-}
-
-return exprNode;
-}
-
-Node *Parser::parseSimpleExpression() {
-// The current token should now be an identifier or a number.
-
-// The simple expression's root node->
-Node *simpExprNode = parseTerm();
+	// The current token should now be an identifier, a number or (
+	//
+	// Parse by operator precedence with explicit operand and operator
+	// stacks, so the native stack stays flat however deeply the
+	// expression nests. Each ( is pushed onto the operator stack as a
+	// marker that has NO_OPERATOR precedence, so nothing reduces past it.
+
+	vector<Node *> operands;
+	vector<TokenType> operators;
+	int openCount = 0;  // unmatched ( markers on the operator stack
+
+	while (true) {
+		while (currentToken->type == LPAREN) {
+			operators.push_back(LPAREN);
+			openCount++;
+			currentToken = scanner->nextToken();  // consume (
+		}
 
-// Keep parsing more terms as long as the current token
-// is a + or - operator.
-while (simpleExpressionOperators.find(currentToken->type)
-		!= simpleExpressionOperators.end()) {
-	Node *opNode =
-			currentToken->type == PLUS ? new Node(ADD) : new Node(SUBTRACT);
+		operands.push_back(parseOperand());
 
-	currentToken = scanner->nextToken();  // consume the operator
+		// Close any parenthesized subexpressions that end here.
+		while ((currentToken->type == RPAREN) && (openCount > 0)) {
+			while (operators.back() != LPAREN)
+				reduce(operands, operators);
+			operators.pop_back();
+			openCount--;
+			currentToken = scanner->nextToken();  // consume )
+		}
 
-	// The add or subtract node adopts the first term node as its
-	// first child and the next term node as its second child.
-	// Then it becomes the simple expression's root node.
-	opNode->adopt(simpExprNode);
-	opNode->adopt(parseTerm());
-	simpExprNode = opNode;
-}
+		TokenType tokenType = currentToken->type;
+		int precedence = precedences[(int) tokenType];
+		if (precedence == NO_OPERATOR)
+			break;
 
-return simpExprNode;
-}
+		// Reduce the pending operators that bind at least as tightly.
+		while (!operators.empty()
+				&& (precedences[(int) operators.back()] > precedence)) {
+			reduce(operands, operators);
+		}
 
-Node *Parser::parseTerm() {
-// The current token should now be an identifier or a number.
+		// A second relational operator ends the expression.
+		if ((precedence == RELATIONAL) && !operators.empty()
+				&& (precedences[(int) operators.back()] == RELATIONAL)) {
+			break;
+		}
 
-// The term's root node->
-Node *termNode = parseFactor();
+		while (!operators.empty()
+				&& (precedences[(int) operators.back()] == precedence)) {
+			reduce(operands, operators);
+		}
 
-// Keep parsing more factors as long as the current token
-// is a * or / operator.
-while (termOperators.find(currentToken->type) != termOperators.end()) {
-	Node *opNode =
-			currentToken->type == STAR ? new Node(MULTIPLY) : new Node(DIVIDE);
+		operators.push_back(tokenType);
+		currentToken = scanner->nextToken();  // consume the operator
+	}
 
-	currentToken = scanner->nextToken();  // consume the operator
+	// Reduce what remains. Each unmatched ( is an error.
+	while (!operators.empty()) {
+		if (operators.back() == LPAREN) {
+			operators.pop_back();
+			syntaxError("Expecting )");
+		} else
+			reduce(operands, operators);
+	}
 
-	// The multiply or divide node adopts the first factor node as its
-	// as its first child and the next factor node as its second child.
-	// Then it becomes the term's root node.
-	opNode->adopt(termNode);
-	opNode->adopt(parseFactor());
-	termNode = opNode;
+	return operands.back();
 }
 
-return termNode;
+void Parser::reduce(vector<Node *> &operands, vector<TokenType> &operators) {
+	// The operator node adopts the two topmost operands
+	// and replaces them on the operand stack.
+	Node *opNode = new Node(operatorNodes[(int) operators.back()]);
+	operators.pop_back();
+
+	Node *rhsNode = operands.back();
+	operands.pop_back();
+	opNode->adopt(operands.back());
+	opNode->adopt(rhsNode);
+	operands.back() = opNode;
 }
 
-Node *Parser::parseFactor() {
-// The current token should now be an identifier or a number or (
-
-if (currentToken->type == IDENTIFIER)
-	return parseVariable();
-else if (currentToken->type == INTEGER)
-	return parseIntegerConstant();
-else if (currentToken->type == REAL)
-	return parseRealConstant();
+Node *Parser::parseOperand() {
+	// The current token should now be an identifier or a number.
 
-else if (currentToken->type == LPAREN) {
-	currentToken = scanner->nextToken();  // consume (
-	Node *exprNode = parseExpression();
-
-	if (currentToken->type == RPAREN) {
-		currentToken = scanner->nextToken();  // consume )
-	} else
-		syntaxError("Expecting )");
+	if (currentToken->type == IDENTIFIER)
+		return parseVariable();
+	else if (currentToken->type == INTEGER)
+		return parseIntegerConstant();
+	else if (currentToken->type == REAL)
+		return parseRealConstant();
 
-	return exprNode;
-}
-
-else
-	syntaxError("Unexpected token");
-return nullptr;
+	else
+		syntaxError("Unexpected token");
+	return nullptr;
 }
 
 Node *Parser::parseVariable() {
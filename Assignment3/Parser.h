@@ -9,6 +9,7 @@
 #define PARSER_H_
 
 #include <set>
+#include <vector>
 
 #include "Scanner.h"
 #include "Token.h"
@@ -31,11 +32,20 @@ private:
 
     static set<TokenType> statementStarters;          // what starts a statement
     static set<TokenType> statementFollowers;         // what follows a statement
-    static set<TokenType> relationalOperators;        // relational operators
-    static set<TokenType> simpleExpressionOperators;  // simple expression operators
-    static set<TokenType> termOperators;              // term operators
     static set<TokenType> factorOperators;			  // factor operators (but this is just NOT)
 
+    // Binary operator precedence levels. Relational operators don't
+    // associate: an expression has at most one at each nesting level.
+    static const int NO_OPERATOR    = 0;
+    static const int RELATIONAL     = 1;
+    static const int ADDITIVE       = 2;
+    static const int MULTIPLICATIVE = 3;
+
+    static const int TOKEN_TYPES = (int) TokenType::ERROR + 1;  // ERROR is last
+
+    static int precedences[TOKEN_TYPES];          // by token type
+    static NodeType operatorNodes[TOKEN_TYPES];   // by token type
+
 public:
     /**
      * Initialize the static sets.
@@ -63,9 +73,7 @@ private:
     Node *parseWriteStatement();
     Node *parseWritelnStatement();
     Node *parseExpression();
-    Node *parseSimpleExpression();
-    Node *parseTerm();
-    Node *parseFactor();
+    Node *parseOperand();
     Node *parseVariable();
     Node *parseIntegerConstant();
     Node *parseRealConstant();
@@ -73,6 +81,7 @@ private:
 
     void parseStatementList(Node *parentNode, TokenType terminalType);
     void parseWriteArguments(Node *node);
+    void reduce(vector<Node *> &operands, vector<TokenType> &operators);
 
     void syntaxError(string message);
     void semanticError(string message);
@@ -4,13 +4,37 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
-../src/backend/Executor.cpp 
+../src/backend/ExecutionProfile.cpp \
+../src/backend/Executor.cpp \
+../src/backend/Jit.cpp \
+../src/backend/LaneExecutor.cpp \
+../src/backend/Optimizer.cpp \
+../src/backend/Profiler.cpp \
+../src/backend/Specializer.cpp \
+../src/backend/Superinstructions.cpp \
+../src/backend/VirtualMachine.cpp 
 
 OBJS += \
-./src/backend/Executor.o 
+./src/backend/ExecutionProfile.o \
+./src/backend/Executor.o \
+./src/backend/Jit.o \
+./src/backend/LaneExecutor.o \
+./src/backend/Optimizer.o \
+./src/backend/Profiler.o \
+./src/backend/Specializer.o \
+./src/backend/Superinstructions.o \
+./src/backend/VirtualMachine.o 
 
 CPP_DEPS += \
-./src/backend/Executor.d 
+./src/backend/ExecutionProfile.d \
+./src/backend/Executor.d \
+./src/backend/Jit.d \
+./src/backend/LaneExecutor.d \
+./src/backend/Optimizer.d \
+./src/backend/Profiler.d \
+./src/backend/Specializer.d \
+./src/backend/Superinstructions.d \
+./src/backend/VirtualMachine.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
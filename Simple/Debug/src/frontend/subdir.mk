@@ -4,16 +4,25 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
+../src/frontend/CharClass.cpp \
+../src/frontend/CodeParser.cpp \
 ../src/frontend/Parser.cpp \
-../src/frontend/Token.cpp 
+../src/frontend/Token.cpp \
+../src/frontend/TypeChecker.cpp 
 
 OBJS += \
+./src/frontend/CharClass.o \
+./src/frontend/CodeParser.o \
 ./src/frontend/Parser.o \
-./src/frontend/Token.o 
+./src/frontend/Token.o \
+./src/frontend/TypeChecker.o 
 
 CPP_DEPS += \
+./src/frontend/CharClass.d \
+./src/frontend/CodeParser.d \
 ./src/frontend/Parser.d \
-./src/frontend/Token.d 
+./src/frontend/Token.d \
+./src/frontend/TypeChecker.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -4,12 +4,18 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
+../src/intermediate/Allocator.cpp \
+../src/intermediate/CodeImage.cpp \
 ../src/intermediate/ParseTreePrinter.cpp 
 
 OBJS += \
+./src/intermediate/Allocator.o \
+./src/intermediate/CodeImage.o \
 ./src/intermediate/ParseTreePrinter.o 
 
 CPP_DEPS += \
+./src/intermediate/Allocator.d \
+./src/intermediate/CodeImage.d \
 ./src/intermediate/ParseTreePrinter.d 
 
 
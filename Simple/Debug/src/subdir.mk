@@ -4,13 +4,22 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
-../src/Simple.cpp 
+../src/BatchRunner.cpp \
+../src/Server.cpp \
+../src/Simple.cpp \
+../src/Stats.cpp 
 
 OBJS += \
-./src/Simple.o 
+./src/BatchRunner.o \
+./src/Server.o \
+./src/Simple.o \
+./src/Stats.o 
 
 CPP_DEPS += \
-./src/Simple.d 
+./src/BatchRunner.d \
+./src/Server.d \
+./src/Simple.d \
+./src/Stats.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -0,0 +1,143 @@
+/**
+ * Batch runner class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <atomic>
+
+#include "frontend/Source.h"
+#include "frontend/Scanner.h"
+#include "frontend/TokenBuffer.h"
+#include "frontend/Parser.h"
+#include "intermediate/Arena.h"
+#include "intermediate/Symtab.h"
+#include "intermediate/Node.h"
+#include "intermediate/CodeImage.h"
+#include "backend/Executor.h"
+#include "backend/Superinstructions.h"
+#include "backend/Specializer.h"
+#include "backend/VirtualMachine.h"
+#include "BatchRunner.h"
+#include "WorkerThread.h"
+
+using namespace std;
+using namespace frontend;
+using namespace intermediate;
+using namespace backend;
+
+BatchRunner::BatchRunner(int threadCount) : threadCount(threadCount)
+{
+    if (this->threadCount <= 0) this->threadCount = thread::hardware_concurrency();
+    if (this->threadCount <= 0) this->threadCount = 1;
+}
+
+vector<BatchResult> BatchRunner::run(const vector<string> &sourceFileNames)
+{
+    vector<BatchResult> results(sourceFileNames.size());
+    atomic<size_t> nextIndex(0);
+
+    // Each worker claims the next unclaimed program until none are left.
+    auto worker = [&]()
+    {
+        for (size_t i = nextIndex++; i < sourceFileNames.size(); i = nextIndex++)
+        {
+            const string &name = sourceFileNames[i];
+            ifstream source(name);
+
+            if (source.fail())
+            {
+                results[i] = { name, "*** ERROR: Failed to open " + name + "\n",
+                               COMPILE_ERROR_STATUS };
+            }
+            else
+            {
+                stringstream contents;
+                contents << source.rdbuf();
+                results[i] = runProgram(name, contents.str());
+            }
+        }
+    };
+
+    vector<WorkerThread> threads;
+    int count = min((size_t) threadCount, sourceFileNames.size());
+
+    for (int t = 0; t < count; t++) threads.push_back(WorkerThread(worker));
+    for (WorkerThread &t : threads) t.join();
+
+    return results;
+}
+
+BatchResult BatchRunner::runProgram(string name, string text)
+{
+    ostringstream output;
+    BatchResult result = { name, "", 0 };
+
+    {
+        // The compilation session. The arena releases the program's nodes,
+        // symbol table and entries all at once, without destroying them.
+        Arena session;
+        Source source(name, text);
+        source.setOutput(&output);
+
+        Scanner scanner(&source);
+        TokenBuffer *tokens = scanner.scanAll();
+        Symtab *symtab = new Symtab();
+        Parser parser(tokens, symtab);
+
+        Node *programNode = parser.parseProgram();
+        int errorCount = parser.getErrorCount() + parser.checkDepth();
+
+        if (errorCount == 0)
+        {
+            Superinstructions(symtab).fuse(programNode);
+            Specializer(symtab).specialize(programNode);
+
+            Executor executor(symtab);
+            executor.setLineMap(source.lines());
+            executor.setOutput(&output);
+            result.status = executor.execute(programNode);
+        }
+        else
+        {
+            output << endl << "There were " << errorCount << " errors." << endl;
+            result.status = COMPILE_ERROR_STATUS;
+        }
+
+        delete tokens;
+    }
+
+    result.output = output.str();
+    return result;
+}
+
+BatchResult BatchRunner::runImage(string name, const string &bytes)
+{
+    ostringstream output;
+    BatchResult result = { name, "", 0 };
+
+    CodeImage *image = CodeImage::wrap(bytes.data(), bytes.size());
+    if (image == nullptr)
+    {
+        result.output = "*** ERROR: " + name
+                      + " is not a compatible program image\n";
+        result.status = COMPILE_ERROR_STATUS;
+        return result;
+    }
+
+    {
+        VirtualMachine machine(image);
+        machine.setOutput(&output);
+        result.status = machine.run();
+    }
+
+    delete image;
+    result.output = output.str();
+    return result;
+}
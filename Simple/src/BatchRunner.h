@@ -0,0 +1,70 @@
+/**
+ * Batch runner class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef BATCHRUNNER_H_
+#define BATCHRUNNER_H_
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * The outcome of running one program.
+ */
+struct BatchResult
+{
+    string name;    // the program's source file name
+    string output;  // everything it printed, including error messages
+    int status;     // 0, COMPILE_ERROR_STATUS or RuntimeError::STATUS
+};
+
+/**
+ * Runs many Simple programs concurrently in one process on a pool of
+ * threads. Each program gets its own source, scanner, parser, symbol
+ * table, executor and output buffer, and its nodes and symbol table
+ * entries come from an arena that is released when the program ends.
+ */
+class BatchRunner
+{
+private:
+    int threadCount;
+
+public:
+    static const int COMPILE_ERROR_STATUS = -1;
+
+    /**
+     * Constructor.
+     * @param threadCount the number of threads, or 0 for one per core.
+     */
+    BatchRunner(int threadCount);
+
+    /**
+     * Run programs from source files.
+     * @param sourceFileNames the source file names.
+     * @return the results, in the same order as the names.
+     */
+    vector<BatchResult> run(const vector<string> &sourceFileNames);
+
+    /**
+     * Parse and execute one program on the calling thread.
+     * @param name the source name.
+     * @param text the source text.
+     * @return the result.
+     */
+    static BatchResult runProgram(string name, string text);
+
+    /**
+     * Run one precompiled program image on the calling thread.
+     * @param name the image name.
+     * @param bytes the image, which must stay alive while it runs.
+     * @return the result, with COMPILE_ERROR_STATUS if the image isn't valid.
+     */
+    static BatchResult runImage(string name, const string &bytes);
+};
+
+#endif /* BATCHRUNNER_H_ */
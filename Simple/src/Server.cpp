@@ -0,0 +1,305 @@
+/**
+ * Server class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "BatchRunner.h"
+#include "Server.h"
+#include "WorkerThread.h"
+
+using namespace std;
+
+static const size_t MAX_HEADER  = 1024;
+static const size_t MAX_PAYLOAD = 64*1024*1024;
+
+// Set by SIGINT or SIGTERM to stop accepting connections.
+static volatile sig_atomic_t stopping = 0;
+
+static void stop(int) { stopping = 1; }
+
+/**
+ * Buffered reads of header lines and payloads from a file descriptor.
+ */
+class FrameReader
+{
+private:
+    int fd;
+    char buffer[64*1024];
+    size_t start, end;  // the unread bytes in the buffer
+
+    bool fill()
+    {
+        start = end = 0;
+        for (;;)
+        {
+            ssize_t count = ::read(fd, buffer, sizeof(buffer));
+            if (count > 0)
+            {
+                end = count;
+                return true;
+            }
+            if ((count < 0) && (errno == EINTR)) continue;
+            return false;
+        }
+    }
+
+public:
+    FrameReader(int fd) : fd(fd), start(0), end(0) {}
+
+    /**
+     * Read a line without its newline.
+     * @param line set to the line.
+     * @return false at end of file or if the line is too long.
+     */
+    bool readLine(string &line)
+    {
+        line.clear();
+        for (;;)
+        {
+            if ((start == end) && !fill()) return false;
+
+            char *newline = (char *) memchr(buffer + start, '\n', end - start);
+            size_t lineEnd = newline != nullptr ? newline - buffer : end;
+
+            line.append(buffer + start, lineEnd - start);
+            start = lineEnd;
+            if (line.size() > MAX_HEADER) return false;
+
+            if (newline != nullptr)
+            {
+                start++;
+                return true;
+            }
+        }
+    }
+
+    /**
+     * Read exactly count bytes.
+     * @param count the count.
+     * @param bytes set to the bytes.
+     * @return false if the stream ended first.
+     */
+    bool read(size_t count, string &bytes)
+    {
+        bytes.clear();
+        bytes.reserve(count);
+        while (bytes.size() < count)
+        {
+            if ((start == end) && !fill()) return false;
+
+            size_t length = min(end - start, count - bytes.size());
+            bytes.append(buffer + start, length);
+            start += length;
+        }
+
+        return true;
+    }
+};
+
+/**
+ * Write all the bytes to a file descriptor.
+ * @param fd the file descriptor.
+ * @param bytes the bytes.
+ * @return false if the write failed, such as when the client went away.
+ */
+static bool writeAll(int fd, const string &bytes)
+{
+    for (size_t done = 0; done < bytes.size(); )
+    {
+        ssize_t count = ::write(fd, bytes.data() + done, bytes.size() - done);
+        if (count > 0) done += count;
+        else if ((count < 0) && (errno == EINTR)) continue;
+        else return false;
+    }
+
+    return true;
+}
+
+Server::Server() : requestCount(0)
+{
+    latencies.reserve(WINDOW);
+
+    // A client that goes away makes a write fail instead of killing us.
+    signal(SIGPIPE, SIG_IGN);
+
+    // Run a tiny program once so that the first real request doesn't pay
+    // for faulting in the code, the allocator and the output streams.
+    BatchRunner::runProgram("warmup",
+                            "PROGRAM Warmup; BEGIN i := 1; WRITE(i) END.");
+}
+
+void Server::serveStream(int in, int out)
+{
+    FrameReader reader(in);
+    string line, payload;
+
+    while (reader.readLine(line))
+    {
+        istringstream header(line);
+        string kind, name;
+        size_t length = 0;
+
+        header >> kind;
+
+        if (kind == "quit") break;
+        if (kind == "stats")
+        {
+            string text = statistics();
+            if (!writeAll(out, "0 " + to_string(text.size()) + "\n" + text))
+            {
+                break;
+            }
+            continue;
+        }
+
+        // Anything but a well-formed source or image request leaves
+        // no way to find the next request, so close the connection.
+        if (   ((kind != "source") && (kind != "image"))
+            || !(header >> name >> length)
+            || (length > MAX_PAYLOAD))
+        {
+            string text = "*** ERROR: Invalid request: " + line + "\n";
+            writeAll(out, to_string(BatchRunner::COMPILE_ERROR_STATUS) + " "
+                          + to_string(text.size()) + "\n" + text);
+            break;
+        }
+
+        if (!reader.read(length, payload)) break;
+
+        auto start = chrono::steady_clock::now();
+        BatchResult result = handle(kind, name, payload);
+        record(chrono::duration_cast<chrono::microseconds>(
+                            chrono::steady_clock::now() - start).count());
+
+        if (!writeAll(out, to_string(result.status) + " "
+                           + to_string(result.output.size()) + "\n"
+                           + result.output))
+        {
+            break;
+        }
+    }
+}
+
+int Server::serveSocket(string socketPath)
+{
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (socketPath.size() >= sizeof(address.sun_path))
+    {
+        cerr << "*** ERROR: Socket path is too long: " << socketPath << endl;
+        return -1;
+    }
+    strcpy(address.sun_path, socketPath.c_str());
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socketPath.c_str());  // left behind by an earlier server
+
+    if (   (listener < 0)
+        || (bind(listener, (sockaddr *) &address, sizeof(address)) < 0)
+        || (listen(listener, SOMAXCONN) < 0))
+    {
+        cerr << "*** ERROR: Failed to listen on " << socketPath
+             << ": " << strerror(errno) << endl;
+        if (listener >= 0) close(listener);
+        return -1;
+    }
+
+    // Interrupt accept() rather than restart it, so that the server
+    // can report its statistics and remove the socket.
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stop;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    cerr << "Serving on " << socketPath << endl;
+
+    while (!stopping)
+    {
+        int connection = accept(listener, nullptr, nullptr);
+        if (connection < 0)
+        {
+            if (errno == EINTR) continue;
+
+            cerr << "*** ERROR: accept failed: " << strerror(errno) << endl;
+            break;
+        }
+
+        WorkerThread([this, connection]()
+        {
+            serveStream(connection, connection);
+            close(connection);
+        }).detach();
+    }
+
+    close(listener);
+    unlink(socketPath.c_str());
+
+    cerr << statistics();
+    return 0;
+}
+
+string Server::statistics()
+{
+    vector<long> sorted;
+    long count;
+    {
+        lock_guard<mutex> guard(latencyLock);
+        sorted = latencies;
+        count = requestCount;
+    }
+
+    ostringstream text;
+    text << "Requests: " << count << endl;
+    if (sorted.empty()) return text.str();
+
+    sort(sorted.begin(), sorted.end());
+
+    // The nearest-rank percentile.
+    auto percentile = [&sorted](int p)
+    {
+        size_t rank = (sorted.size()*p + 99)/100;
+        return sorted[max(rank, (size_t) 1) - 1];
+    };
+
+    text << "Latency (microseconds) over the last " << sorted.size()
+         << " requests:" << endl
+         << "    p50 " << percentile(50)
+         << "  p90 " << percentile(90)
+         << "  p99 " << percentile(99)
+         << "  max " << sorted.back() << endl;
+    return text.str();
+}
+
+BatchResult Server::handle(string kind, string name, const string &payload)
+{
+    return kind == "image" ? BatchRunner::runImage(name, payload)
+                           : BatchRunner::runProgram(name, payload);
+}
+
+void Server::record(long microseconds)
+{
+    lock_guard<mutex> guard(latencyLock);
+
+    if (latencies.size() < WINDOW) latencies.push_back(microseconds);
+    else latencies[requestCount%WINDOW] = microseconds;
+    requestCount++;
+}
@@ -0,0 +1,77 @@
+/**
+ * Server class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef SERVER_H_
+#define SERVER_H_
+
+#include <string>
+#include <vector>
+#include <mutex>
+
+#include "BatchRunner.h"
+
+using namespace std;
+
+/**
+ * A long-lived interpreter that runs programs sent to it, so that each
+ * one skips process startup and finds the static tables, allocator and
+ * code already warm. It reads framed requests from a stream, such as
+ * standard input, or from the connections to a Unix domain socket.
+ *
+ * Each request is a header line and then exactly length bytes:
+ *
+ *     source <name> <length>    Simple source text to parse and execute
+ *     image <name> <length>     a precompiled program image to run
+ *     stats                     request latency percentiles
+ *     quit                      close the connection
+ *
+ * and each response is a header line and then exactly length bytes:
+ *
+ *     <status> <length>         the program's output, or the statistics
+ *
+ * Every program runs in its own arena with its own output buffer,
+ * as in a batch.
+ */
+class Server
+{
+private:
+    static const int WINDOW = 65536;  // latencies kept for the percentiles
+
+    mutex latencyLock;
+    vector<long> latencies;  // in microseconds, a ring of the latest
+    long requestCount;
+
+public:
+    Server();
+
+    /**
+     * Serve the requests on a pair of file descriptors until end of file.
+     * @param in the descriptor to read requests from.
+     * @param out the descriptor to write responses to.
+     */
+    void serveStream(int in, int out);
+
+    /**
+     * Listen on a Unix domain socket and serve each connection on its
+     * own thread until the server is interrupted or terminated.
+     * @param socketPath the socket's path name.
+     * @return 0 after a clean shutdown, -1 if the socket failed.
+     */
+    int serveSocket(string socketPath);
+
+    /**
+     * Describe the request latencies.
+     * @return the request count and the latency percentiles.
+     */
+    string statistics();
+
+private:
+    BatchResult handle(string kind, string name, const string &payload);
+    void record(long microseconds);
+};
+
+#endif /* SERVER_H_ */
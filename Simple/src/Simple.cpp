@@ -7,13 +7,32 @@
  * San Jose State University
  */
 #include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
 
 #include "frontend/Source.h"
 #include "frontend/Scanner.h"
 #include "frontend/Parser.h"
+#include "frontend/CodeParser.h"
 #include "frontend/Token.h"
+#include "intermediate/Arena.h"
 #include "intermediate/ParseTreePrinter.h"
 #include "backend/Executor.h"
+#include "backend/ExecutionProfile.h"
+#include "backend/Jit.h"
+#include "backend/LaneExecutor.h"
+#include "backend/Optimizer.h"
+#include "backend/Profiler.h"
+#include "backend/Superinstructions.h"
+#include "backend/Specializer.h"
+#include "backend/VirtualMachine.h"
+#include "BatchRunner.h"
+#include "Server.h"
+#include "Stats.h"
 
 using namespace std;
 using namespace frontend;
@@ -21,30 +40,131 @@ using namespace intermediate;
 using namespace backend;
 
 void testScanner(Source *source);
-void testParser(Scanner *scanner, Symtab *symtab);
-void executeProgram(Parser *parser, Symtab *symtab);
+Parser *createParser(Source *source, Symtab *symtab, bool stream);
+void testParser(Parser *parser, int treeFormat);
+int executeProgram(Parser *parser, Symtab *symtab, bool jit,
+                   int optimization, bool dumpOptimization, int treeFormat,
+                   string recordFileName, string profileFileName);
+int executeLanes(Source *source, Symtab *symtab, string csvFileName);
+CodeParser *createCodeParser(Source *source, Symtab *symtab, bool stream);
+void testCodeParser(CodeParser *parser);
+int runCode(CodeParser *parser);
+int precompileProgram(CodeParser *parser, string sourceFileName);
+int runImage(string imageFileName);
+int runBatch(string listFileName, int threadCount);
+int serve(string socketPath);
+void profileProgram(Parser *parser, Symtab *symtab, string sourceFileName);
+void phase(string name);
+void countParse(int tokenCount, Node *programNode);
+long countNodes(Node *node);
+
+Stats *stats = nullptr;  // null unless -stats
 
 int main(int argc, char *argv[])
 {
-    if (argc != 3)
+    if (argc < 3)
     {
-        cout << "Usage: simple -{scan, parse, execute} sourceFileName" << endl;
-        //exit(-1);
+        cout << "Usage: simple [-stream] [-bytecode] [-jit] [-lanes csvFileName] "
+             << "[-O{0, 1, 2, 3}] [-dump-opt] [-tree {xml, json, binary}] "
+             << "[-stats {text, json}] "
+             << "[-record-profile fileName] [-use-profile fileName] "
+             << "-{scan, parse, execute, profile, precompile} sourceFileName"
+             << endl
+             << "       simple -run imageFileName" << endl
+             << "       simple [-threads count] -batch listFileName" << endl
+             << "       simple -serve {socketPath, -}" << endl;
+        exit(-1);
     }
 
-    Token::initialize();
-    Parser::initialize();
-    Executor::initialize();
+    // An image runs without its source, so nothing else needs setting up.
+    if (string(argv[argc - 2]) == "-run") return runImage(argv[argc - 1]);
+    if (string(argv[argc - 2]) == "-serve") return serve(argv[argc - 1]);
+
+    // Options precede the operation and the source file name.
+    bool stream = false;    // parse tokens as they're scanned
+    bool bytecode = false;  // compile to code while parsing, no parse tree
+    bool jit = false;       // compile the parse tree to machine code
+    int threadCount = 0;    // batch threads, or 0 for one per core
+    string csvFileName;     // initial values to execute with, one run per row
+    int optimization = Optimizer::NONE;  // level of the parse tree optimizations
+    bool dumpOptimization = false;       // print the tree before and after
+    int treeFormat = ParseTreePrinter::XML;  // how to print a parse tree
+    int statsFormat = -1;   // Stats::TEXT or JSON, or -1 for no statistics
+    string recordFileName;  // execution profile to record into
+    string profileFileName; // execution profile to tune by
+    for (int i = 1; i < argc - 2; i++)
+    {
+        string option = argv[i];
+
+        if      (option == "-stream")   stream = true;
+        else if (option == "-bytecode") bytecode = true;
+        else if (option == "-jit")      jit = true;
+        else if (option == "-O0")       optimization = Optimizer::NONE;
+        else if (option == "-O1")       optimization = Optimizer::COMMON_SUBEXPRESSIONS;
+        else if (option == "-O2")       optimization = Optimizer::DEAD_STORES;
+        else if (option == "-O3")       optimization = Optimizer::LOOPS;
+        else if (option == "-dump-opt") dumpOptimization = true;
+        else if ((option == "-threads") && (i + 1 < argc - 2))
+        {
+            threadCount = stoi(argv[++i]);
+        }
+        else if ((option == "-lanes") && (i + 1 < argc - 2))
+        {
+            csvFileName = argv[++i];
+        }
+        else if ((option == "-tree") && (i + 1 < argc - 2))
+        {
+            string format = argv[++i];
+
+            if      (format == "xml")    treeFormat = ParseTreePrinter::XML;
+            else if (format == "json")   treeFormat = ParseTreePrinter::JSON;
+            else if (format == "binary") treeFormat = ParseTreePrinter::BINARY;
+            else cout << "*** Unknown tree format " << format << endl;
+        }
+        else if ((option == "-stats") && (i + 1 < argc - 2))
+        {
+            string format = argv[++i];
+
+            if      (format == "text") statsFormat = Stats::TEXT;
+            else if (format == "json") statsFormat = Stats::JSON;
+            else cout << "*** Unknown statistics format " << format << endl;
+        }
+        else if ((option == "-record-profile") && (i + 1 < argc - 2))
+        {
+            recordFileName = argv[++i];
+        }
+        else if ((option == "-use-profile") && (i + 1 < argc - 2))
+        {
+            profileFileName = argv[++i];
+        }
+        else cout << "*** Unknown option " << option << endl;
+    }
 
-    string operation      = argv[1];
-    string sourceFileName = argv[2];
+    string operation      = argv[argc - 2];
+    string sourceFileName = argv[argc - 1];
 
     //string operation      = "-scan";
     //string sourceFileName = "HelloWorld.txt";
     //string sourceFileName = "Newton.txt";
     //string sourceFileName = "ScannerTest.txt";
 
+    // The list names the source files, one per line.
+    if (operation == "-batch") return runBatch(sourceFileName, threadCount);
+
+    if (statsFormat >= 0)
+    {
+        Stats::countHeap();
+        Allocator::countAll();
+        stats = new Stats();
+    }
+
+    // The compilation session: the program's parse tree and symbol table.
+    Arena session;
+
+    phase("load");
     Source *source = new Source(sourceFileName);
+    Symtab *symtab = new Symtab();
+    int status = 0;
 
     if (operation == "-scan")
     {
@@ -52,15 +172,59 @@ int main(int argc, char *argv[])
     }
     else if (operation == "-parse")
     {
-        testParser(new Scanner(source), new Symtab());
+        if (bytecode) testCodeParser(createCodeParser(source, symtab, stream));
+        else          testParser(createParser(source, symtab, stream),
+                                 treeFormat);
     }
     else if (operation == "-execute")
     {
-        Symtab *symtab = new Symtab();
-        executeProgram(new Parser(new Scanner(source), symtab), symtab);
+        if (!csvFileName.empty())
+        {
+            status = executeLanes(source, symtab, csvFileName);
+        }
+        else if (bytecode)
+        {
+            status = runCode(createCodeParser(source, symtab, stream));
+        }
+        else
+        {
+            status = executeProgram(createParser(source, symtab, stream),
+                                    symtab, jit, optimization,
+                                    dumpOptimization, treeFormat,
+                                    recordFileName, profileFileName);
+        }
+    }
+    else if (operation == "-precompile")
+    {
+        status = precompileProgram(createCodeParser(source, symtab, stream),
+                                   sourceFileName);
+    }
+    else if (operation == "-profile")
+    {
+        profileProgram(createParser(source, symtab, stream), symtab,
+                       sourceFileName);
     }
 
-    return 0;
+    // After the program's output, and apart from it.
+    if (stats != nullptr)
+    {
+        stats->count("symtabEntries", symtab->size());
+
+        for (int i = 0; i < SUBSYSTEM_COUNT; i++)
+        {
+            AllocationCounts counts;
+            if (Allocator::get((Subsystem) i)->getCounts(counts))
+            {
+                stats->subsystem(SUBSYSTEM_STRINGS[i], counts.liveBytes,
+                                 counts.peakBytes, counts.allocationCount);
+            }
+        }
+
+        cout.flush();
+        stats->print(cerr, statsFormat);
+    }
+
+    return status;
 }
 
 /**
@@ -71,35 +235,66 @@ void testScanner(Source *source)
 {
     cout << "Tokens:" << endl << endl;
 
+    phase("scan");
     Scanner *scanner = new Scanner(source);  // create the scanner
 
     // Loop to extract and print each token from the source one at a time.
-    for (Token *token = scanner->nextToken();
-         token->type != END_OF_FILE;
-         token = scanner->nextToken())
+    Token *token = scanner->nextToken();
+    while (token->type != END_OF_FILE)
     {
         printf("%12s : %s\n",
                TOKEN_TYPE_STRINGS[(int) token->type].c_str(),
                token->text.c_str());
+
+        delete token;
+        token = scanner->nextToken();
     }
+    delete token;
+
+    if (stats != nullptr) stats->count("tokens", scanner->getTokenCount());
 }
 
 /**
- * Test the parser.
- * @param scanner the scanner.
+ * Create the parser.
+ * @param source the input source.
  * @param symtab the symbol table.
+ * @param stream true to parse tokens as they're scanned,
+ *               false to scan the entire source first.
+ * @return the parser.
  */
-void testParser(Scanner *scanner, Symtab *symtab)
+Parser *createParser(Source *source, Symtab *symtab, bool stream)
 {
-    Parser *parser = new Parser(scanner, symtab);  // create the parser
-    Node *programNode = parser->parseProgram();    // and parse the program
+    phase("scan");
+    Scanner *scanner = new Scanner(source);
+    Parser *parser = stream ? new Parser(scanner, symtab)
+                            : new Parser(scanner->scanAll(), symtab);
+
+    phase("parse");
+    return parser;
+}
+
+/**
+ * Test the parser.
+ * @param parser the parser.
+ * @param treeFormat how to print the parse tree.
+ */
+void testParser(Parser *parser, int treeFormat)
+{
+    Node *programNode = parser->parseProgram();    // parse the program
     int errorCount = parser->getErrorCount();
+    countParse(parser->getTokenCount(), programNode);
 
     if (errorCount == 0)
     {
-        cout << "Parse tree:" << endl << endl;
+        // Only the XML is for people to read.
+        if (treeFormat == ParseTreePrinter::XML)
+        {
+            cout << "Parse tree:" << endl << endl;
+        }
 
-        ParseTreePrinter *printer = new ParseTreePrinter();
+        phase("print");
+        ParseTreePrinter *printer =
+                new ParseTreePrinter(parser->getSource()->lines(), treeFormat);
         printer->print(programNode);
     }
     else
@@ -112,19 +307,504 @@ void testParser(Scanner *scanner, Symtab *symtab)
  * Test the executor.
  * @param parser the parser.
  * @param symtab the symbol table.
+ * @param jit true to compile the program to machine code if possible.
+ * @param optimization the level of the parse tree optimizations.
+ * @param dumpOptimization true to print the parse tree before and after
+ *                         it's optimized.
+ * @param treeFormat how to print the parse tree.
+ * @param recordFileName the execution profile to add this run's counts
+ *                       to, or empty. Recording interprets the fused
+ *                       program.
+ * @param profileFileName the execution profile of earlier runs to tune
+ *                        this one by, or empty.
+ * @return the exit status.
  */
-void executeProgram(Parser *parser, Symtab *symtab)
+int executeProgram(Parser *parser, Symtab *symtab, bool jit,
+                   int optimization, bool dumpOptimization, int treeFormat,
+                   string recordFileName, string profileFileName)
 {
     Node *programNode = parser->parseProgram();
+    int errorCount = parser->getErrorCount() + parser->checkDepth();
+    countParse(parser->getTokenCount(), programNode);
+
+    if (errorCount == 0)
+    {
+        // Number the nodes as parsed, before any optimization moves them.
+        // A recording adds to a profile of the same source, if any.
+        Source *source = parser->getSource();
+        bool recording = !recordFileName.empty();
+        ExecutionProfile *profile = nullptr;
+
+        if (recording || !profileFileName.empty())
+        {
+            profile = new ExecutionProfile(programNode, source->chars(),
+                                           source->length());
+
+            bool loaded = profile->load(recording ? recordFileName
+                                                  : profileFileName);
+            if (!loaded && !recording)
+            {
+                cout << "*** Profile " << profileFileName
+                     << " doesn't match the source, ignored" << endl;
+                delete profile;
+                profile = nullptr;
+            }
+        }
+
+        phase("optimize");
+        ParseTreePrinter printer(parser->getSource()->lines(), treeFormat);
+        if (dumpOptimization)
+        {
+            cout << "Parse tree before optimization:" << endl << endl;
+            printer.print(programNode);
+        }
+
+        Optimizer optimizer(symtab, optimization);
+        optimizer.optimize(programNode);
+
+        if (dumpOptimization)
+        {
+            cout << endl << "Parse tree after optimization:" << endl << endl;
+            printer.print(programNode);
+            cout << endl << optimizer.getEliminatedCount()
+                 << " common subexpressions eliminated, "
+                 << optimizer.getDeadStoreCount() << " dead stores removed, "
+                 << optimizer.getUnrolledCount() << " loops unrolled, "
+                 << optimizer.getReducedCount()
+                 << " multiplications reduced." << endl << endl;
+        }
+
+        // A recording runs the fused tree that the runs which use its
+        // profile will run. Fusion keeps the node ids, and the fused
+        // nodes count the nodes they stand for. A recording has no
+        // counts of its own yet, so it fuses every statement.
+        Superinstructions(symtab, recording ? nullptr : profile).fuse(programNode);
+
+        // Interpret the program if it can't be compiled on this machine,
+        // or if by its profile it runs too briefly to repay compiling.
+        bool worthCompiling = (profile == nullptr) || profile->isWorthCompiling();
+        if (jit && !recording && worthCompiling)
+        {
+            phase("compile");
+            Jit *compiler = new Jit(symtab);
+            compiler->setLineMap(parser->getSource()->lines());
+            compiler->setProfile(profile);
+            if (compiler->compile(programNode))
+            {
+                phase("execute");
+                return compiler->run();
+            }
+        }
+
+        phase("specialize");
+        Specializer(symtab).specialize(programNode);
+        if ((profile != nullptr) && !recording) profile->layOut(programNode);
+
+        phase("execute");
+        Executor *executor = new Executor(symtab);
+        executor->setLineMap(parser->getSource()->lines());
+        if (recording) executor->setRecording(profile);
+        int status = executor->execute(programNode);
+
+        if (recording && !profile->save(recordFileName))
+        {
+            cout << "*** ERROR: Failed to write " << recordFileName << endl;
+        }
+
+        return status;
+    }
+    else
+    {
+        cout << endl << "There were " << errorCount << " errors." << endl;
+        return 0;
+    }
+}
+
+/**
+ * Execute the program once for each row of a CSV file of initial
+ * variable values, many rows at a time, and print a CSV of each run's
+ * status, final variable values and output. The header row names
+ * the variables, which the program may then use without assigning.
+ * @param source the input source.
+ * @param symtab the symbol table.
+ * @param csvFileName the CSV file name.
+ * @return 0 if every run succeeded, else -1.
+ */
+int executeLanes(Source *source, Symtab *symtab, string csvFileName)
+{
+    ifstream csv(csvFileName);
+    if (csv.fail())
+    {
+        cout << "*** ERROR: Failed to open " << csvFileName << endl;
+        return -1;
+    }
+
+    // Split a line at its commas and trim each cell.
+    auto cells = [](const string &line)
+    {
+        vector<string> cells;
+        stringstream stream(line);
+        string cell;
+
+        while (getline(stream, cell, ','))
+        {
+            size_t first = cell.find_first_not_of(" \t\r");
+            size_t last  = cell.find_last_not_of(" \t\r");
+            cells.push_back(first == string::npos
+                                ? "" : cell.substr(first, last - first + 1));
+        }
+
+        return cells;
+    };
+
+    string line;
+    getline(csv, line);
+    vector<string> columns = cells(line);
+
+    // Declare the variables, in lower case like the parser's lookups.
+    for (string &column : columns)
+    {
+        column = toLowerCase(column);
+        if (symtab->lookup(column) == nullptr) symtab->enter(column);
+    }
+
+    vector<vector<double>> rows;
+    for (int lineNumber = 2; getline(csv, line); lineNumber++)
+    {
+        if (line.find_first_not_of(" \t\r") == string::npos) continue;
+
+        // Every row has a value for each column.
+        vector<string> rowCells = cells(line);
+        if (rowCells.size() != columns.size())
+        {
+            cout << "*** ERROR: " << rowCells.size() << " values for "
+                 << columns.size() << " columns at line " << lineNumber
+                 << " of " << csvFileName << endl;
+            return -1;
+        }
+
+        vector<double> row;
+        for (string &cell : rowCells)
+        {
+            char *end;
+            row.push_back(strtod(cell.c_str(), &end));
+
+            if (cell.empty() || (*end != '\0'))
+            {
+                cout << "*** ERROR: Invalid value '" << cell << "' at line "
+                     << lineNumber << " of " << csvFileName << endl;
+                return -1;
+            }
+        }
+
+        rows.push_back(row);
+    }
+
+    Parser *parser = createParser(source, symtab, false);
+    Node *programNode = parser->parseProgram();
+    int errorCount = parser->getErrorCount() + parser->checkDepth();
+    countParse(parser->getTokenCount(), programNode);
+
+    if (errorCount > 0)
+    {
+        cout << endl << "There were " << errorCount << " errors." << endl;
+        return 0;
+    }
+
+    // Run the fused tree that the executor runs, with its counted loops.
+    Superinstructions(symtab).fuse(programNode);
+
+    phase("execute");
+    LaneExecutor executor(symtab);
+    executor.setLineMap(source->lines());
+    vector<LaneResult> results = executor.execute(programNode, columns, rows);
+
+    // One CSV row per run, with the output quoted.
+    cout << "run,status";
+    for (const string &name : executor.variableNames()) cout << "," << name;
+    cout << ",output" << endl;
+
+    int failures = 0;
+    for (size_t r = 0; r < results.size(); r++)
+    {
+        cout << r + 1 << "," << results[r].status;
+        for (double value : results[r].values)
+        {
+            char number[32];
+            snprintf(number, sizeof(number), "%.15g", value);
+            cout << "," << number;
+        }
+
+        string output = results[r].output;
+        for (size_t q = output.find('"'); q != string::npos;
+             q = output.find('"', q + 2))
+        {
+            output.insert(q, 1, '"');
+        }
+        cout << ",\"" << output << "\"" << endl;
+
+        if (results[r].status != 0) failures++;
+    }
+
+    return failures == 0 ? 0 : -1;
+}
+
+/**
+ * Create the code parser.
+ * @param source the input source.
+ * @param symtab the symbol table.
+ * @param stream true to parse tokens as they're scanned,
+ *               false to scan the entire source first.
+ * @return the code parser.
+ */
+CodeParser *createCodeParser(Source *source, Symtab *symtab, bool stream)
+{
+    phase("scan");
+    Scanner *scanner = new Scanner(source);
+    CodeParser *parser = stream ? new CodeParser(scanner, symtab)
+                                : new CodeParser(scanner->scanAll(), symtab);
+
+    phase("parse");
+    return parser;
+}
+
+/**
+ * Test the code parser by printing the code it emits.
+ * @param parser the code parser.
+ */
+void testCodeParser(CodeParser *parser)
+{
+    Code *code = parser->parseProgram();
+    int errorCount = parser->getErrorCount();
+    countParse(parser->getTokenCount(), nullptr);
+
+    if (errorCount == 0)
+    {
+        phase("print");
+        code->print();
+    }
+    else
+    {
+        cout << endl << "There were " << errorCount << " errors." << endl;
+    }
+}
+
+/**
+ * Compile the program while parsing it and run the code.
+ * @param parser the code parser.
+ */
+int runCode(CodeParser *parser)
+{
+    Code *code = parser->parseProgram();
+    int errorCount = parser->getErrorCount();
+    countParse(parser->getTokenCount(), nullptr);
+
+    if (errorCount == 0)
+    {
+        phase("execute");
+        VirtualMachine *machine = new VirtualMachine(code);
+        machine->setLineMap(parser->getSource()->lines());
+        return machine->run();
+    }
+    else
+    {
+        cout << endl << "There were " << errorCount << " errors." << endl;
+        return 0;
+    }
+}
+
+/**
+ * Compile the program and write it as a program image, named after
+ * the source file with its extension replaced by .simg.
+ * @param parser the code parser.
+ * @param sourceFileName the source file name.
+ * @return the exit status.
+ */
+int precompileProgram(CodeParser *parser, string sourceFileName)
+{
+    Code *code = parser->parseProgram();
     int errorCount = parser->getErrorCount();
+    countParse(parser->getTokenCount(), nullptr);
+
+    if (errorCount > 0)
+    {
+        cout << endl << "There were " << errorCount << " errors." << endl;
+        return -1;
+    }
+
+    size_t dot = sourceFileName.find_last_of('.');
+    size_t slash = sourceFileName.find_last_of('/');
+    string imageFileName =
+        (   (dot != string::npos)
+         && ((slash == string::npos) || (dot > slash))
+                ? sourceFileName.substr(0, dot) : sourceFileName) + ".simg";
+
+    phase("write");
+    if (!CodeImage::write(code, parser->getSource()->lines(), imageFileName))
+    {
+        return -1;
+    }
+
+    cout << "Wrote " << imageFileName << endl;
+    return 0;
+}
+
+/**
+ * Map a program image and run it in place.
+ * @param imageFileName the image file name.
+ * @return the exit status.
+ */
+int runImage(string imageFileName)
+{
+    CodeImage *image = CodeImage::map(imageFileName);
+    if (image == nullptr) return -1;
+
+    VirtualMachine machine(image);
+    int status = machine.run();
+
+    delete image;
+    return status;
+}
+
+/**
+ * Run a batch of programs concurrently and print each one's output
+ * in the order that the list names them.
+ * @param listFileName the file that lists the source file names.
+ * @param threadCount the number of threads, or 0 for one per core.
+ * @return 0 if every program ran without errors, else -1.
+ */
+int runBatch(string listFileName, int threadCount)
+{
+    ifstream list(listFileName);
+    if (list.fail())
+    {
+        cout << "*** ERROR: Failed to open " << listFileName << endl;
+        return -1;
+    }
+
+    vector<string> sourceFileNames;
+    string line;
+    while (getline(list, line))
+    {
+        if (!line.empty()) sourceFileNames.push_back(line);
+    }
+
+    vector<BatchResult> results =
+                        BatchRunner(threadCount).run(sourceFileNames);
+
+    int failures = 0;
+    for (BatchResult &result : results)
+    {
+        cout << "==== " << result.name << " (status " << result.status
+             << ")" << endl << result.output;
+        if (result.status != 0) failures++;
+    }
+
+    cout << endl << results.size() << " programs, "
+         << failures << " failed." << endl;
+    return failures == 0 ? 0 : -1;
+}
+
+/**
+ * Serve requests to run programs until shut down.
+ * @param socketPath the Unix domain socket to listen on,
+ *                   or - to read requests from the standard input
+ *                   and write responses to the standard output.
+ * @return the exit status.
+ */
+int serve(string socketPath)
+{
+    Server server;
+
+    if (socketPath != "-") return server.serveSocket(socketPath);
+
+    server.serveStream(STDIN_FILENO, STDOUT_FILENO);
+    cerr << server.statistics();
+    return 0;
+}
+
+/**
+ * Execute the program with the profiler attached and print the profile.
+ * @param parser the parser.
+ * @param symtab the symbol table.
+ * @param sourceFileName the source file name for the line heat map.
+ */
+void profileProgram(Parser *parser, Symtab *symtab, string sourceFileName)
+{
+    if (!Profiler::ENABLED)
+    {
+        cout << "*** Profiling is not compiled in: "
+             << "rebuild with -DSIMPLE_PROFILE" << endl;
+    }
+
+    Node *programNode = parser->parseProgram();
+    int errorCount = parser->getErrorCount() + parser->checkDepth();
+    countParse(parser->getTokenCount(), programNode);
 
     if (errorCount == 0)
     {
+        phase("execute");
+        Superinstructions(symtab).fuse(programNode);
+        Specializer(symtab).specialize(programNode);
+
+        Profiler *profiler = new Profiler();
         Executor *executor = new Executor(symtab);
-        executor->visit(programNode);
+        LineMap *lines = parser->getSource()->lines();
+
+        executor->setLineMap(lines);
+        executor->setProfiler(profiler);
+        executor->execute(programNode);
+
+        if (Profiler::ENABLED) profiler->print(sourceFileName, lines);
     }
     else
     {
         cout << endl << "There were " << errorCount << " errors." << endl;
     }
 }
+
+/**
+ * Start timing the next phase if collecting statistics.
+ * @param name the phase name.
+ */
+void phase(string name)
+{
+    if (stats != nullptr) stats->start(name);
+}
+
+/**
+ * Count what the parser produced if collecting statistics.
+ * @param tokenCount the number of tokens parsed.
+ * @param programNode the root of the parse tree, or null if none.
+ */
+void countParse(int tokenCount, Node *programNode)
+{
+    if (stats == nullptr) return;
+
+    stats->count("tokens", tokenCount);
+    if (programNode != nullptr) stats->count("nodes", countNodes(programNode));
+}
+
+/**
+ * Count the nodes of a parse tree.
+ * @param node the root of the tree.
+ * @return the count.
+ */
+long countNodes(Node *node)
+{
+    // An explicit stack, since -parse takes a tree of any depth.
+    long count = 0;
+    vector<Node *> stack = { node };
+
+    while (!stack.empty())
+    {
+        Node *next = stack.back();
+        stack.pop_back();
+        if (next == nullptr) continue;
+
+        count++;
+        for (Node *child : next->children) stack.push_back(child);
+    }
+
+    return count;
+}
@@ -0,0 +1,276 @@
+/**
+ * Statistics class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <iostream>
+#include <string>
+#include <atomic>
+#include <new>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <sys/resource.h>
+
+#ifdef __APPLE__
+#include <malloc/malloc.h>
+#define malloc_usable_size malloc_size
+#else
+#include <malloc.h>
+#endif
+
+#include "Stats.h"
+
+using namespace std;
+
+// Heap bytes allocated in all and in use now, counted by the usable
+// size of each block so that a delete can subtract exactly what its
+// new added. Nothing is counted unless statistics were requested.
+static atomic<bool> counting(false);
+static atomic<long> allocatedBytes(0);
+static atomic<long> inUseBytes(0);
+
+void *operator new(size_t size)
+{
+    void *memory = malloc(size > 0 ? size : 1);
+    if (memory == nullptr) throw bad_alloc();
+
+    if (counting.load(memory_order_relaxed))
+    {
+        long usable = malloc_usable_size(memory);
+        allocatedBytes.fetch_add(usable, memory_order_relaxed);
+        inUseBytes.fetch_add(usable, memory_order_relaxed);
+    }
+
+    return memory;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *memory) noexcept
+{
+    if (memory == nullptr) return;
+
+    if (counting.load(memory_order_relaxed))
+    {
+        inUseBytes.fetch_sub(malloc_usable_size(memory), memory_order_relaxed);
+    }
+    free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    operator delete(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    operator delete(memory);
+}
+
+void operator delete[](void *memory, size_t) noexcept
+{
+    operator delete(memory);
+}
+
+/**
+ * Read a clock.
+ * @param clock CLOCK_MONOTONIC for wall time,
+ *              or CLOCK_PROCESS_CPUTIME_ID for CPU time.
+ * @return the time in seconds.
+ */
+static double now(clockid_t clock)
+{
+    timespec time;
+    clock_gettime(clock, &time);
+
+    return time.tv_sec + time.tv_nsec/1e9;
+}
+
+void Stats::countHeap()
+{
+    counting.store(true, memory_order_relaxed);
+}
+
+long Stats::heapAllocated()
+{
+    return allocatedBytes.load(memory_order_relaxed);
+}
+
+long Stats::heapInUse()
+{
+    // Blocks from before countHeap() can take the count below zero.
+    long inUse = inUseBytes.load(memory_order_relaxed);
+    return inUse > 0 ? inUse : 0;
+}
+
+long Stats::peakResidentSize()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+#ifdef __APPLE__
+    return usage.ru_maxrss;        // macOS reports bytes
+#else
+    return usage.ru_maxrss*1024L;  // Linux reports kilobytes
+#endif
+}
+
+void Stats::start(string name)
+{
+    stop();
+
+    phases.push_back({ name, 0, 0, 0, 0 });
+    running        = true;
+    allocatedStart = heapAllocated();
+    inUseStart     = heapInUse();
+    cpuStart       = now(CLOCK_PROCESS_CPUTIME_ID);
+    wallStart      = now(CLOCK_MONOTONIC);
+}
+
+void Stats::stop()
+{
+    if (!running) return;
+
+    double wallEnd = now(CLOCK_MONOTONIC);
+    double cpuEnd  = now(CLOCK_PROCESS_CPUTIME_ID);
+
+    Phase &phase = phases.back();
+    phase.wallSeconds   = wallEnd - wallStart;
+    phase.cpuSeconds    = cpuEnd - cpuStart;
+    phase.heapAllocated = heapAllocated() - allocatedStart;
+    phase.heapRetained  = heapInUse() - inUseStart;
+    running = false;
+}
+
+void Stats::count(string name, long value)
+{
+    for (pair<string, long> &count : counts)
+    {
+        if (count.first == name)
+        {
+            count.second = value;
+            return;
+        }
+    }
+
+    counts.push_back(make_pair(name, value));
+}
+
+void Stats::subsystem(string name, long liveBytes, long peakBytes,
+                      long allocationCount)
+{
+    subsystems.push_back({ name, liveBytes, peakBytes, allocationCount });
+}
+
+void Stats::print(ostream &out, int format)
+{
+    stop();
+
+    if (format == JSON) printJson(out);
+    else                printText(out);
+}
+
+void Stats::printText(ostream &out)
+{
+    char line[128];
+    double wallTotal = 0, cpuTotal = 0;
+    long allocatedTotal = 0, retainedTotal = 0;
+
+    out << endl << "Statistics:" << endl << endl;
+    snprintf(line, sizeof(line), "%-12s %12s %12s %16s %16s",
+             "phase", "wall ms", "cpu ms", "heap allocated", "heap retained");
+    out << line << endl;
+
+    for (Phase &phase : phases)
+    {
+        snprintf(line, sizeof(line), "%-12s %12.3f %12.3f %16ld %16ld",
+                 phase.name.c_str(), phase.wallSeconds*1000,
+                 phase.cpuSeconds*1000, phase.heapAllocated,
+                 phase.heapRetained);
+        out << line << endl;
+
+        wallTotal      += phase.wallSeconds;
+        cpuTotal       += phase.cpuSeconds;
+        allocatedTotal += phase.heapAllocated;
+        retainedTotal  += phase.heapRetained;
+    }
+
+    snprintf(line, sizeof(line), "%-12s %12.3f %12.3f %16ld %16ld",
+             "total", wallTotal*1000, cpuTotal*1000, allocatedTotal,
+             retainedTotal);
+    out << line << endl << endl;
+
+    for (pair<string, long> &count : counts)
+    {
+        snprintf(line, sizeof(line), "%16ld %s", count.second,
+                 count.first.c_str());
+        out << line << endl;
+    }
+
+    snprintf(line, sizeof(line), "%16ld %s", peakResidentSize(),
+             "bytes peak resident set size");
+    out << line << endl;
+
+    if (subsystems.empty()) return;
+
+    out << endl;
+    snprintf(line, sizeof(line), "%-12s %16s %16s %16s",
+             "subsystem", "live bytes", "peak bytes", "allocations");
+    out << line << endl;
+
+    for (Allocations &subsystem : subsystems)
+    {
+        snprintf(line, sizeof(line), "%-12s %16ld %16ld %16ld",
+                 subsystem.name.c_str(), subsystem.liveBytes,
+                 subsystem.peakBytes, subsystem.allocationCount);
+        out << line << endl;
+    }
+}
+
+void Stats::printJson(ostream &out)
+{
+    char number[32];
+
+    // The names are the interpreter's own, so they need no escapes.
+    out << "{\"phases\":[";
+    for (size_t i = 0; i < phases.size(); i++)
+    {
+        Phase &phase = phases[i];
+
+        if (i > 0) out << ",";
+        out << "{\"name\":\"" << phase.name << "\"";
+        snprintf(number, sizeof(number), "%.6f", phase.wallSeconds);
+        out << ",\"wallSeconds\":" << number;
+        snprintf(number, sizeof(number), "%.6f", phase.cpuSeconds);
+        out << ",\"cpuSeconds\":" << number;
+        out << ",\"heapAllocated\":" << phase.heapAllocated
+            << ",\"heapRetained\":" << phase.heapRetained << "}";
+    }
+    out << "],\"counts\":{";
+
+    for (size_t i = 0; i < counts.size(); i++)
+    {
+        if (i > 0) out << ",";
+        out << "\"" << counts[i].first << "\":" << counts[i].second;
+    }
+
+    out << "},\"subsystems\":{";
+
+    for (size_t i = 0; i < subsystems.size(); i++)
+    {
+        Allocations &subsystem = subsystems[i];
+
+        if (i > 0) out << ",";
+        out << "\"" << subsystem.name << "\":{\"liveBytes\":"
+            << subsystem.liveBytes << ",\"peakBytes\":" << subsystem.peakBytes
+            << ",\"allocations\":" << subsystem.allocationCount << "}";
+    }
+
+    out << "},\"peakResidentSize\":" << peakResidentSize() << "}" << endl;
+}
@@ -0,0 +1,134 @@
+/**
+ * Statistics class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <utility>
+
+using namespace std;
+
+/**
+ * Time and memory statistics of one run of the interpreter, split into
+ * its phases such as loading the source, scanning, parsing and execution.
+ * Each phase has its wall and CPU time and the heap bytes that it
+ * allocated and kept. The heap is measured by the program's replacements
+ * of the global operator new and delete, which count the allocations only
+ * after countHeap(), so that a run without statistics doesn't pay for
+ * them. The objects of each subsystem, such as the parser's nodes, can
+ * also be reported apart.
+ *
+ * The Simple and Pcl4 interpreters both build this one implementation.
+ */
+class Stats
+{
+public:
+    static const int TEXT = 0;
+    static const int JSON = 1;
+
+private:
+    struct Phase
+    {
+        string name;
+        double wallSeconds;
+        double cpuSeconds;
+        long heapAllocated;  // bytes allocated during the phase
+        long heapRetained;   // change in the bytes in use
+    };
+
+    struct Allocations
+    {
+        string name;
+        long liveBytes;
+        long peakBytes;
+        long allocationCount;
+    };
+
+    vector<Phase> phases;
+    vector<Allocations> subsystems;
+    vector<pair<string, long>> counts;  // in the order that they're set
+
+    bool running;            // true while a phase is timed
+    double wallStart;        // of the running phase
+    double cpuStart;
+    long allocatedStart;
+    long inUseStart;
+
+public:
+    Stats() : running(false), wallStart(0), cpuStart(0), allocatedStart(0),
+              inUseStart(0) {}
+
+    /**
+     * End the running phase, if any, and start timing the next one.
+     * @param name the phase name.
+     */
+    void start(string name);
+
+    /**
+     * End the running phase, if any.
+     */
+    void stop();
+
+    /**
+     * Set a count, such as the number of tokens.
+     * @param name the name of what was counted.
+     * @param value the count.
+     */
+    void count(string name, long value);
+
+    /**
+     * Add the allocations of the objects of a subsystem.
+     * @param name the subsystem name.
+     * @param liveBytes the bytes allocated and not yet released.
+     * @param peakBytes the most bytes ever live at once.
+     * @param allocationCount the count of objects allocated.
+     */
+    void subsystem(string name, long liveBytes, long peakBytes,
+                   long allocationCount);
+
+    /**
+     * Stop timing and print the statistics.
+     * @param out the output stream.
+     * @param format TEXT or JSON.
+     */
+    void print(ostream &out, int format);
+
+    /**
+     * Start counting the heap's allocations and releases. Call it once
+     * statistics are requested, before the first phase. A block allocated
+     * before then is still subtracted when it's released, so the bytes
+     * in use can undercount, though never below zero.
+     */
+    static void countHeap();
+
+    /**
+     * Getter.
+     * @return the total bytes allocated from the heap so far.
+     */
+    static long heapAllocated();
+
+    /**
+     * Getter.
+     * @return the bytes of the heap now in use, at least 0.
+     */
+    static long heapInUse();
+
+    /**
+     * Getter.
+     * @return the peak resident set size of the process in bytes.
+     */
+    static long peakResidentSize();
+
+private:
+    void printText(ostream &out);
+    void printJson(ostream &out);
+};
+
+#endif /* STATS_H_ */
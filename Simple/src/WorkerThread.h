@@ -0,0 +1,65 @@
+/**
+ * Worker thread class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef WORKERTHREAD_H_
+#define WORKERTHREAD_H_
+
+#include <functional>
+#include <system_error>
+#include <pthread.h>
+
+using namespace std;
+
+/**
+ * A thread like std::thread, but with the 8 MB stack that the main
+ * thread usually gets instead of the platform's default for other
+ * threads, which can be as little as 512 KB. So a parse tree as deep
+ * as Parser::MAX_DEPTH runs on a batch or server thread too.
+ */
+class WorkerThread
+{
+private:
+    pthread_t id;
+
+    static void *run(void *body)
+    {
+        function<void()> *task = (function<void()> *) body;
+        (*task)();
+        delete task;
+
+        return nullptr;
+    }
+
+public:
+    static const size_t STACK_SIZE = 8*1024*1024;
+
+    /**
+     * Constructor to start the thread.
+     * @param body what the thread runs.
+     */
+    WorkerThread(function<void()> body)
+    {
+        pthread_attr_t attributes;
+        pthread_attr_init(&attributes);
+        pthread_attr_setstacksize(&attributes, STACK_SIZE);
+
+        function<void()> *copy = new function<void()>(body);
+        int error = pthread_create(&id, &attributes, run, copy);
+        pthread_attr_destroy(&attributes);
+
+        if (error != 0)
+        {
+            delete copy;
+            throw system_error(error, generic_category(), "pthread_create");
+        }
+    }
+
+    void join()   { pthread_join(id, nullptr); }
+    void detach() { pthread_detach(id); }
+};
+
+#endif /* WORKERTHREAD_H_ */
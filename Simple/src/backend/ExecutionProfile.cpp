@@ -0,0 +1,152 @@
+/**
+ * Execution profile class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "../intermediate/Node.h"
+#include "ExecutionProfile.h"
+
+namespace backend {
+
+using namespace std;
+using namespace intermediate;
+
+static const string PROFILE_HEADER = "SIMPLE-PROFILE";
+
+ExecutionProfile::ExecutionProfile(Node *programNode, const char *text,
+                                   int length)
+{
+    counts.resize(number(programNode, 0), { 0, 0 });
+
+    // FNV-1a
+    sourceHash = 14695981039346656037UL;
+    for (int i = 0; i < length; i++)
+    {
+        sourceHash ^= (unsigned char) text[i];
+        sourceHash *= 1099511628211UL;
+    }
+}
+
+int ExecutionProfile::number(Node *node, int id)
+{
+    node->id = id++;
+
+    for (Node *child : node->children)
+    {
+        if (child != nullptr) id = number(child, id);
+    }
+
+    return id;
+}
+
+void ExecutionProfile::countSubtree(Node *node)
+{
+    count(node);
+
+    for (Node *child : node->children)
+    {
+        if (child != nullptr) countSubtree(child);
+    }
+}
+
+bool ExecutionProfile::load(string fileName)
+{
+    ifstream in(fileName);
+    string header;
+    unsigned long hash;
+    size_t nodeCount;
+
+    in >> header >> hash >> nodeCount;
+    if (   in.fail() || (header != PROFILE_HEADER)
+        || (hash != sourceHash) || (nodeCount != counts.size()))
+    {
+        return false;
+    }
+
+    // One line per node that ran: its id and its counts.
+    size_t id;
+    unsigned long visits, taken;
+    while ((in >> id >> visits >> taken) && (id < counts.size()))
+    {
+        counts[id].visits += visits;
+        counts[id].taken  += taken;
+    }
+
+    return true;
+}
+
+bool ExecutionProfile::save(string fileName) const
+{
+    ofstream out(fileName);
+
+    out << PROFILE_HEADER << " " << sourceHash << " " << counts.size() << endl;
+    for (size_t id = 0; id < counts.size(); id++)
+    {
+        if (counts[id].visits > 0)
+        {
+            out << id << " " << counts[id].visits << " "
+                << counts[id].taken << endl;
+        }
+    }
+
+    return !out.fail();
+}
+
+bool ExecutionProfile::usuallyContinues(Node *testNode) const
+{
+    if (testNode->id < 0) return false;
+
+    const Counts &test = counts[testNode->id];
+    return test.taken < test.visits - test.taken;
+}
+
+bool ExecutionProfile::isWorthCompiling() const
+{
+    unsigned long visits = 0;
+    for (const Counts &count : counts) visits += count.visits;
+
+    return visits >= COMPILE_RATIO*counts.size();
+}
+
+void ExecutionProfile::layOut(Node *programNode)
+{
+    map<Node *, Node *> moved;  // each hot node and its copy
+    relocate(programNode, moved);
+}
+
+void ExecutionProfile::relocate(Node *node, map<Node *, Node *> &moved)
+{
+    for (Node *&child : node->children)
+    {
+        if (child == nullptr) continue;
+
+        // A hot node with several parents is copied once and stays shared.
+        auto found = moved.find(child);
+        if (found != moved.end())
+        {
+            child = found->second;
+            continue;
+        }
+
+        // A copy is bump allocated right after the one before,
+        // and its list of children right after it.
+        if (isHot(child))
+        {
+            Node *copy = new Node(*child);
+            moved[child] = copy;
+            moved[copy]  = copy;
+            child = copy;
+        }
+
+        relocate(child, moved);
+    }
+}
+
+}  // namespace backend
@@ -0,0 +1,157 @@
+/**
+ * Execution profile class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef EXECUTIONPROFILE_H_
+#define EXECUTIONPROFILE_H_
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "../intermediate/Node.h"
+
+namespace backend {
+
+using namespace std;
+using namespace intermediate;
+
+/**
+ * How often each node of a program's parse tree ran, and how often each
+ * loop test was true, recorded by the executor and kept in a profile
+ * file from one run to the next. A node is known by its index in a
+ * preorder walk of the tree as parsed, so the counts outlast the
+ * optimizations, and the file also keeps a hash of the source text so
+ * that a profile of another version of the program is never used.
+ * Counts recorded into an existing profile of the same source add up.
+ *
+ * A later run uses the profile to interpret instead of compile a program
+ * whose code mostly runs once, to leave the statements that never ran
+ * unfused and uncompiled, to lay out the loops that usually continue so
+ * that the compiled code branches once per trip, and to copy the hot
+ * statements next to each other in memory. The statements themselves
+ * never change places, because their order is the program's meaning.
+ */
+class ExecutionProfile
+{
+public:
+    // A node is hot if it ran at least this many times.
+    static const unsigned long HOT_VISITS = 100;
+
+    // A program is worth compiling if its nodes ran at least
+    // this many times each on average.
+    static const unsigned long COMPILE_RATIO = 10;
+
+private:
+    struct Counts
+    {
+        unsigned long visits;  // times the node ran
+        unsigned long taken;   // times a loop test was true
+    };
+
+    vector<Counts> counts;     // by node id
+    unsigned long sourceHash;  // of the profiled source text
+
+public:
+    /**
+     * Constructor. Number the nodes of a parse tree in preorder
+     * and start with no counts.
+     * @param programNode the root of the tree as parsed.
+     * @param text the source text.
+     * @param length the length of the source text.
+     */
+    ExecutionProfile(Node *programNode, const char *text, int length);
+
+    /**
+     * Count a run of a node.
+     * @param node the node.
+     */
+    void count(Node *node)
+    {
+        if (node->id >= 0) counts[node->id].visits++;
+    }
+
+    /**
+     * Count a loop test that was true.
+     * @param testNode the test node.
+     */
+    void taken(Node *testNode)
+    {
+        if (testNode->id >= 0) counts[testNode->id].taken++;
+    }
+
+    /**
+     * Count a run of each node of a subtree that a superinstruction
+     * ran without visiting, as the unfused tree would have.
+     * @param node the root of the subtree.
+     */
+    void countSubtree(Node *node);
+
+    /**
+     * Add the counts of a profile file.
+     * @param fileName the file name.
+     * @return true if the file is a profile of this source, else false.
+     */
+    bool load(string fileName);
+
+    /**
+     * Write the counts to a profile file.
+     * @param fileName the file name.
+     * @return true if successful, else false.
+     */
+    bool save(string fileName) const;
+
+    /**
+     * Check whether a node never ran.
+     * @param node the node.
+     * @return true if it never ran, false if it did or is unknown,
+     *         such as a node that an optimization created.
+     */
+    bool isCold(Node *node) const
+    {
+        return (node->id >= 0) && (counts[node->id].visits == 0);
+    }
+
+    /**
+     * Check whether a node is hot.
+     * @param node the node.
+     * @return true if it ran at least HOT_VISITS times.
+     */
+    bool isHot(Node *node) const
+    {
+        return (node->id >= 0) && (counts[node->id].visits >= HOT_VISITS);
+    }
+
+    /**
+     * Check whether a loop usually continues after its test.
+     * @param testNode the loop's test node.
+     * @return true if the test was false more often than true.
+     */
+    bool usuallyContinues(Node *testNode) const;
+
+    /**
+     * Check whether compiling the program would repay its cost.
+     * @return true if its code mostly ran many times, false if it
+     *         mostly ran once or never.
+     */
+    bool isWorthCompiling() const;
+
+    /**
+     * Copy the hot statements and their subtrees to fresh memory in the
+     * order that they're walked, so that a hot loop's nodes are together.
+     * The copies keep their ids.
+     * @param programNode the root of the parse tree, which stays put.
+     */
+    void layOut(Node *programNode);
+
+private:
+    int number(Node *node, int id);
+    void relocate(Node *node, map<Node *, Node *> &moved);
+};
+
+}  // namespace backend
+
+#endif /* EXECUTIONPROFILE_H_ */
@@ -6,13 +6,17 @@
  * San Jose State University
  */
 #include <iostream>
+#include <iomanip>
 #include <string>
 #include <vector>
 #include <set>
+#include <cmath>
+#include <climits>
 
 #include "../Object.h"
 #include "../intermediate/Symtab.h"
 #include "../intermediate/Node.h"
+#include "RuntimeError.h"
 #include "Executor.h"
 
 namespace backend {
@@ -20,22 +24,45 @@ namespace backend {
 using namespace std;
 using namespace intermediate;
 
-set<NodeType> Executor::singletons;
-set<NodeType> Executor::relationals;
+const set<NodeType> Executor::singletons =
+{
+    VARIABLE, INTEGER_CONSTANT, REAL_CONSTANT, STRING_CONSTANT
+};
+
+const set<NodeType> Executor::relationals = { EQ, LT, GT };
 
-void Executor::initialize()
+/**
+ * Make an object of an integer value, which can also be read as a double.
+ * @param value the value.
+ * @return the object.
+ */
+static Object integerObject(long value)
 {
-    singletons.insert(VARIABLE);
-    singletons.insert(INTEGER_CONSTANT);
-    singletons.insert(REAL_CONSTANT);
-    singletons.insert(STRING_CONSTANT);
+    Object object(value);
+    object.D = value;
 
-    relationals.insert(EQ);
-    relationals.insert(LT);
+    return object;
+}
+
+int Executor::execute(Node *programNode)
+{
+    try
+    {
+        visit(programNode);
+    }
+    catch (RuntimeError &error)
+    {
+        return RuntimeError::STATUS;
+    }
+
+    return 0;
 }
 
 Object Executor::visit(Node *node)
 {
+    PROFILE_VISIT(profiler, node, node->offset >= 0 ? node->offset : offset);
+    if (recording != nullptr) recording->count(node);
+
     switch (node->type)
     {
         case PROGRAM :  return visitProgram(node);
@@ -48,6 +75,29 @@ Object Executor::visit(Node *node)
 
         case TEST:      return visitTest(node);
 
+        case ADD_INT :
+        case SUBTRACT_INT :
+        case MULTIPLY_INT :
+        case VARIABLE_INT :  return integerObject(visitInteger(node));
+
+        case ADD_REAL :
+        case SUBTRACT_REAL :
+        case MULTIPLY_REAL :
+        case DIVIDE_REAL :
+        case VARIABLE_REAL : return Object(visitReal(node));
+
+        case EQ_INT :
+        case LT_INT :
+        case GT_INT :
+        case EQ_REAL :
+        case LT_REAL :
+        case GT_REAL :       return Object(visitCondition(node));
+
+        case ASSIGN_VAR_OP_CONST : return visitAssignVarOpConst(node);
+        case TEST_VAR_CONST :      return visitTestVarConst(node);
+        case WRITE_VAR :           return visitWriteVar(node);
+        case COUNTED_LOOP :        return visitCountedLoop(node);
+
         default :       return visitExpression(node);
     }
 }
@@ -60,7 +110,7 @@ Object Executor::visitProgram(Node *programNode)
 
 Object Executor::visitStatement(Node *statementNode)
 {
-    lineNumber = statementNode->lineNumber;
+    offset = statementNode->offset;
 
     switch (statementNode->type)
     {
@@ -86,13 +136,18 @@ Object Executor::visitAssign(Node *assignNode)
     Node *lhs = assignNode->children[0];
     Node *rhs = assignNode->children[1];
 
-    // Evaluate the right-hand-side expression;
-    double value = visit(rhs).D;
+    // A specialized tree already has the variable's entry.
+    SymtabEntry *variableId = lhs->entry != nullptr ? lhs->entry
+                                                    : symtab->lookup(lhs->text);
 
-    // Store the value into the variable's symbol table entry.
-    string variableName = lhs->text;
-    SymtabEntry *variableId = symtab->lookup(variableName);
-    variableId->setValue(value);
+    // Evaluate the right-hand-side expression and store the value
+    // into the variable's symbol table entry. An INTEGER variable
+    // is only ever assigned an INTEGER expression.
+    if (variableId->getType() == ValueType::INTEGER)
+    {
+        variableId->setInteger(visitInteger(rhs));
+    }
+    else variableId->setValue(visit(rhs).D);
 
     return Object();
 }
@@ -107,8 +162,13 @@ Object Executor::visitLoop(Node *loopNode)
             Object value = visit(node);  // statement or test
 
             // Evaluate the test condition. Stop looping if true.
-            b = (node->type == TEST) && value.B;
-            if (b) break;
+            b =    ((node->type == TEST) || (node->type == TEST_VAR_CONST))
+                && value.B;
+            if (b)
+            {
+                if (recording != nullptr) recording->taken(node);
+                break;
+            }
         }
     } while (!b);
 
@@ -129,12 +189,12 @@ Object Executor::visitWrite(Node *writeNode)
 Object Executor::visitWriteln(Node *writelnNode)
 {
     if (writelnNode->children.size() > 0) printValue(writelnNode->children);
-    cout << endl;
+    *out << endl;
 
     return Object();
 }
 
-void Executor::printValue(vector<Node *> children)
+void Executor::printValue(NodeList &children)
 {
     long fieldWidth    = -1;
     long decimalPlaces = 0;
@@ -150,26 +210,22 @@ void Executor::printValue(vector<Node *> children)
         }
     }
 
-    // Print the value with a format.
+    // Print the value like printf's %w.df and %ws formats.
     Node *valueNode = children[0];
     if (valueNode->type == VARIABLE)
     {
-        string format = "%";
-        if (fieldWidth >= 0)    format += to_string(fieldWidth);
-        if (decimalPlaces >= 0) format += "." + to_string(decimalPlaces);
-        format += "f";
-
         double value = visit(valueNode).D;
-        printf(format.c_str(), value);
+
+        *out << fixed << setprecision(decimalPlaces);
+        if (fieldWidth >= 0) *out << setw(fieldWidth);
+        *out << value;
     }
     else  // Node *type STRING_CONSTANT
     {
-        string format = "%";
-        if (fieldWidth > 0) format += to_string(fieldWidth);
-        format += "s";
-
         string value = visit(valueNode).S;
-        printf(format.c_str(), value.c_str());
+
+        if (fieldWidth > 0) *out << setw(fieldWidth);
+        *out << value;
     }
 }
 
@@ -189,12 +245,49 @@ Object Executor::visitExpression(Node *expressionNode)
         }
     }
 
-    // Binary expressions.
-    double value1 = visit(expressionNode->children[0]).D;
-    double value2 = visit(expressionNode->children[1]).D;
+    // Unary expressions.
+    if (expressionNode->type == NodeType::NOT)
+    {
+        return Object(!visit(expressionNode->children[0]).B);
+    }
+
+    // Binary expressions, in integers if they're typed INTEGER.
+    if (expressionNode->valueType == ValueType::INTEGER)
+    {
+        return integerObject(visitInteger(expressionNode));
+    }
+
+    Node *operand1 = expressionNode->children[0];
+    Node *operand2 = expressionNode->children[1];
+    bool isRelational =    relationals.find(expressionNode->type)
+                        != relationals.end();
+
+    // Integer comparisons.
+    if (   isRelational
+        && (operand1->valueType == ValueType::INTEGER)
+        && (operand2->valueType == ValueType::INTEGER))
+    {
+        long value1 = visitInteger(operand1);
+        long value2 = visitInteger(operand2);
+        bool value = false;
+
+        switch (expressionNode->type)
+        {
+            case EQ : value = value1 == value2; break;
+            case LT : value = value1 <  value2; break;
+            case GT : value = value1 >  value2; break;
+
+            default : break;
+        }
+
+        return Object(value);
+    }
+
+    double value1 = visit(operand1).D;
+    double value2 = visit(operand2).D;
 
     // Relational expressions.
-    if (relationals.find(expressionNode->type) != relationals.end())
+    if (isRelational)
     {
         bool value = false;
 
@@ -202,6 +295,7 @@ Object Executor::visitExpression(Node *expressionNode)
         {
             case EQ : value = value1 == value2; break;
             case LT : value = value1 <  value2; break;
+            case GT : value = value1 >  value2; break;
 
             default : break;
         }
@@ -230,6 +324,17 @@ Object Executor::visitExpression(Node *expressionNode)
             break;
         }
 
+        // Untyped DIV and MOD, such as in a tree that wasn't checked.
+        case INTEGER_DIVIDE :
+        case MODULO :
+        {
+            if (value2 == 0.0) runtimeError(expressionNode, "Division by zero");
+
+            value = expressionNode->type == INTEGER_DIVIDE
+                        ? trunc(value1/value2) : fmod(value1, value2);
+            break;
+        }
+
         default : break;
     }
 
@@ -239,10 +344,138 @@ Object Executor::visitExpression(Node *expressionNode)
 Object Executor::visitVariable(Node *variableNode)
 {
     // Obtain the variable's value from its symbol table entry.
-    string variableName = variableNode->text;
-    SymtabEntry *variableId = symtab->lookup(variableName);
+    SymtabEntry *variableId = symtab->lookup(variableNode->text);
+
+    return variableId->getType() == ValueType::INTEGER
+                ? integerObject(variableId->getInteger())
+                : Object(variableId->getValue());
+}
+
+long Executor::visitInteger(Node *node)
+{
+    switch (node->type)
+    {
+        // A fused node's variable already has its entry.
+        case VARIABLE :
+            return node->entry != nullptr
+                        ? node->entry->getInteger()
+                        : symtab->lookup(node->text)->getInteger();
+
+        case VARIABLE_INT :
+            return node->entry->getInteger();
+
+        case INTEGER_CONSTANT :
+            return node->value.L;
+
+        case ADD :
+        case SUBTRACT :
+        case MULTIPLY :
+        case ADD_INT :
+        case SUBTRACT_INT :
+        case MULTIPLY_INT :
+        case INTEGER_DIVIDE :
+        case MODULO :
+            break;
+
+        default : return (long) visit(node).D;
+    }
+
+    long value1 = visitInteger(node->children[0]);
+    long value2 = visitInteger(node->children[1]);
+    long value  = 0;
+    bool overflow = false;
+
+    switch (node->type)
+    {
+        case ADD :
+        case ADD_INT :
+            overflow = __builtin_add_overflow(value1, value2, &value);
+            break;
+
+        case SUBTRACT :
+        case SUBTRACT_INT :
+            overflow = __builtin_sub_overflow(value1, value2, &value);
+            break;
+
+        case MULTIPLY :
+        case MULTIPLY_INT :
+            overflow = __builtin_mul_overflow(value1, value2, &value);
+            break;
+
+        case INTEGER_DIVIDE :
+        case MODULO :
+        {
+            if (value2 == 0) runtimeError(node, "Division by zero");
+
+            // The one quotient that doesn't fit.
+            overflow = (value1 == LONG_MIN) && (value2 == -1);
+            if (!overflow)
+            {
+                value = node->type == INTEGER_DIVIDE ? value1/value2
+                                                     : value1%value2;
+            }
+            break;
+        }
+
+        default : break;
+    }
+
+    if (overflow) runtimeError(node, "Integer overflow");
+    return value;
+}
+
+double Executor::visitReal(Node *node)
+{
+    switch (node->type)
+    {
+        case VARIABLE_INT :
+        case VARIABLE_REAL :
+            return node->entry->getValue();
+
+        case INTEGER_CONSTANT :
+        case REAL_CONSTANT :
+            return node->value.D;
+
+        case ADD_REAL :
+        case SUBTRACT_REAL :
+        case MULTIPLY_REAL :
+        case DIVIDE_REAL :
+            break;
+
+        default : return visit(node).D;
+    }
+
+    double value1 = visitReal(node->children[0]);
+    double value2 = visitReal(node->children[1]);
 
-    return variableId->getValue();
+    switch (node->type)
+    {
+        case ADD_REAL :      return value1 + value2;
+        case SUBTRACT_REAL : return value1 - value2;
+        case MULTIPLY_REAL : return value1 * value2;
+
+        default :
+        {
+            if (value2 == 0.0) runtimeError(node, "Division by zero");
+            return value1/value2;
+        }
+    }
+}
+
+bool Executor::visitCondition(Node *node)
+{
+    switch (node->type)
+    {
+        case EQ_INT : return visitInteger(node->children[0]) == visitInteger(node->children[1]);
+        case LT_INT : return visitInteger(node->children[0]) <  visitInteger(node->children[1]);
+        case GT_INT : return visitInteger(node->children[0]) >  visitInteger(node->children[1]);
+
+        case EQ_REAL : return visitReal(node->children[0]) == visitReal(node->children[1]);
+        case LT_REAL : return visitReal(node->children[0]) <  visitReal(node->children[1]);
+        case GT_REAL : return visitReal(node->children[0]) >  visitReal(node->children[1]);
+
+        default : return visit(node).B;
+    }
 }
 
 Object Executor::visitIntegerConstant(Node *integerConstantNode)
@@ -257,14 +490,158 @@ Object Executor::visitRealConstant(Node *realConstantNode)
 
 Object Executor::visitStringConstant(Node *stringConstantNode)
 {
-    return stringConstantNode->value;
+    return Object((string) stringConstantNode->text);
+}
+
+Object Executor::visitAssignVarOpConst(Node *assignNode)
+{
+    offset = assignNode->offset;
+    if (recording != nullptr) countFused(assignNode);
+
+    // variable := variable op constant, with the entries already resolved.
+    Node *rhs = assignNode->children[1];
+    SymtabEntry *variableId = assignNode->children[0]->entry;
+
+    if (variableId->getType() == ValueType::INTEGER)
+    {
+        variableId->setInteger(visitInteger(rhs));
+        return Object();
+    }
+
+    double value1 = rhs->children[0]->entry->getValue();
+    double value2 = rhs->children[1]->value.D;
+    double value  = 0.0;
+
+    switch (rhs->type)
+    {
+        case ADD :      value = value1 + value2; break;
+        case SUBTRACT : value = value1 - value2; break;
+        case MULTIPLY : value = value1 * value2; break;
+        case DIVIDE :   value = value1 / value2; break;  // nonzero constant
+
+        default : break;
+    }
+
+    assignNode->children[0]->entry->setValue(value);
+    return Object();
+}
+
+Object Executor::visitTestVarConst(Node *testNode)
+{
+    if (recording != nullptr) countFused(testNode);
+
+    // The test node caches the variable's entry, the constant,
+    // the relational operator and whether to negate.
+    double value1 = testNode->entry->getValue();
+    double value2 = testNode->value.D;
+    bool value = false;
+
+    switch ((NodeType) testNode->value.L)
+    {
+        case EQ : value = value1 == value2; break;
+        case LT : value = value1 <  value2; break;
+        case GT : value = value1 >  value2; break;
+
+        default : break;
+    }
+
+    return Object(value != testNode->value.B);
+}
+
+Object Executor::visitWriteVar(Node *writeNode)
+{
+    offset = writeNode->offset;
+    if (recording != nullptr) countFused(writeNode);
+
+    // Same format as printValue() with no field width or decimal places.
+    *out << fixed << setprecision(0) << writeNode->entry->getValue();
+    if (writeNode->value.B) *out << endl;
+
+    return Object();
+}
+
+Object Executor::visitCountedLoop(Node *loopNode)
+{
+    Node *limitNode = loopNode->children[0]->children[0]->children[1];
+    Node *bodyNode  = loopNode->children[1];
+    SymtabEntry *variableId = loopNode->entry;
+    double step = loopNode->value.D;
+    bool observable = loopNode->value.B;
+
+    // Evaluate the limit once and count in a local. Store the control
+    // variable only if the body reads it, and once more at the end.
+    double limit = visit(limitNode).D;
+    double count = variableId->getValue();
+    long trips = tripCount(count, limit, step);
+
+    // Any induction temporaries, which the optimizer proved can't
+    // overflow, step along with the control variable.
+    NodeList &children = loopNode->children;
+
+    for (; trips > 0; trips--, count += step)
+    {
+        if (observable) variableId->setValue(count);
+        visit(bodyNode);
+
+        // Count the test and the steps that this trip stands for.
+        if (recording != nullptr)
+        {
+            recording->countSubtree(children[0]);
+            for (size_t i = 2; i < children.size(); i++)
+            {
+                recording->countSubtree(children[i]);
+            }
+        }
+
+        for (size_t i = 3; i < children.size(); i++)
+        {
+            SymtabEntry *tempId = children[i]->children[0]->entry;
+            tempId->setInteger(  tempId->getInteger()
+                               + children[i]->children[1]->children[1]->value.L);
+        }
+    }
+
+    // And the final test, which was true.
+    if (recording != nullptr)
+    {
+        recording->countSubtree(children[0]);
+        recording->taken(children[0]);
+    }
+
+    variableId->setValue(count);
+    return Object();
+}
+
+long Executor::tripCount(double count, double limit, double step)
+{
+    // The body can't change the control variable, and the limit is a
+    // constant or the parser's hidden variable, which the body can't
+    // assign either. So the trip count is known before the first trip.
+    // Not a number makes none.
+    double span = step > 0 ? limit - count : count - limit;
+    return   !(span >= 0)    ? 0
+           : span < LONG_MAX ? (long) floor(span) + 1
+           :                   LONG_MAX;
+}
+
+void Executor::countFused(Node *node)
+{
+    // A recording counts the nodes that a superinstruction stands for
+    // but doesn't visit, so that the profile of the fused tree is the
+    // profile of the tree as parsed.
+    for (Node *child : node->children)
+    {
+        if (child != nullptr) recording->countSubtree(child);
+    }
 }
 
 void Executor::runtimeError(Node *node, string message)
 {
-    printf("RUNTIME ERROR at line %d: %s: %s\n",
-           lineNumber, message.c_str(), node->text.c_str());
-    exit(-2);
+    int lineNumber = lines != nullptr ? lines->lineNumber(offset) : 0;
+
+    *out << "RUNTIME ERROR at line " << lineNumber << ": " << message
+         << ": " << node->text << endl;
+    throw RuntimeError(lineNumber, message);
 }
 
 }  // namespace backend
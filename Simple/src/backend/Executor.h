@@ -8,6 +8,7 @@
 #ifndef EXECUTOR_H_
 #define EXECUTOR_H_
 
+#include <iostream>
 #include <string>
 #include <vector>
 #include <set>
@@ -15,6 +16,10 @@
 #include "../Object.h"
 #include "../intermediate/Symtab.h"
 #include "../intermediate/Node.h"
+#include "../intermediate/LineMap.h"
+#include "Profiler.h"
+#include "ExecutionProfile.h"
+#include "RuntimeError.h"
 
 namespace backend {
 
@@ -24,22 +29,78 @@ using namespace intermediate;
 class Executor
 {
 private:
-    int lineNumber;
+    int offset;          // source offset of the current statement
     Symtab *symtab;
+    LineMap *lines;      // for runtime error messages
+    Profiler *profiler;  // null unless profiling
+    ExecutionProfile *recording;  // null unless recording execution counts
+    ostream *out;        // where the program's output goes
 
 public:
+    Executor(Symtab *symtab)
+        : offset(-1), symtab(symtab), lines(nullptr), profiler(nullptr),
+          recording(nullptr), out(&cout) {}
+
+    // Allocate executors from the executors' allocator.
+    static void *operator new(size_t size)
+    {
+        return Allocator::allocate<Executor>(Subsystem::EXECUTOR, size);
+    }
+    static void operator delete(void *executor, size_t size)
+    {
+        Allocator::release(Subsystem::EXECUTOR, executor, size);
+    }
+
     /**
-     * Initialize the static sets.
+     * Send the program's output and runtime errors somewhere other
+     * than cout.
+     * @param out the output stream.
      */
-    static void initialize();
+    void setOutput(ostream *out) { this->out = out; }
 
-    Executor(Symtab *symtab) : lineNumber(0), symtab(symtab) {}
+    /**
+     * Set the source's line map, used only to report runtime errors.
+     * @param lines the line map.
+     */
+    void setLineMap(LineMap *lines) { this->lines = lines; }
+
+    /**
+     * Attach a profiler. It only collects data if the executor
+     * was compiled with SIMPLE_PROFILE.
+     * @param profiler the profiler.
+     */
+    void setProfiler(Profiler *profiler) { this->profiler = profiler; }
+
+    /**
+     * Record how often each node runs and each loop test is true.
+     * @param recording the execution profile to count into.
+     */
+    void setRecording(ExecutionProfile *recording)
+    {
+        this->recording = recording;
+    }
+
+    /**
+     * Execute a program.
+     * @param programNode the root of the program's parse tree.
+     * @return 0, or RuntimeError::STATUS if there was a runtime error.
+     */
+    int execute(Node *programNode);
 
     Object visit(Node *node);
 
+    /**
+     * Count the trips of a counted loop.
+     * @param count the control variable's value before the first trip.
+     * @param limit the value of the loop's limit.
+     * @param step 1 to count up or -1 to count down.
+     * @return the count of trips.
+     */
+    static long tripCount(double count, double limit, double step);
+
 private:
-    static set<NodeType> singletons;   // singleton factors
-    static set<NodeType> relationals;  // relational operators
+    static const set<NodeType> singletons;   // singleton factors
+    static const set<NodeType> relationals;  // relational operators
 
     Object visitProgram(Node *programNode);
     Object visitStatement(Node *statementNode);
@@ -51,11 +112,21 @@ private:
     Object visitWriteln(Node *writelnNode);
     Object visitExpression(Node *expressionNode);
     Object visitVariable(Node *variableNode);
+    long visitInteger(Node *node);
+    double visitReal(Node *node);
+    bool visitCondition(Node *node);
     Object visitIntegerConstant(Node *integerConstantNode);
     Object visitRealConstant(Node *realConstantNode);
     Object visitStringConstant(Node *stringConstantNode);
 
-    void printValue(vector<Node *> children);
+    // Superinstructions.
+    Object visitAssignVarOpConst(Node *assignNode);
+    Object visitTestVarConst(Node *testNode);
+    Object visitWriteVar(Node *writeNode);
+    Object visitCountedLoop(Node *loopNode);
+
+    void countFused(Node *node);
+    void printValue(NodeList &children);
     void runtimeError(Node *node, string message);
 };
 
@@ -0,0 +1,1152 @@
+/**
+ * JIT compiler class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <cstring>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "../intermediate/Symtab.h"
+#include "../intermediate/Node.h"
+#include "RuntimeError.h"
+#include "Executor.h"
+#include "Jit.h"
+
+namespace backend {
+
+using namespace std;
+using namespace intermediate;
+
+// SSE registers xmm0 through xmm14 hold the REAL operands of an
+// expression, one per nesting level. xmm15 is a scratch register.
+static const int REGISTER_COUNT = 15;
+static const int SCRATCH = 15;
+
+// General purpose registers hold the INTEGER operands, also one per
+// nesting level: rax, rcx, rdx, rsi, rdi, r8 through r11, and r13,
+// which the prologue saves. No call is made within an expression.
+static const int INTEGER_REGISTERS[] = { 0, 1, 2, 6, 7, 8, 9, 10, 11, 13 };
+static const int INTEGER_REGISTER_COUNT =
+    sizeof(INTEGER_REGISTERS)/sizeof(INTEGER_REGISTERS[0]);
+
+// Condition codes of the x86 Jcc instructions.
+enum Condition : uint8_t
+{
+    OVERFLOW = 0x0,
+    BELOW = 0x2, ABOVE_EQUAL = 0x3, EQUAL = 0x4, NOT_EQUAL = 0x5,
+    BELOW_EQUAL = 0x6, ABOVE = 0x7, PARITY = 0xA, NOT_PARITY = 0xB,
+    LESS = 0xC, GREATER_EQUAL = 0xD, LESS_EQUAL = 0xE, GREATER = 0xF
+};
+
+/**
+ * Emits the few x86-64 instructions that the compiler needs into a
+ * byte buffer, with forward jumps to labels and a constant pool
+ * addressed relative to the instruction pointer.
+ */
+class Assembler
+{
+public:
+    vector<uint8_t> bytes;
+    vector<pair<int, Node *>> divisionChecks;  // error label, DIVIDE node
+    vector<pair<int, Node *>> overflowChecks;  // error label, operator node
+
+private:
+    vector<int> labels;                  // position of each label, or -1
+    vector<pair<int, int>> jumps;        // rel32 position, label
+    vector<double> constants;
+    vector<pair<int, int>> constantUses; // disp32 position, constant index
+
+    void byte(uint8_t b) { bytes.push_back(b); }
+
+    void int32(int32_t value)
+    {
+        for (int i = 0; i < 4; i++) byte((value >> (8*i)) & 0xFF);
+    }
+
+    void int64(uint64_t value)
+    {
+        for (int i = 0; i < 8; i++) byte((value >> (8*i)) & 0xFF);
+    }
+
+    void patch32(int at, int32_t value)
+    {
+        for (int i = 0; i < 4; i++) bytes[at + i] = (value >> (8*i)) & 0xFF;
+    }
+
+    // A REX prefix for registers 8-15, if needed.
+    void rex(int reg, int rm, bool always = false)
+    {
+        uint8_t prefix = 0x40 | ((reg >> 3) << 2) | (rm >> 3);
+        if (always || (prefix != 0x40)) byte(prefix);
+    }
+
+    // A REX prefix for 64-bit operands.
+    void rexW(int reg, int rm)
+    {
+        byte(0x48 | ((reg >> 3) << 2) | (rm >> 3));
+    }
+
+public:
+    // SSE scalar double operations.
+    static const uint8_t LOAD = 0x10, STORE = 0x11, ADD = 0x58, MULTIPLY = 0x59,
+                         SUBTRACT = 0x5C, DIVIDE = 0x5E;
+
+    // 64-bit integer operations.
+    static const uint8_t INTEGER_ADD = 0x01, INTEGER_SUBTRACT = 0x29,
+                         INTEGER_COMPARE = 0x39,
+                         INTEGER_STORE = 0x89, INTEGER_LOAD = 0x8B;
+
+    int newLabel()
+    {
+        labels.push_back(-1);
+        return labels.size() - 1;
+    }
+
+    void bind(int label) { labels[label] = bytes.size(); }
+
+    /**
+     * Pad with NOPs to a multiple of an alignment, such as for the
+     * top of a loop. The code's memory starts on a page.
+     */
+    void align(size_t alignment)
+    {
+        while (bytes.size()%alignment != 0) byte(0x90);
+    }
+
+    /**
+     * op xmm(reg), xmm(rm) with the F2 prefix of the scalar doubles.
+     */
+    void sse(uint8_t op, int reg, int rm)
+    {
+        byte(0xF2); rex(reg, rm); byte(0x0F); byte(op);
+        byte(0xC0 | ((reg & 7) << 3) | (rm & 7));
+    }
+
+    /**
+     * op xmm(reg), [r12 + slot*8] to load, or the reverse to store.
+     */
+    void sseFrame(uint8_t op, int reg, int slot)
+    {
+        byte(0xF2); rex(reg, 12); byte(0x0F); byte(op);
+        byte(0x84 | ((reg & 7) << 3)); byte(0x24); int32(slot*8);
+    }
+
+    /**
+     * op xmm(reg), [rip + constant].
+     */
+    void sseConstant(uint8_t op, int reg, double value)
+    {
+        int index = -1;
+        for (size_t i = 0; i < constants.size(); i++)
+        {
+            if (memcmp(&constants[i], &value, sizeof(double)) == 0) index = i;
+        }
+        if (index < 0)
+        {
+            constants.push_back(value);
+            index = constants.size() - 1;
+        }
+
+        byte(0xF2); rex(reg, 0); byte(0x0F); byte(op);
+        byte(0x05 | ((reg & 7) << 3));
+        constantUses.push_back(make_pair(bytes.size(), index));
+        int32(0);
+    }
+
+    /**
+     * op r(rm), r(reg) to add, subtract or compare.
+     */
+    void integer(uint8_t op, int rm, int reg)
+    {
+        rexW(reg, rm); byte(op);
+        byte(0xC0 | ((reg & 7) << 3) | (rm & 7));
+    }
+
+    // imul r(reg), r(rm)
+    void multiplyInteger(int reg, int rm)
+    {
+        rexW(reg, rm); byte(0x0F); byte(0xAF);
+        byte(0xC0 | ((reg & 7) << 3) | (rm & 7));
+    }
+
+    /**
+     * mov r(reg), [r12 + slot*8] to load, or the reverse to store.
+     */
+    void integerFrame(uint8_t op, int reg, int slot)
+    {
+        rexW(reg, 12); byte(op);
+        byte(0x84 | ((reg & 7) << 3)); byte(0x24); int32(slot*8);
+    }
+
+    // mov r(reg), imm64
+    void integerConstant(int reg, int64_t value)
+    {
+        rexW(0, reg); byte(0xB8 | (reg & 7)); int64(value);
+    }
+
+    // cvtsi2sd xmm(xmm), r(reg)
+    void toDouble(int xmm, int reg)
+    {
+        byte(0xF2); rexW(xmm, reg); byte(0x0F); byte(0x2A);
+        byte(0xC0 | ((xmm & 7) << 3) | (reg & 7));
+    }
+
+    // cvttsd2si r(reg), xmm(xmm), which truncates like a cast to long
+    void toInteger(int reg, int xmm)
+    {
+        byte(0xF2); rexW(reg, xmm); byte(0x0F); byte(0x2C);
+        byte(0xC0 | ((reg & 7) << 3) | (xmm & 7));
+    }
+
+    // ucomisd xmm(a), xmm(b)
+    void compare(int a, int b)
+    {
+        byte(0x66); rex(a, b); byte(0x0F); byte(0x2E);
+        byte(0xC0 | ((a & 7) << 3) | (b & 7));
+    }
+
+    // xorpd xmm(reg), xmm(reg)
+    void zero(int reg)
+    {
+        byte(0x66); rex(reg, reg); byte(0x0F); byte(0x57);
+        byte(0xC0 | ((reg & 7) << 3) | (reg & 7));
+    }
+
+    // mov dword [r12 + slot*8], value
+    void storeInt(int slot, int32_t value)
+    {
+        byte(0x41); byte(0xC7); byte(0x84); byte(0x24);
+        int32(slot*8); int32(value);
+    }
+
+    void jump(int label)
+    {
+        byte(0xE9);
+        jumps.push_back(make_pair(bytes.size(), label));
+        int32(0);
+    }
+
+    void jumpIf(Condition condition, int label)
+    {
+        byte(0x0F); byte(0x80 | condition);
+        jumps.push_back(make_pair(bytes.size(), label));
+        int32(0);
+    }
+
+    /**
+     * Call a runtime function with the Jit in rdi and up to two
+     * integer or pointer arguments in rsi and rdx.
+     */
+    void call(const void *function, uint64_t argument1 = 0,
+              int32_t argument2 = 0)
+    {
+        byte(0x48); byte(0x89); byte(0xDF);                   // mov rdi, rbx
+        byte(0x48); byte(0xBE); int64(argument1);             // mov rsi, imm64
+        byte(0xBA); int32(argument2);                         // mov edx, imm32
+        byte(0x48); byte(0xB8); int64((uint64_t) function);   // mov rax, imm64
+        byte(0xFF); byte(0xD0);                               // call rax
+    }
+
+    // test eax, eax
+    void testResult() { byte(0x85); byte(0xC0); }
+
+    // The frame is in r12 and the Jit in rbx, both callee-saved.
+    // Three pushes leave the stack 16-byte aligned for calls.
+    void prologue()
+    {
+        byte(0x53);                                 // push rbx
+        byte(0x41); byte(0x54);                     // push r12
+        byte(0x41); byte(0x55);                     // push r13
+        byte(0x48); byte(0x89); byte(0xFB);         // mov rbx, rdi
+        byte(0x49); byte(0x89); byte(0xF4);         // mov r12, rsi
+    }
+
+    void epilogue(int32_t status)
+    {
+        byte(0xB8); int32(status);                  // mov eax, status
+        byte(0x41); byte(0x5D);                     // pop r13
+        byte(0x41); byte(0x5C);                     // pop r12
+        byte(0x5B);                                 // pop rbx
+        byte(0xC3);                                 // ret
+    }
+
+    /**
+     * Resolve the jumps, append the constant pool and resolve its uses.
+     */
+    void finish()
+    {
+        for (auto &jump : jumps)
+        {
+            patch32(jump.first, labels[jump.second] - (jump.first + 4));
+        }
+
+        while (bytes.size()%8 != 0) byte(0xCC);  // int3
+
+        int poolAt = bytes.size();
+        for (double value : constants)
+        {
+            uint64_t bits;
+            memcpy(&bits, &value, sizeof(double));
+            int64(bits);
+        }
+
+        for (auto &use : constantUses)
+        {
+            patch32(use.first, poolAt + use.second*8 - (use.first + 4));
+        }
+    }
+};
+
+Jit::Jit(Symtab *symtab)
+    : symtab(symtab), executor(symtab), lines(nullptr), out(&cout),
+      profile(nullptr), offsetSlot(-1), mayFail(false), code(nullptr),
+      codeSize(0), entry(nullptr), fallbackCount(0)
+{
+}
+
+Jit::~Jit()
+{
+    if (code != nullptr) munmap(code, codeSize);
+}
+
+void Jit::setOutput(ostream *out)
+{
+    this->out = out;
+    executor.setOutput(out);
+}
+
+void Jit::setLineMap(LineMap *lines)
+{
+    this->lines = lines;
+    executor.setLineMap(lines);
+}
+
+void Jit::setProfile(const ExecutionProfile *profile)
+{
+    this->profile = profile;
+}
+
+bool Jit::compile(Node *programNode)
+{
+    if (!ENABLED) return false;
+
+    Assembler assembler;
+    int errorExit = assembler.newLabel();
+
+    // Keep the current statement's offset only if a runtime error
+    // can report it.
+    mayFail = canFail(programNode);
+    offsetSlot = newSlot();
+
+    assembler.prologue();
+    compileStatement(assembler, programNode->children[0]);
+    assembler.epilogue(0);
+
+    // The division checks jump out of line to report the error.
+    for (auto &check : assembler.divisionChecks)
+    {
+        assembler.bind(check.first);
+        assembler.call((const void *) &Jit::divisionByZero,
+                       (uint64_t) check.second);
+        assembler.jump(errorExit);
+    }
+    for (auto &check : assembler.overflowChecks)
+    {
+        assembler.bind(check.first);
+        assembler.call((const void *) &Jit::integerOverflow,
+                       (uint64_t) check.second);
+        assembler.jump(errorExit);
+    }
+
+    assembler.bind(errorExit);
+    assembler.epilogue(RuntimeError::STATUS);
+    assembler.finish();
+
+    // Copy the code into fresh pages that are then made executable,
+    // but never writable and executable at the same time.
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    codeSize = (assembler.bytes.size() + pageSize - 1)/pageSize*pageSize;
+    code = mmap(nullptr, codeSize, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == MAP_FAILED)
+    {
+        code = nullptr;
+        return false;
+    }
+
+    memcpy(code, assembler.bytes.data(), assembler.bytes.size());
+    if (mprotect(code, codeSize, PROT_READ | PROT_EXEC) != 0) return false;
+
+    entry = (Entry) code;
+    writePerfMap(programNode->text);
+
+    return true;
+}
+
+int Jit::run()
+{
+    // Start with the variables' current values
+    // and leave them with their final values.
+    loadFrame();
+    int status = entry(this, frame.data());
+    storeFrame();
+
+    return status;
+}
+
+void Jit::loadFrame()
+{
+    for (size_t slot = 0; slot < entries.size(); slot++)
+    {
+        SymtabEntry *variableId = entries[slot];
+        if (variableId == nullptr) continue;
+
+        if (variableId->getType() == ValueType::INTEGER)
+        {
+            long value = variableId->getInteger();
+            memcpy(&frame[slot], &value, sizeof(long));
+        }
+        else frame[slot] = variableId->getValue();
+    }
+}
+
+void Jit::storeFrame()
+{
+    for (size_t slot = 0; slot < entries.size(); slot++)
+    {
+        SymtabEntry *variableId = entries[slot];
+        if (variableId == nullptr) continue;
+
+        if (variableId->getType() == ValueType::INTEGER)
+        {
+            long value;
+            memcpy(&value, &frame[slot], sizeof(long));
+            variableId->setInteger(value);
+        }
+        else variableId->setValue(frame[slot]);
+    }
+}
+
+int Jit::slotOf(Node *variableNode)
+{
+    // The executor looks variables up by their text, so do the same.
+    SymtabEntry *variableId = symtab->lookup(variableNode->text);
+    if (variableId == nullptr) return -1;
+
+    auto found = slots.find(variableId);
+    if (found != slots.end()) return found->second;
+
+    int slot = newSlot();
+    slots[variableId] = slot;
+    entries[slot] = variableId;
+
+    return slot;
+}
+
+bool Jit::isInteger(Node *variableNode)
+{
+    SymtabEntry *variableId = symtab->lookup(variableNode->text);
+    return (variableId != nullptr) && (variableId->getType() == ValueType::INTEGER);
+}
+
+int Jit::newSlot()
+{
+    entries.push_back(nullptr);
+    frame.push_back(0.0);
+
+    return frame.size() - 1;
+}
+
+bool Jit::canFail(Node *node) const
+{
+    if (node == nullptr) return false;
+
+    if (node->type == DIVIDE)
+    {
+        Node *divisor = node->children[1];
+        bool constant =    (divisor->type == INTEGER_CONSTANT)
+                        || (divisor->type == REAL_CONSTANT);
+
+        if (!constant || (divisor->value.D == 0.0)) return true;
+    }
+
+    // INTEGER arithmetic can overflow.
+    bool arithmetic =    (node->type == ADD) || (node->type == SUBTRACT)
+                      || (node->type == MULTIPLY);
+    if (arithmetic && (node->valueType == ValueType::INTEGER)) return true;
+
+    for (Node *child : node->children)
+    {
+        if (canFail(child)) return true;
+    }
+
+    return false;
+}
+
+bool Jit::isArithmetic(Node *node, int depth, bool integer)
+{
+    if ((node == nullptr) || (depth >= REGISTER_COUNT)) return false;
+
+    bool arithmetic =    (node->type == ADD) || (node->type == SUBTRACT)
+                      || (node->type == MULTIPLY);
+
+    // Evaluated in integers, as by the executor's visitInteger(),
+    // or a variable converted from them.
+    if (arithmetic && (node->valueType == ValueType::INTEGER)) integer = true;
+    bool general =    integer
+                   || ((node->type == VARIABLE) && isInteger(node));
+    if (general && (depth >= INTEGER_REGISTER_COUNT)) return false;
+
+    switch (node->type)
+    {
+        case VARIABLE :         return slotOf(node) >= 0;
+        case INTEGER_CONSTANT :
+        case REAL_CONSTANT :    return true;
+
+        case ADD :
+        case SUBTRACT :
+        case MULTIPLY :
+            return    isArithmetic(node->children[0], depth, integer)
+                   && isArithmetic(node->children[1], depth + 1, integer);
+
+        case DIVIDE :
+            return    isArithmetic(node->children[0], depth, false)
+                   && isArithmetic(node->children[1], depth + 1, false);
+
+        default : return false;
+    }
+}
+
+bool Jit::isIntegerComparison(Node *node) const
+{
+    // The executor compares in integers only if both operands are typed so.
+    return    (node->children[0]->valueType == ValueType::INTEGER)
+           && (node->children[1]->valueType == ValueType::INTEGER);
+}
+
+bool Jit::isCondition(Node *node)
+{
+    if (node == nullptr) return false;
+
+    switch (node->type)
+    {
+        case NodeType::NOT : return isCondition(node->children[0]);
+
+        case EQ :
+        case LT :
+        case GT :
+        {
+            bool integer = isIntegerComparison(node);
+            return    isArithmetic(node->children[0], 0, integer)
+                   && isArithmetic(node->children[1], 1, integer);
+        }
+
+        default : return false;
+    }
+}
+
+bool Jit::isWriteArgument(Node *node) const
+{
+    // A field width or count of decimal places that's known in advance.
+    // The executor takes a variable's as 0.
+    return    (node->type == INTEGER_CONSTANT) || (node->type == REAL_CONSTANT)
+           || (node->type == VARIABLE);
+}
+
+bool Jit::isCompiled(Node *statementNode)
+{
+    switch (statementNode->type)
+    {
+        case COMPOUND : return true;
+
+        case ASSIGN :
+        case ASSIGN_VAR_OP_CONST :
+            return    (slotOf(statementNode->children[0]) >= 0)
+                   && isArithmetic(statementNode->children[1], 0,
+                                   isInteger(statementNode->children[0]));
+
+        case LOOP :
+        {
+            for (Node *child : statementNode->children)
+            {
+                if (child == nullptr) return false;
+
+                bool test = (child->type == TEST) || (child->type == TEST_VAR_CONST);
+                if (test && !isCondition(child->children[0])) return false;
+            }
+
+            return true;
+        }
+
+        case COUNTED_LOOP :
+        {
+            Node *compareNode = statementNode->children[0]->children[0];
+            return    (slotOf(compareNode->children[0]) >= 0)
+                   && isArithmetic(compareNode->children[1], 0,
+                                   isIntegerCount(compareNode));
+        }
+
+        case WRITE :
+        case WRITELN :
+        {
+            NodeList &children = statementNode->children;
+            if (children.empty()) return statementNode->type == WRITELN;
+
+            for (size_t i = 1; i < children.size(); i++)
+            {
+                if (!isWriteArgument(children[i])) return false;
+            }
+
+            return    (children[0]->type == STRING_CONSTANT)
+                   || (   (children[0]->type == VARIABLE)
+                       && (slotOf(children[0]) >= 0));
+        }
+
+        case WRITE_VAR : return slotOf(statementNode->children[0]) >= 0;
+
+        default : return false;
+    }
+}
+
+void Jit::compileStatement(Assembler &code, Node *statementNode)
+{
+    if (statementNode == nullptr) return;
+
+    // Code that never ran isn't worth compiling.
+    bool cold = (profile != nullptr) && profile->isCold(statementNode);
+
+    if (cold || !isCompiled(statementNode))
+    {
+        compileFallback(code, statementNode);
+        return;
+    }
+
+    // The executor notes where each statement but a counted loop is.
+    if (mayFail && (statementNode->type != COUNTED_LOOP))
+    {
+        code.storeInt(offsetSlot, statementNode->offset);
+    }
+
+    switch (statementNode->type)
+    {
+        case COMPOUND :
+            for (Node *child : statementNode->children)
+            {
+                compileStatement(code, child);
+            }
+            break;
+
+        case ASSIGN :
+        case ASSIGN_VAR_OP_CONST : compileAssign(code, statementNode);      break;
+        case LOOP :                compileLoop(code, statementNode);        break;
+        case COUNTED_LOOP :        compileCountedLoop(code, statementNode); break;
+        case WRITE :               compileWrite(code, statementNode, false); break;
+        case WRITELN :             compileWrite(code, statementNode, true);  break;
+        case WRITE_VAR :
+            compileWrite(code, statementNode, statementNode->value.B);
+            break;
+
+        default : break;
+    }
+}
+
+void Jit::compileAssign(Assembler &code, Node *assignNode)
+{
+    Node *variableNode = assignNode->children[0];
+    Node *exprNode     = assignNode->children[1];
+    int slot           = slotOf(variableNode);
+
+    // The executor assigns an INTEGER variable in integers.
+    if (isInteger(variableNode))
+    {
+        compileInteger(code, exprNode, 0);
+        code.integerFrame(Assembler::INTEGER_STORE, INTEGER_REGISTERS[0], slot);
+    }
+    else
+    {
+        compileExpression(code, exprNode, 0);
+        code.sseFrame(Assembler::STORE, 0, slot);
+    }
+}
+
+Node *Jit::rotatedTest(Node *loopNode) const
+{
+    if (profile == nullptr) return nullptr;
+
+    // The loop's only test, if it's first or last and usually false.
+    Node *testNode = nullptr;
+    for (Node *child : loopNode->children)
+    {
+        if ((child->type == TEST) || (child->type == TEST_VAR_CONST))
+        {
+            if (testNode != nullptr) return nullptr;
+            testNode = child;
+        }
+    }
+
+    if (testNode == nullptr) return nullptr;
+
+    bool end =    (testNode == loopNode->children.front())
+               || (testNode == loopNode->children.back());
+
+    return end && profile->usuallyContinues(testNode) ? testNode : nullptr;
+}
+
+void Jit::compileLoop(Assembler &code, Node *loopNode)
+{
+    Node *testNode = rotatedTest(loopNode);
+    if (testNode != nullptr)
+    {
+        compileRotatedLoop(code, loopNode, testNode);
+        return;
+    }
+
+    int top  = code.newLabel();
+    int exit = code.newLabel();
+
+    // Run the statements and tests in order. Stop when a test is true.
+    code.bind(top);
+    for (Node *child : loopNode->children)
+    {
+        if ((child->type == TEST) || (child->type == TEST_VAR_CONST))
+        {
+            compileBranch(code, child->children[0], true, exit);
+        }
+        else compileStatement(code, child);
+    }
+
+    code.jump(top);
+    code.bind(exit);
+}
+
+void Jit::compileRotatedLoop(Assembler &code, Node *loopNode, Node *testNode)
+{
+    int top   = code.newLabel();
+    int check = code.newLabel();
+
+    // Enter at the test if it comes first. Loop back while it's false,
+    // to a top aligned for fetching, and fall through to the exit
+    // when it's true.
+    if (testNode == loopNode->children.front()) code.jump(check);
+
+    code.align(16);
+    code.bind(top);
+    for (Node *child : loopNode->children)
+    {
+        if (child != testNode) compileStatement(code, child);
+    }
+
+    code.bind(check);
+    compileBranch(code, testNode->children[0], false, top);
+}
+
+bool Jit::isIntegerCount(Node *compareNode)
+{
+    // An INTEGER control variable counts in integers
+    // up or down to a limit that's also typed INTEGER.
+    return    isInteger(compareNode->children[0])
+           && (compareNode->children[1]->valueType == ValueType::INTEGER);
+}
+
+void Jit::compileCountedLoop(Assembler &code, Node *loopNode)
+{
+    Node *compareNode = loopNode->children[0]->children[0];
+    Node *bodyNode    = loopNode->children[1];
+    int variable      = slotOf(compareNode->children[0]);
+    int limit         = newSlot();
+    double step       = loopNode->value.D;
+    bool integer      = isInteger(compareNode->children[0]);
+    bool integerCount = isIntegerCount(compareNode);
+    int count         = INTEGER_REGISTERS[0];
+    int last          = INTEGER_REGISTERS[1];
+
+    int top  = code.newLabel();
+    int exit = code.newLabel();
+
+    // Evaluate the limit once. The body doesn't assign the control
+    // variable, so it can count in place.
+    if (integerCount)
+    {
+        compileInteger(code, compareNode->children[1], 0);
+        code.integerFrame(Assembler::INTEGER_STORE, count, limit);
+    }
+    else
+    {
+        compileExpression(code, compareNode->children[1], 0);
+        code.sseFrame(Assembler::STORE, 0, limit);
+    }
+
+    code.bind(top);
+
+    // Up: continue while count <= limit. Down: while count >= limit.
+    if (integerCount)
+    {
+        code.integerFrame(Assembler::INTEGER_LOAD, count, variable);
+        code.integerFrame(Assembler::INTEGER_LOAD, last, limit);
+        code.integer(Assembler::INTEGER_COMPARE, count, last);
+        code.jumpIf(step > 0 ? GREATER : LESS, exit);
+    }
+    else
+    {
+        // Either comparison is false if one is not a number.
+        compileExpression(code, compareNode->children[0], 0);
+        code.sseFrame(Assembler::LOAD, 1, limit);
+
+        if (step > 0) code.compare(1, 0);
+        else          code.compare(0, 1);
+        code.jumpIf(BELOW, exit);
+    }
+
+    compileStatement(code, bodyNode);
+
+    // Step any induction temporaries.
+    for (size_t i = 3; i < loopNode->children.size(); i++)
+    {
+        compileStatement(code, loopNode->children[i]);
+    }
+
+    // A count past the largest integer is past every limit.
+    if (integer)
+    {
+        code.integerFrame(Assembler::INTEGER_LOAD, count, variable);
+        code.integerConstant(last, (int64_t) step);
+        code.integer(Assembler::INTEGER_ADD, count, last);
+        code.jumpIf(OVERFLOW, exit);
+        code.integerFrame(Assembler::INTEGER_STORE, count, variable);
+    }
+    else
+    {
+        code.sseFrame(Assembler::LOAD, 0, variable);
+        code.sseConstant(Assembler::ADD, 0, step);
+        code.sseFrame(Assembler::STORE, 0, variable);
+    }
+    code.jump(top);
+
+    code.bind(exit);
+}
+
+void Jit::compileWrite(Assembler &code, Node *writeNode, bool newline)
+{
+    NodeList &children = writeNode->children;
+
+    if ((writeNode->type != WRITE_VAR) && !children.empty())
+    {
+        int width  = children.size() > 1 ? children[1]->value.L : -1;
+        int places = children.size() > 2 ? children[2]->value.L : 0;
+
+        // The executor reads a variable's field width as 0.
+        if ((children.size() > 1) && (children[1]->type == VARIABLE)) width = 0;
+        if ((children.size() > 2) && (children[2]->type == VARIABLE)) places = 0;
+
+        if (children[0]->type == VARIABLE)
+        {
+            compileExpression(code, children[0], 0);
+            code.call((const void *) &Jit::writeNumber, width, places);
+        }
+        else
+        {
+            code.call((const void *) &Jit::writeString,
+                      (uint64_t) &children[0]->text, width);
+        }
+    }
+    else if (writeNode->type == WRITE_VAR)
+    {
+        compileExpression(code, children[0], 0);
+        code.call((const void *) &Jit::writeNumber, -1, 0);
+    }
+
+    if (newline) code.call((const void *) &Jit::writeLine);
+}
+
+void Jit::compileFallback(Assembler &code, Node *statementNode)
+{
+    int resume = code.newLabel();
+
+    // The executor returns nonzero after a runtime error.
+    code.call((const void *) &Jit::interpret, (uint64_t) statementNode);
+    code.testResult();
+    code.jumpIf(EQUAL, resume);
+    code.epilogue(RuntimeError::STATUS);
+    code.bind(resume);
+
+    fallbackCount++;
+}
+
+void Jit::compileExpression(Assembler &code, Node *node, int reg)
+{
+    switch (node->type)
+    {
+        case VARIABLE :
+            if (isInteger(node))
+            {
+                int general = INTEGER_REGISTERS[reg];
+                code.integerFrame(Assembler::INTEGER_LOAD, general, slotOf(node));
+                code.toDouble(reg, general);
+            }
+            else code.sseFrame(Assembler::LOAD, reg, slotOf(node));
+            return;
+
+        case INTEGER_CONSTANT :
+        case REAL_CONSTANT :
+            code.sseConstant(Assembler::LOAD, reg, node->value.D);
+            return;
+
+        default : break;
+    }
+
+    // Arithmetic typed INTEGER is done in integers.
+    if (node->valueType == ValueType::INTEGER)
+    {
+        compileInteger(code, node, reg);
+        code.toDouble(reg, INTEGER_REGISTERS[reg]);
+        return;
+    }
+
+    // Evaluate the right operand in the next register.
+    compileExpression(code, node->children[0], reg);
+    compileExpression(code, node->children[1], reg + 1);
+
+    switch (node->type)
+    {
+        case ADD :      code.sse(Assembler::ADD,      reg, reg + 1); break;
+        case SUBTRACT : code.sse(Assembler::SUBTRACT, reg, reg + 1); break;
+        case MULTIPLY : code.sse(Assembler::MULTIPLY, reg, reg + 1); break;
+
+        case DIVIDE :
+        {
+            Node *divisor = node->children[1];
+            bool constant =    (divisor->type == INTEGER_CONSTANT)
+                            || (divisor->type == REAL_CONSTANT);
+
+            // Check for a zero divisor unless it's a nonzero constant.
+            if (!constant || (divisor->value.D == 0.0))
+            {
+                int error = code.newLabel();
+                int ok    = code.newLabel();
+
+                code.zero(SCRATCH);
+                code.compare(reg + 1, SCRATCH);
+                code.jumpIf(PARITY, ok);
+                code.jumpIf(EQUAL, error);
+                code.bind(ok);
+                code.divisionChecks.push_back(make_pair(error, node));
+            }
+
+            code.sse(Assembler::DIVIDE, reg, reg + 1);
+            break;
+        }
+
+        default : break;
+    }
+}
+
+void Jit::compileInteger(Assembler &code, Node *node, int reg)
+{
+    int general = INTEGER_REGISTERS[reg];
+
+    switch (node->type)
+    {
+        // A REAL variable is truncated, like by getInteger().
+        case VARIABLE :
+            if (isInteger(node))
+            {
+                code.integerFrame(Assembler::INTEGER_LOAD, general, slotOf(node));
+            }
+            else
+            {
+                code.sseFrame(Assembler::LOAD, reg, slotOf(node));
+                code.toInteger(general, reg);
+            }
+            return;
+
+        case INTEGER_CONSTANT :
+            code.integerConstant(general, node->value.L);
+            return;
+
+        case ADD :
+        case SUBTRACT :
+        case MULTIPLY :
+            break;
+
+        // Any other operand is evaluated as a REAL and truncated.
+        default :
+            compileExpression(code, node, reg);
+            code.toInteger(general, reg);
+            return;
+    }
+
+    // Evaluate the right operand in the next register.
+    compileInteger(code, node->children[0], reg);
+    compileInteger(code, node->children[1], reg + 1);
+
+    int operand = INTEGER_REGISTERS[reg + 1];
+    switch (node->type)
+    {
+        case ADD :
+            code.integer(Assembler::INTEGER_ADD, general, operand);
+            break;
+        case SUBTRACT :
+            code.integer(Assembler::INTEGER_SUBTRACT, general, operand);
+            break;
+        default :
+            code.multiplyInteger(general, operand);
+            break;
+    }
+
+    int error = code.newLabel();
+    code.jumpIf(OVERFLOW, error);
+    code.overflowChecks.push_back(make_pair(error, node));
+}
+
+void Jit::compileBranch(Assembler &code, Node *node, bool when, int target)
+{
+    // Jump to the target if the condition's value is the same as when.
+    if (node->type == NodeType::NOT)
+    {
+        compileBranch(code, node->children[0], !when, target);
+        return;
+    }
+
+    if (isIntegerComparison(node))
+    {
+        compileInteger(code, node->children[0], 0);
+        compileInteger(code, node->children[1], 1);
+        code.integer(Assembler::INTEGER_COMPARE,
+                     INTEGER_REGISTERS[0], INTEGER_REGISTERS[1]);
+
+        switch (node->type)
+        {
+            case EQ : code.jumpIf(when ? EQUAL   : NOT_EQUAL,     target); break;
+            case LT : code.jumpIf(when ? LESS    : GREATER_EQUAL, target); break;
+            case GT : code.jumpIf(when ? GREATER : LESS_EQUAL,    target); break;
+
+            default : break;
+        }
+
+        return;
+    }
+
+    compileExpression(code, node->children[0], 0);
+    compileExpression(code, node->children[1], 1);
+
+    // After ucomisd, an unordered result sets ZF, PF and CF,
+    // so any comparison with a NaN is false.
+    switch (node->type)
+    {
+        case EQ :
+        {
+            code.compare(0, 1);
+            if (when)
+            {
+                int skip = code.newLabel();
+                code.jumpIf(PARITY, skip);
+                code.jumpIf(EQUAL, target);
+                code.bind(skip);
+            }
+            else
+            {
+                code.jumpIf(PARITY, target);
+                code.jumpIf(NOT_EQUAL, target);
+            }
+            break;
+        }
+
+        case LT :
+            code.compare(1, 0);
+            code.jumpIf(when ? ABOVE : BELOW_EQUAL, target);
+            break;
+
+        case GT :
+            code.compare(0, 1);
+            code.jumpIf(when ? ABOVE : BELOW_EQUAL, target);
+            break;
+
+        default : break;
+    }
+}
+
+void Jit::writePerfMap(string programName)
+{
+    // perf looks for /tmp/perf-<pid>.map: start, size and name in hex.
+    ofstream map("/tmp/perf-" + to_string(getpid()) + ".map", ios::app);
+    if (map.fail()) return;
+
+    map << hex << (uintptr_t) code << " " << codeSize << dec
+        << " simple:" << programName << endl;
+}
+
+void Jit::writeNumber(Jit *jit, double value, int width, int places)
+{
+    // Print the value like printf's %w.df format.
+    ostream &out = *jit->out;
+
+    out << fixed << setprecision(places);
+    if (width >= 0) out << setw(width);
+    out << value;
+}
+
+void Jit::writeString(Jit *jit, const ArenaString *value, int width)
+{
+    ostream &out = *jit->out;
+
+    if (width > 0) out << setw(width);
+    out << *value;
+}
+
+void Jit::writeLine(Jit *jit)
+{
+    *jit->out << endl;
+}
+
+int Jit::interpret(Jit *jit, Node *statementNode)
+{
+    // The executor keeps the variables in their symbol table entries.
+    jit->storeFrame();
+
+    // An exception can't unwind through the compiled code, so catch it here.
+    int status = 0;
+    try
+    {
+        jit->executor.visit(statementNode);
+    }
+    catch (RuntimeError &error)
+    {
+        status = RuntimeError::STATUS;
+    }
+
+    jit->loadFrame();
+    return status;
+}
+
+void Jit::divisionByZero(Jit *jit, Node *node)
+{
+    jit->runtimeError(node, "Division by zero");
+}
+
+void Jit::integerOverflow(Jit *jit, Node *node)
+{
+    jit->runtimeError(node, "Integer overflow");
+}
+
+void Jit::runtimeError(Node *node, string message)
+{
+    int offset;
+    memcpy(&offset, &frame[offsetSlot], sizeof(int));
+
+    int lineNumber = lines != nullptr ? lines->lineNumber(offset) : 0;
+
+    *out << "RUNTIME ERROR at line " << lineNumber << ": "
+         << message << ": " << node->text << endl;
+}
+
+}  // namespace backend
@@ -0,0 +1,172 @@
+/**
+ * JIT compiler class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef JIT_H_
+#define JIT_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "../intermediate/Symtab.h"
+#include "../intermediate/Node.h"
+#include "../intermediate/LineMap.h"
+#include "Executor.h"
+#include "ExecutionProfile.h"
+
+namespace backend {
+
+using namespace std;
+using namespace intermediate;
+
+class Assembler;
+
+/**
+ * Compiles a parse tree into x86-64 machine code in executable memory.
+ * Each variable lives in a slot of a frame array, an INTEGER one as a
+ * long and any other as a double. Like the executor, it evaluates
+ * INTEGER arithmetic in the general purpose registers with overflow
+ * checks, and REAL arithmetic in SSE registers. WRITE and WRITELN call
+ * back into the runtime. A statement that the compiler doesn't handle,
+ * such as one with an expression too deep for the registers, calls back
+ * into an executor that interprets just that statement.
+ *
+ * With an execution profile, a statement that never ran is left to the
+ * executor instead of compiled, and a loop that usually continues
+ * branches once per trip, back to its top while its test is false.
+ *
+ * Each compiled program is listed in /tmp/perf-<pid>.map
+ * so that perf can name its samples.
+ */
+class Jit
+{
+public:
+    // Whether this machine can run the compiled code.
+#if defined(__x86_64__) && defined(__linux__)
+    static const bool ENABLED = true;
+#else
+    static const bool ENABLED = false;
+#endif
+
+private:
+    typedef int (*Entry)(Jit *jit, double *frame);
+
+    Symtab *symtab;
+    Executor executor;              // interprets the uncompiled statements
+    LineMap *lines;                 // for runtime error messages
+    ostream *out;                   // where the program's output goes
+    const ExecutionProfile *profile;  // null unless tuning by a profile
+
+    map<SymtabEntry *, int> slots;  // the frame slot of each variable
+    vector<SymtabEntry *> entries;  // the variable in each slot, if any
+    vector<double> frame;           // longs in the INTEGER slots
+    int offsetSlot;                 // the current statement's source offset
+    bool mayFail;                   // whether any division is unchecked
+
+    void *code;                     // the executable memory
+    size_t codeSize;
+    Entry entry;
+    int fallbackCount;              // statements left to the executor
+
+public:
+    Jit(Symtab *symtab);
+    ~Jit();
+
+    // Allocate executors from the executors' allocator.
+    static void *operator new(size_t size)
+    {
+        return Allocator::allocate<Jit>(Subsystem::EXECUTOR, size);
+    }
+    static void operator delete(void *executor, size_t size)
+    {
+        Allocator::release(Subsystem::EXECUTOR, executor, size);
+    }
+
+    /**
+     * Send the program's output and runtime errors somewhere other
+     * than cout.
+     * @param out the output stream.
+     */
+    void setOutput(ostream *out);
+
+    /**
+     * Set the source's line map, used only to report runtime errors.
+     * @param lines the line map.
+     */
+    void setLineMap(LineMap *lines);
+
+    /**
+     * Tune the compiled code by the counts of earlier runs.
+     * @param profile the execution profile of the parse tree to compile.
+     */
+    void setProfile(const ExecutionProfile *profile);
+
+    /**
+     * Compile a program.
+     * @param programNode the root of the program's parse tree,
+     *                    after any superinstructions were fused.
+     * @return true if successful, false if the program must be
+     *         interpreted instead.
+     */
+    bool compile(Node *programNode);
+
+    /**
+     * Run the compiled program.
+     * @return 0, or RuntimeError::STATUS if there was a runtime error.
+     */
+    int run();
+
+    /**
+     * Getter.
+     * @return the count of statements compiled as executor calls.
+     */
+    int getFallbackCount() const { return fallbackCount; }
+
+private:
+    int slotOf(Node *variableNode);
+    int newSlot();
+    bool isInteger(Node *variableNode);
+    void loadFrame();
+    void storeFrame();
+
+    bool canFail(Node *node) const;
+    bool isArithmetic(Node *node, int depth, bool integer);
+    bool isIntegerComparison(Node *node) const;
+    bool isIntegerCount(Node *compareNode);
+    bool isCondition(Node *node);
+    bool isWriteArgument(Node *node) const;
+    bool isCompiled(Node *statementNode);
+    Node *rotatedTest(Node *loopNode) const;
+
+    void compileStatement(Assembler &code, Node *statementNode);
+    void compileAssign(Assembler &code, Node *assignNode);
+    void compileLoop(Assembler &code, Node *loopNode);
+    void compileRotatedLoop(Assembler &code, Node *loopNode, Node *testNode);
+    void compileCountedLoop(Assembler &code, Node *loopNode);
+    void compileWrite(Assembler &code, Node *writeNode, bool newline);
+    void compileFallback(Assembler &code, Node *statementNode);
+    void compileExpression(Assembler &code, Node *node, int reg);
+    void compileInteger(Assembler &code, Node *node, int reg);
+    void compileBranch(Assembler &code, Node *node, bool when, int target);
+
+    void writePerfMap(string programName);
+
+    // Called from the compiled code.
+    static void writeNumber(Jit *jit, double value, int width, int places);
+    static void writeString(Jit *jit, const ArenaString *value, int width);
+    static void writeLine(Jit *jit);
+    static int interpret(Jit *jit, Node *statementNode);
+    static void divisionByZero(Jit *jit, Node *node);
+    static void integerOverflow(Jit *jit, Node *node);
+
+    void runtimeError(Node *node, string message);
+};
+
+}  // namespace backend
+
+#endif /* JIT_H_ */
@@ -0,0 +1,701 @@
+/**
+ * Lane executor class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdio>
+#include <cstdint>
+#include <climits>
+#include <algorithm>
+#include <cmath>
+
+#include "../intermediate/Symtab.h"
+#include "../intermediate/Node.h"
+#include "RuntimeError.h"
+#include "Executor.h"
+#include "LaneExecutor.h"
+
+namespace backend {
+
+using namespace std;
+using namespace intermediate;
+
+vector<LaneResult> LaneExecutor::execute(Node *programNode,
+                                         const vector<string> &columns,
+                                         const vector<vector<double>> &rows)
+{
+    vector<LaneResult> allResults(rows.size());
+
+    // The columns take the first slots, in order.
+    vector<int> columnSlots;
+    for (const string &column : columns) columnSlots.push_back(slotOf(column));
+    collect(programNode);
+
+    for (size_t first = 0; first < rows.size(); first += LANES)
+    {
+        laneCount = min((size_t) LANES, rows.size() - first);
+        results = &allResults[first];
+        offset = -1;
+
+        // Every variable starts at zero unless its column sets it.
+        for (size_t slot = 0; slot < integral.size(); slot++)
+        {
+            if (integral[slot]) integers[slot].assign(laneCount, 0);
+            else                variables[slot].assign(laneCount, 0.0);
+        }
+        for (int lane = 0; lane < laneCount; lane++)
+        {
+            const vector<double> &row = rows[first + lane];
+            for (size_t c = 0; (c < row.size()) && (c < columns.size()); c++)
+            {
+                if (columnSlots[c] >= 0) store(columnSlots[c], lane, row[c]);
+            }
+        }
+
+        alive.assign(laneCount, 1);
+        executeStatement(programNode->children[0], alive);
+
+        for (int lane = 0; lane < laneCount; lane++)
+        {
+            LaneResult &result = results[lane];
+            for (int slot : reported)
+            {
+                result.values.push_back(load(slot, lane));
+            }
+        }
+    }
+
+    return allResults;
+}
+
+int LaneExecutor::slotOf(string name)
+{
+    // The executor looks variables up by their text, so do the same.
+    SymtabEntry *variableId = symtab->lookup(name);
+    if (variableId == nullptr) return -1;
+
+    auto found = slots.find(variableId);
+    if (found != slots.end()) return found->second;
+
+    int slot = integral.size();
+    slots[variableId] = slot;
+    integral.push_back(variableId->getType() == ValueType::INTEGER);
+    variables.push_back(vector<double>());
+    integers.push_back(vector<long>());
+
+    // The results don't report the parser's hidden variables.
+    if (name[0] != '$')
+    {
+        names.push_back(name);
+        reported.push_back(slot);
+    }
+
+    return slot;
+}
+
+double LaneExecutor::load(int slot, int lane) const
+{
+    return integral[slot] ? (double) integers[slot][lane]
+                          : variables[slot][lane];
+}
+
+void LaneExecutor::store(int slot, int lane, double value)
+{
+    // Like a symbol table entry, an INTEGER variable truncates.
+    if (integral[slot]) integers[slot][lane] = (long) value;
+    else                variables[slot][lane] = value;
+}
+
+void LaneExecutor::collect(Node *node)
+{
+    if (node == nullptr) return;
+    if (node->type == VARIABLE) slotOf(node->text);
+
+    for (Node *child : node->children) collect(child);
+}
+
+/**
+ * Append a number like printf's %w.df format.
+ * @param output the output to append to.
+ * @param fieldWidth the field width.
+ * @param decimalPlaces the count of decimal places.
+ * @param value the number.
+ */
+static void format(string &output, long fieldWidth, long decimalPlaces,
+                   double value)
+{
+    char buffer[64];
+    int length = snprintf(buffer, sizeof(buffer), "%*.*f", (int) fieldWidth,
+                          (int) decimalPlaces, value);
+
+    if (length < (int) sizeof(buffer))
+    {
+        output.append(buffer, length);
+    }
+    else
+    {
+        size_t start = output.size();
+        output.resize(start + length + 1);
+        snprintf(&output[start], length + 1, "%*.*f", (int) fieldWidth,
+                 (int) decimalPlaces, value);
+        output.resize(start + length);
+    }
+}
+
+LaneExecutor::Mask LaneExecutor::live(const Mask &mask) const
+{
+    Mask active(laneCount);
+    for (int lane = 0; lane < laneCount; lane++)
+    {
+        active[lane] = mask[lane] & alive[lane];
+    }
+
+    return active;
+}
+
+bool LaneExecutor::any(const Mask &mask) const
+{
+    return find(mask.begin(), mask.end(), 1) != mask.end();
+}
+
+void LaneExecutor::executeStatement(Node *statementNode, const Mask &mask)
+{
+    if ((statementNode == nullptr) || !any(mask)) return;
+
+    offset = statementNode->offset;
+
+    switch (statementNode->type)
+    {
+        case COMPOUND :
+        {
+            // A lane that fails stops running the statements after it.
+            for (Node *child : statementNode->children)
+            {
+                executeStatement(child, live(mask));
+            }
+            break;
+        }
+
+        // A superinstruction's children are as they were parsed.
+        case ASSIGN :
+        case ASSIGN_VAR_OP_CONST : executeAssign(statementNode, mask);      break;
+        case LOOP :                executeLoop(statementNode, mask);        break;
+        case COUNTED_LOOP :        executeCountedLoop(statementNode, mask); break;
+
+        case WRITE :
+        case WRITELN :
+        case WRITE_VAR :           executeWrite(statementNode, mask);       break;
+
+        default : break;
+    }
+}
+
+void LaneExecutor::executeAssign(Node *assignNode, const Mask &mask)
+{
+    int slot = slotOf(assignNode->children[0]->text);
+    if (slot < 0) return;
+
+    // Store into only the active lanes that are still alive.
+    // An INTEGER variable is only ever assigned an INTEGER expression.
+    const uint8_t *active = mask.data();
+    const uint8_t *ok     = alive.data();
+
+    if (integral[slot])
+    {
+        const long *value = evaluateInteger(assignNode->children[1], 0, mask);
+        long *variable = integers[slot].data();
+
+        for (int lane = 0; lane < laneCount; lane++)
+        {
+            variable[lane] = active[lane] & ok[lane] ? value[lane] : variable[lane];
+        }
+    }
+    else
+    {
+        const double *value = evaluate(assignNode->children[1], 0, mask);
+        double *variable = variables[slot].data();
+
+        for (int lane = 0; lane < laneCount; lane++)
+        {
+            variable[lane] = active[lane] & ok[lane] ? value[lane] : variable[lane];
+        }
+    }
+}
+
+void LaneExecutor::executeLoop(Node *loopNode, const Mask &mask)
+{
+    Mask running = live(mask);  // lanes still in the loop
+
+    while (any(running))
+    {
+        for (Node *node : loopNode->children)
+        {
+            if ((node->type == TEST) || (node->type == TEST_VAR_CONST))
+            {
+                // A lane whose test is true leaves the loop.
+                const uint8_t *done = test(node->children[0], 0, running);
+                for (int lane = 0; lane < laneCount; lane++)
+                {
+                    running[lane] &= (done[lane] == 0) & alive[lane];
+                }
+            }
+            else
+            {
+                executeStatement(node, running);
+                running = live(running);
+            }
+
+            if (!any(running)) break;
+        }
+    }
+}
+
+void LaneExecutor::executeCountedLoop(Node *loopNode, const Mask &mask)
+{
+    NodeList &children = loopNode->children;
+    Node *compareNode = children[0]->children[0];
+    int slot = slotOf(compareNode->children[0]->text);
+    double step = loopNode->value.D;
+    bool observable = loopNode->value.B;
+
+    // Like the executor, evaluate the limit once and count each lane's
+    // trips before the first. Store the control variable only if the
+    // body reads it, and once more at the end.
+    Mask entered = live(mask);
+    const double *limit = evaluate(compareNode->children[1], 0, entered);
+
+    vector<double> counts(laneCount);
+    vector<long> trips(laneCount);
+    Mask running = live(entered);  // lanes with trips to go
+
+    for (int lane = 0; lane < laneCount; lane++)
+    {
+        if (!running[lane]) continue;
+
+        counts[lane]  = load(slot, lane);
+        trips[lane]   = Executor::tripCount(counts[lane], limit[lane], step);
+        running[lane] = trips[lane] > 0;
+    }
+
+    while (any(running))
+    {
+        if (observable)
+        {
+            for (int lane = 0; lane < laneCount; lane++)
+            {
+                if (running[lane]) store(slot, lane, counts[lane]);
+            }
+        }
+
+        executeStatement(children[1], running);
+
+        // Any induction temporaries step along with the control variable.
+        for (size_t i = 3; i < children.size(); i++)
+        {
+            executeStatement(children[i], live(running));
+        }
+
+        running = live(running);
+        for (int lane = 0; lane < laneCount; lane++)
+        {
+            if (!running[lane]) continue;
+
+            counts[lane] += step;
+            running[lane] = --trips[lane] > 0;
+        }
+    }
+
+    for (int lane = 0; lane < laneCount; lane++)
+    {
+        if (entered[lane] && alive[lane]) store(slot, lane, counts[lane]);
+    }
+}
+
+void LaneExecutor::executeWrite(Node *writeNode, const Mask &mask)
+{
+    NodeList &children = writeNode->children;
+    Mask active = mask;
+
+    if (!children.empty())
+    {
+        // A field width or count of decimal places is the integer value
+        // of its node, which the executor takes as 0 for an expression.
+        auto integerValue = [](Node *node)
+        {
+            return    (node->type == INTEGER_CONSTANT)
+                   || (node->type == REAL_CONSTANT)
+                   || (node->type == STRING_CONSTANT) ? node->value.L : 0;
+        };
+
+        long fieldWidth    = children.size() > 1 ? integerValue(children[1]) : -1;
+        long decimalPlaces = children.size() > 2 ? integerValue(children[2]) : 0;
+
+        Node *valueNode = children[0];
+
+        if (valueNode->type == VARIABLE)
+        {
+            // Print each lane's value like printf's %w.df format.
+            const double *value = evaluate(valueNode, 0, mask);
+            for (int lane = 0; lane < laneCount; lane++)
+            {
+                if (!active[lane]) continue;
+
+                format(results[lane].output, fieldWidth >= 0 ? fieldWidth : 0,
+                       decimalPlaces, value[lane]);
+            }
+        }
+        else
+        {
+            // The executor prints any other expression's string value,
+            // which is empty unless it's a string constant.
+            string text;
+            if (valueNode->type == STRING_CONSTANT) text = valueNode->text;
+            else
+            {
+                evaluate(valueNode, 0, mask);
+                active = live(mask);
+            }
+
+            if (fieldWidth > (long) text.size())
+            {
+                text.insert(0, fieldWidth - text.size(), ' ');
+            }
+
+            for (int lane = 0; lane < laneCount; lane++)
+            {
+                if (active[lane]) results[lane].output += text;
+            }
+        }
+    }
+
+    // A WRITE_VAR node caches whether to end the line.
+    bool endLine =    (writeNode->type == WRITELN)
+                   || ((writeNode->type == WRITE_VAR) && writeNode->value.B);
+    if (endLine)
+    {
+        for (int lane = 0; lane < laneCount; lane++)
+        {
+            if (active[lane]) results[lane].output += '\n';
+        }
+    }
+}
+
+const double *LaneExecutor::evaluate(Node *node, int depth, const Mask &mask)
+{
+    switch (node->type)
+    {
+        case VARIABLE :
+        {
+            // No copy: a REAL variable's lanes are the operand.
+            int slot = slotOf(node->text);
+            if ((slot >= 0) && !integral[slot]) return variables[slot].data();
+
+            double *result = scratchValues(depth);
+            if (slot < 0) fill(result, result + laneCount, 0.0);
+            else
+            {
+                const long *value = integers[slot].data();
+                for (int i = 0; i < laneCount; i++) result[i] = (double) value[i];
+            }
+            return result;
+        }
+
+        case INTEGER_CONSTANT :
+        case REAL_CONSTANT :
+        {
+            double *result = scratchValues(depth);
+            fill(result, result + laneCount, node->value.D);
+            return result;
+        }
+
+        case ADD :
+        case SUBTRACT :
+        case MULTIPLY :
+        case DIVIDE :
+        case INTEGER_DIVIDE :
+        case MODULO :
+            break;
+
+        default :
+        {
+            // A relational or NOT has no numeric value, nor does a string,
+            // but the operands can still fail.
+            bool logical =    (node->type == EQ) || (node->type == LT)
+                           || (node->type == GT) || (node->type == NodeType::NOT);
+            if (logical) test(node, depth, mask);
+
+            double *result = scratchValues(depth);
+            fill(result, result + laneCount, 0.0);
+            return result;
+        }
+    }
+
+    // In integers if it's typed INTEGER, like the executor.
+    if (node->valueType == ValueType::INTEGER)
+    {
+        const long *value = evaluateInteger(node, depth, mask);
+        double *result = scratchValues(depth);
+
+        for (int i = 0; i < laneCount; i++) result[i] = (double) value[i];
+        return result;
+    }
+
+    const double *value1 = evaluate(node->children[0], depth, mask);
+    const double *value2 = evaluate(node->children[1], depth + 1, mask);
+    double *result = scratchValues(depth);
+
+    // Compute every lane, active or not. Only an active lane that's
+    // still alive can fail, and only its result is used.
+    switch (node->type)
+    {
+        case ADD :
+            for (int i = 0; i < laneCount; i++) result[i] = value1[i] + value2[i];
+            break;
+
+        case SUBTRACT :
+            for (int i = 0; i < laneCount; i++) result[i] = value1[i] - value2[i];
+            break;
+
+        case MULTIPLY :
+            for (int i = 0; i < laneCount; i++) result[i] = value1[i] * value2[i];
+            break;
+
+        case DIVIDE :
+        case INTEGER_DIVIDE :
+        case MODULO :
+        {
+            for (int lane = 0; lane < laneCount; lane++)
+            {
+                if (mask[lane] && alive[lane] && (value2[lane] == 0.0))
+                {
+                    runtimeError(lane, node, "Division by zero");
+                }
+            }
+
+            // Untyped DIV and MOD, as the executor computes them.
+            if (node->type == DIVIDE)
+            {
+                for (int i = 0; i < laneCount; i++) result[i] = value1[i] / value2[i];
+            }
+            else if (node->type == INTEGER_DIVIDE)
+            {
+                for (int i = 0; i < laneCount; i++) result[i] = trunc(value1[i] / value2[i]);
+            }
+            else
+            {
+                for (int i = 0; i < laneCount; i++) result[i] = fmod(value1[i], value2[i]);
+            }
+            break;
+        }
+
+        default : break;
+    }
+
+    return result;
+}
+
+const long *LaneExecutor::evaluateInteger(Node *node, int depth,
+                                          const Mask &mask)
+{
+    switch (node->type)
+    {
+        case VARIABLE :
+        {
+            // No copy: an INTEGER variable's lanes are the operand.
+            int slot = slotOf(node->text);
+            if ((slot >= 0) && integral[slot]) return integers[slot].data();
+            break;
+        }
+
+        case INTEGER_CONSTANT :
+        {
+            long *result = scratchIntegers(depth);
+            fill(result, result + laneCount, node->value.L);
+            return result;
+        }
+
+        case ADD :
+        case SUBTRACT :
+        case MULTIPLY :
+        case INTEGER_DIVIDE :
+        case MODULO :
+        {
+            const long *value1 = evaluateInteger(node->children[0], depth, mask);
+            const long *value2 = evaluateInteger(node->children[1], depth + 1, mask);
+            long *result = scratchIntegers(depth);
+
+            for (int lane = 0; lane < laneCount; lane++)
+            {
+                long operand1 = value1[lane];
+                long operand2 = value2[lane];
+                long value = 0;
+                bool zero = false, overflow = false;
+
+                switch (node->type)
+                {
+                    case ADD :
+                        overflow = __builtin_add_overflow(operand1, operand2, &value);
+                        break;
+
+                    case SUBTRACT :
+                        overflow = __builtin_sub_overflow(operand1, operand2, &value);
+                        break;
+
+                    case MULTIPLY :
+                        overflow = __builtin_mul_overflow(operand1, operand2, &value);
+                        break;
+
+                    default :
+                    {
+                        // Never divide in a lane that would trap,
+                        // even an inactive one.
+                        zero = operand2 == 0;
+                        overflow = (operand1 == LONG_MIN) && (operand2 == -1);
+                        if (!zero && !overflow)
+                        {
+                            value = node->type == INTEGER_DIVIDE ? operand1/operand2
+                                                                 : operand1%operand2;
+                        }
+                        break;
+                    }
+                }
+
+                result[lane] = value;
+                if (mask[lane] && alive[lane])
+                {
+                    if (zero)          runtimeError(lane, node, "Division by zero");
+                    else if (overflow) runtimeError(lane, node, "Integer overflow");
+                }
+            }
+
+            return result;
+        }
+
+        default : break;
+    }
+
+    // Any other value is truncated, like the executor's.
+    const double *value = evaluate(node, depth, mask);
+    long *result = scratchIntegers(depth);
+
+    for (int i = 0; i < laneCount; i++) result[i] = (long) value[i];
+    return result;
+}
+
+const uint8_t *LaneExecutor::test(Node *node, int depth, const Mask &mask)
+{
+    uint8_t *result = scratchConditions(depth);
+
+    switch (node->type)
+    {
+        case EQ :
+        case LT :
+        case GT :
+        {
+            // Integer comparisons, like the executor's.
+            Node *operand1 = node->children[0];
+            Node *operand2 = node->children[1];
+
+            if (   (operand1->valueType == ValueType::INTEGER)
+                && (operand2->valueType == ValueType::INTEGER))
+            {
+                const long *value1 = evaluateInteger(operand1, depth, mask);
+                const long *value2 = evaluateInteger(operand2, depth + 1, mask);
+
+                switch (node->type)
+                {
+                    case EQ :
+                        for (int i = 0; i < laneCount; i++) result[i] = value1[i] == value2[i];
+                        break;
+                    case LT :
+                        for (int i = 0; i < laneCount; i++) result[i] = value1[i] <  value2[i];
+                        break;
+                    case GT :
+                        for (int i = 0; i < laneCount; i++) result[i] = value1[i] >  value2[i];
+                        break;
+
+                    default : break;
+                }
+
+                return result;
+            }
+
+            const double *value1 = evaluate(node->children[0], depth, mask);
+            const double *value2 = evaluate(node->children[1], depth + 1, mask);
+
+            switch (node->type)
+            {
+                case EQ :
+                    for (int i = 0; i < laneCount; i++) result[i] = value1[i] == value2[i];
+                    break;
+                case LT :
+                    for (int i = 0; i < laneCount; i++) result[i] = value1[i] <  value2[i];
+                    break;
+                case GT :
+                    for (int i = 0; i < laneCount; i++) result[i] = value1[i] >  value2[i];
+                    break;
+
+                default : break;
+            }
+
+            return result;
+        }
+
+        case NodeType::NOT :
+        {
+            const uint8_t *value = test(node->children[0], depth, mask);
+            for (int i = 0; i < laneCount; i++) result[i] = !value[i];
+
+            return result;
+        }
+
+        default :
+        {
+            // A number or string is never true.
+            bool arithmetic =    (node->type == ADD) || (node->type == SUBTRACT)
+                              || (node->type == MULTIPLY) || (node->type == DIVIDE)
+                              || (node->type == INTEGER_DIVIDE)
+                              || (node->type == MODULO);
+            if (arithmetic) evaluate(node, depth, mask);
+
+            result = scratchConditions(depth);
+            fill(result, result + laneCount, 0);
+            return result;
+        }
+    }
+}
+
+double *LaneExecutor::scratchValues(int depth)
+{
+    while ((int) values.size() <= depth) values.push_back(vector<double>(LANES));
+    return values[depth].data();
+}
+
+long *LaneExecutor::scratchIntegers(int depth)
+{
+    while ((int) wholes.size() <= depth) wholes.push_back(vector<long>(LANES));
+    return wholes[depth].data();
+}
+
+uint8_t *LaneExecutor::scratchConditions(int depth)
+{
+    while ((int) conditions.size() <= depth) conditions.push_back(Mask(LANES));
+    return conditions[depth].data();
+}
+
+void LaneExecutor::runtimeError(int lane, Node *node, string message)
+{
+    int lineNumber = lines != nullptr ? lines->lineNumber(offset) : 0;
+
+    results[lane].output += "RUNTIME ERROR at line " + to_string(lineNumber)
+                          + ": " + message + ": " + (string) node->text + "\n";
+    results[lane].status = RuntimeError::STATUS;
+    alive[lane] = 0;
+}
+
+}  // namespace backend
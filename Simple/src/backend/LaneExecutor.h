@@ -0,0 +1,141 @@
+/**
+ * Lane executor class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef LANEEXECUTOR_H_
+#define LANEEXECUTOR_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+#include "../intermediate/Symtab.h"
+#include "../intermediate/Node.h"
+#include "../intermediate/LineMap.h"
+
+namespace backend {
+
+using namespace std;
+using namespace intermediate;
+
+/**
+ * The outcome of one run of a program by the lane executor.
+ */
+struct LaneResult
+{
+    int status;             // 0 or RuntimeError::STATUS
+    string output;          // everything the run printed
+    vector<double> values;  // final variable values, in variableNames() order
+};
+
+/**
+ * Runs one program over many sets of initial variable values at once.
+ * Each run is a lane. The variables are laid out structure-of-arrays,
+ * one array of lanes per variable, so every node is one pass over the
+ * lanes. An INTEGER variable's lanes are integers, and the executor's
+ * integer arithmetic, overflow checks and counted loops apply lane by
+ * lane, so a lane's run is the executor's run of the same tree.
+ *
+ * All the lanes of a block step through the statements together under
+ * a mask of the active lanes. A lane leaves a loop when its own test
+ * is true or its trips are done, and the loop repeats while any lane
+ * is still in it. A runtime error stops only the lane it happened in.
+ */
+class LaneExecutor
+{
+public:
+    static const int LANES = 256;  // lanes run together in one block
+
+private:
+    typedef vector<uint8_t> Mask;  // 1 for each active lane
+
+    Symtab *symtab;
+    LineMap *lines;                    // for runtime error messages
+    int offset;                        // source offset of the current statement
+
+    map<SymtabEntry *, int> slots;     // the slot of each variable
+    vector<bool> integral;             // whether each slot is INTEGER
+    vector<vector<double>> variables;  // REAL slots, by slot, then by lane
+    vector<vector<long>> integers;     // INTEGER slots, by slot, then by lane
+    vector<string> names;              // of the slots that results report
+    vector<int> reported;              // those slots, without hidden ones
+
+    vector<vector<double>> values;     // scratch operands, by depth
+    vector<vector<long>> wholes;       // scratch integer operands, by depth
+    vector<Mask> conditions;           // scratch conditions, by depth
+
+    Mask alive;                        // lanes without a runtime error
+    int laneCount;                     // lanes in the current block
+    LaneResult *results;               // of the current block
+
+public:
+    LaneExecutor(Symtab *symtab)
+        : symtab(symtab), lines(nullptr), offset(-1),
+          laneCount(0), results(nullptr) {}
+
+    // Allocate executors from the executors' allocator.
+    static void *operator new(size_t size)
+    {
+        return Allocator::allocate<LaneExecutor>(Subsystem::EXECUTOR, size);
+    }
+    static void operator delete(void *executor, size_t size)
+    {
+        Allocator::release(Subsystem::EXECUTOR, executor, size);
+    }
+
+    /**
+     * Set the source's line map, used only to report runtime errors.
+     * @param lines the line map.
+     */
+    void setLineMap(LineMap *lines) { this->lines = lines; }
+
+    /**
+     * Run a program once for each row of initial values.
+     * @param programNode the root of the program's parse tree.
+     * @param columns the names of the variables that each row sets.
+     * @param rows the initial values, one row per run.
+     * @return the result of each run, in row order.
+     */
+    vector<LaneResult> execute(Node *programNode,
+                               const vector<string> &columns,
+                               const vector<vector<double>> &rows);
+
+    /**
+     * Getter.
+     * @return the names of the variables, in the order of each
+     *         result's values: the columns, then the program's others.
+     */
+    const vector<string> &variableNames() const { return names; }
+
+private:
+    int slotOf(string name);
+    void collect(Node *node);
+
+    Mask live(const Mask &mask) const;
+    bool any(const Mask &mask) const;
+
+    void executeStatement(Node *statementNode, const Mask &mask);
+    void executeAssign(Node *assignNode, const Mask &mask);
+    void executeLoop(Node *loopNode, const Mask &mask);
+    void executeCountedLoop(Node *loopNode, const Mask &mask);
+    void executeWrite(Node *writeNode, const Mask &mask);
+
+    const double *evaluate(Node *node, int depth, const Mask &mask);
+    const long *evaluateInteger(Node *node, int depth, const Mask &mask);
+    const uint8_t *test(Node *node, int depth, const Mask &mask);
+    double load(int slot, int lane) const;
+    void store(int slot, int lane, double value);
+    double *scratchValues(int depth);
+    long *scratchIntegers(int depth);
+    uint8_t *scratchConditions(int depth);
+
+    void runtimeError(int lane, Node *node, string message);
+};
+
+}  // namespace backend
+
+#endif /* LANEEXECUTOR_H_ */
@@ -0,0 +1,844 @@
+/**
+ * Optimizer class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <tuple>
+#include <algorithm>
+#include <cstring>
+#include <climits>
+
+#include "../intermediate/Symtab.h"
+#include "../intermediate/Node.h"
+#include "Optimizer.h"
+
+namespace backend {
+
+using namespace std;
+using namespace intermediate;
+
+void Optimizer::optimize(Node *programNode)
+{
+    Node *compoundNode = programNode->children[0];
+
+    if (level >= LOOPS)                 optimizeLoops(compoundNode);
+    if (level >= COMMON_SUBEXPRESSIONS) numberList(compoundNode);
+
+    // Nothing is live after the program ends.
+    if (level >= DEAD_STORES) sweepList(compoundNode, Variables(), true);
+}
+
+SymtabEntry *Optimizer::entryOf(Node *variableNode)
+{
+    // The executor looks variables up by their text, so do the same.
+    return symtab->lookup(variableNode->text);
+}
+
+bool Optimizer::isStatementList(Node *node) const
+{
+    if ((node->type != COMPOUND) && (node->type != LOOP)) return false;
+
+    // An IF is parsed into a LOOP of expressions, which isn't one.
+    for (Node *child : node->children)
+    {
+        if (child == nullptr) return false;
+
+        switch (child->type)
+        {
+            case COMPOUND :
+            case ASSIGN :
+            case LOOP :
+            case TEST :
+            case WRITE :
+            case WRITELN : break;
+
+            default : return false;
+        }
+    }
+
+    return true;
+}
+
+bool Optimizer::isCountedLoop(Node *loopNode)
+{
+    // The shape Parser::parseForStatement desugars FOR into,
+    // and then any steps of the reduced multiplications.
+    if ((loopNode->type != LOOP) || (loopNode->children.size() < 3)) return false;
+
+    for (size_t i = 3; i < loopNode->children.size(); i++)
+    {
+        Node *stepNode = loopNode->children[i];
+        if ((stepNode == nullptr) || (stepNode->type != ASSIGN)) return false;
+    }
+
+    Node *testNode   = loopNode->children[0];
+    Node *assignNode = loopNode->children[2];
+
+    return    (testNode != nullptr) && (testNode->type == TEST)
+           && (assignNode != nullptr) && (assignNode->type == ASSIGN)
+           && (   (testNode->children[0]->type == GT)
+               || (testNode->children[0]->type == LT))
+           && (testNode->children[0]->children[0]->type == VARIABLE)
+           && (   testNode->children[0]->children[0]->text
+               == assignNode->children[0]->text);
+}
+
+bool Optimizer::isArithmetic(Node *node) const
+{
+    switch (node->type)
+    {
+        case ADD :
+        case SUBTRACT :
+        case MULTIPLY :
+        case DIVIDE :
+        case INTEGER_DIVIDE :
+        case MODULO : return true;
+
+        default : return false;
+    }
+}
+
+bool Optimizer::contains(Node *tree, Node *node) const
+{
+    if (tree == node) return true;
+
+    for (Node *child : tree->children)
+    {
+        if ((child != nullptr) && contains(child, node)) return true;
+    }
+
+    return false;
+}
+
+void Optimizer::collectReads(Node *node, Variables &reads)
+{
+    if (node == nullptr) return;
+
+    if (node->type == VARIABLE)
+    {
+        SymtabEntry *variableId = entryOf(node);
+        if (variableId != nullptr) reads.insert(variableId);
+    }
+
+    for (Node *child : node->children) collectReads(child, reads);
+}
+
+void Optimizer::collectAssigns(Node *node, Variables &assigns)
+{
+    if (node == nullptr) return;
+
+    if (node->type == ASSIGN)
+    {
+        SymtabEntry *variableId = entryOf(node->children[0]);
+        if (variableId != nullptr) assigns.insert(variableId);
+    }
+
+    for (Node *child : node->children) collectAssigns(child, assigns);
+}
+
+SymtabEntry *Optimizer::newTemporary(ValueType type)
+{
+    string name;
+    do name = "$t" + to_string(++tempCount); while (symtab->lookup(name) != nullptr);
+
+    SymtabEntry *tempId = symtab->enter(name);
+    tempId->setType(type);
+
+    return tempId;
+}
+
+Node *Optimizer::newVariable(SymtabEntry *variableId)
+{
+    Node *variableNode = new Node(VARIABLE);
+    variableNode->text      = variableId->getName();
+    variableNode->entry     = variableId;
+    variableNode->valueType = variableId->getType();
+
+    return variableNode;
+}
+
+Node *Optimizer::newAssign(SymtabEntry *variableId, Node *exprNode, int offset)
+{
+    Node *assignNode = new Node(ASSIGN);
+    assignNode->offset = offset;
+    assignNode->adopt(newVariable(variableId));
+    assignNode->adopt(exprNode);
+
+    return assignNode;
+}
+
+Node *Optimizer::newInteger(long value)
+{
+    Node *constantNode = new Node(INTEGER_CONSTANT);
+    constantNode->value.L   = value;
+    constantNode->value.D   = value;
+    constantNode->valueType = ValueType::INTEGER;
+
+    return constantNode;
+}
+
+void Optimizer::numberList(Node *listNode)
+{
+    // Only the body of a FOR, so that its test and step still fuse.
+    if (isCountedLoop(listNode))
+    {
+        Node *bodyNode = listNode->children[1];
+        if ((bodyNode->type == COMPOUND) || (bodyNode->type == LOOP))
+        {
+            numberList(bodyNode);
+        }
+
+        return;
+    }
+
+    if (!isStatementList(listNode))
+    {
+        for (Node *child : listNode->children)
+        {
+            if (   (child != nullptr)
+                && ((child->type == COMPOUND) || (child->type == LOOP)))
+            {
+                numberList(child);
+            }
+        }
+
+        return;
+    }
+
+    // Each pass through a list starts with no values known.
+    Block block;
+    NodeList &list = listNode->children;
+
+    for (size_t i = 0; i < list.size(); i++)
+    {
+        Node *statementNode = list[i];
+        size_t size = list.size();
+
+        switch (statementNode->type)
+        {
+            case ASSIGN :
+            {
+                Node *rhs = statementNode->children[1];
+                int rhsNumber = number(rhs, statementNode, block);
+                rewrite(rhs, list, block);
+
+                // Now the variable holds the expression's value,
+                // unless it converts it to its own type.
+                SymtabEntry *variableId = entryOf(statementNode->children[0]);
+                if (variableId == nullptr) break;
+
+                if (variableId->getType() == rhs->valueType)
+                {
+                    block.variables[variableId] = rhsNumber;
+                    block.holders[rhsNumber].push_back(variableId);
+                }
+                else block.variables[variableId] = nextNumber++;
+
+                break;
+            }
+
+            case TEST :
+            {
+                number(statementNode->children[0], statementNode, block);
+                rewrite(statementNode->children[0], list, block);
+                break;
+            }
+
+            case COMPOUND :
+            case LOOP :
+            {
+                numberList(statementNode);
+
+                // Forget the values of the variables assigned inside.
+                Variables assigns;
+                collectAssigns(statementNode, assigns);
+                for (SymtabEntry *variableId : assigns)
+                {
+                    block.variables[variableId] = nextNumber++;
+                }
+
+                break;
+            }
+
+            default : break;  // WRITE and WRITELN only read
+        }
+
+        // Skip over any temporaries assigned before this statement.
+        i += list.size() - size;
+    }
+}
+
+int Optimizer::number(Node *node, Node *statementNode, Block &block)
+{
+    int valueNumber;
+
+    // Find or make the value number of an operation on operands.
+    auto numberOf = [this, &block](Key key) -> int
+    {
+        auto found = block.expressions.find(key);
+        if (found != block.expressions.end()) return found->second;
+
+        return block.expressions[key] = nextNumber++;
+    };
+
+    switch (node->type)
+    {
+        case VARIABLE :
+        {
+            SymtabEntry *variableId = entryOf(node);
+            if (variableId == nullptr)
+            {
+                valueNumber = nextNumber++;
+                break;
+            }
+
+            auto found = block.variables.find(variableId);
+            valueNumber = found != block.variables.end()
+                              ? found->second
+                              : block.variables[variableId] = nextNumber++;
+            break;
+        }
+
+        case INTEGER_CONSTANT :
+        {
+            valueNumber = numberOf(Key((int) node->type, 0, node->value.L, 0));
+            break;
+        }
+
+        case REAL_CONSTANT :
+        {
+            long bits;
+            memcpy(&bits, &node->value.D, sizeof(long));
+            valueNumber = numberOf(Key((int) node->type, 0, bits, 0));
+            break;
+        }
+
+        default :
+        {
+            if (!isArithmetic(node))
+            {
+                for (Node *child : node->children)
+                {
+                    if (child != nullptr) number(child, statementNode, block);
+                }
+
+                valueNumber = nextNumber++;
+                break;
+            }
+
+            long number1 = number(node->children[0], statementNode, block);
+            long number2 = number(node->children[1], statementNode, block);
+
+            // + and * give the same value either way around.
+            if (   ((node->type == ADD) || (node->type == MULTIPLY))
+                && (number1 > number2))
+            {
+                swap(number1, number2);
+            }
+
+            size_t count = block.expressions.size();
+            valueNumber = numberOf(Key((int) node->type, (int) node->valueType,
+                                       number1, number2));
+
+            if (block.expressions.size() > count)
+            {
+                block.firsts[valueNumber] = node;
+                block.statements[node] = statementNode;
+            }
+
+            break;
+        }
+    }
+
+    block.numbers[node] = valueNumber;
+    return valueNumber;
+}
+
+void Optimizer::rewrite(Node *node, NodeList &list, Block &block)
+{
+    // Replace the largest expressions first.
+    if (isArithmetic(node) && replace(node, list, block)) return;
+
+    for (Node *child : node->children)
+    {
+        if (child != nullptr) rewrite(child, list, block);
+    }
+}
+
+bool Optimizer::replace(Node *node, NodeList &list, Block &block)
+{
+    ValueType type = node->valueType;
+    if ((type != ValueType::INTEGER) && (type != ValueType::REAL)) return false;
+
+    int valueNumber = block.numbers[node];
+
+    // A variable that still holds the value.
+    for (SymtabEntry *variableId : block.holders[valueNumber])
+    {
+        if (   (block.variables[variableId] == valueNumber)
+            && (variableId->getType() == type))
+        {
+            makeVariable(node, variableId);
+            eliminatedCount++;
+
+            return true;
+        }
+    }
+
+    // Else compute the value once into a temporary,
+    // unless this is where it's first computed.
+    auto found = block.firsts.find(valueNumber);
+    if ((found == block.firsts.end()) || (found->second == node)) return false;
+
+    makeVariable(node, hoist(found->second, list, block));
+    eliminatedCount++;
+
+    return true;
+}
+
+SymtabEntry *Optimizer::hoist(Node *first, NodeList &list, Block &block)
+{
+    SymtabEntry *tempId = newTemporary(first->valueType);
+
+    // Move the first expression into the temporary's assignment,
+    // just before the statement that computed it.
+    Node *statementNode = block.statements[first];
+
+    Node *exprNode = new Node(first->type);
+    exprNode->offset    = first->offset;
+    exprNode->text      = first->text;
+    exprNode->entry     = first->entry;
+    exprNode->value     = first->value;
+    exprNode->valueType = first->valueType;
+    exprNode->id        = first->id;
+    exprNode->children  = first->children;
+
+    Node *assignNode = newAssign(tempId, exprNode, statementNode->offset);
+    list.insert(find(list.begin(), list.end(), statementNode), assignNode);
+
+    // The firsts within the moved expression now belong to the assignment.
+    for (auto &owner : block.statements)
+    {
+        if ((owner.second == statementNode) && contains(exprNode, owner.first))
+        {
+            owner.second = assignNode;
+        }
+    }
+
+    int valueNumber = block.numbers[first];
+    block.numbers[exprNode] = valueNumber;
+    block.firsts.erase(valueNumber);
+    block.variables[tempId] = valueNumber;
+    block.holders[valueNumber].push_back(tempId);
+
+    makeVariable(first, tempId);
+    return tempId;
+}
+
+void Optimizer::makeVariable(Node *node, SymtabEntry *variableId)
+{
+    node->type  = VARIABLE;
+    node->text  = variableId->getName();
+    node->entry = variableId;
+    node->value = Object();
+    node->children.clear();
+}
+
+void Optimizer::optimizeLoops(Node *node)
+{
+    // Inner loops first.
+    for (Node *child : node->children)
+    {
+        if (child != nullptr) optimizeLoops(child);
+    }
+
+    if (!isForStatement(node)) return;
+
+    Node *initNode    = node->children[0];
+    Node *loopNode    = node->children[1];
+    Node *compareNode = loopNode->children[0]->children[0];
+    Node *startNode   = initNode->children[1];
+    Node *limitNode   = compareNode->children[1];
+    SymtabEntry *variableId = entryOf(initNode->children[0]);
+
+    // Count the trips between constants, unless the body
+    // changes the control variable.
+    Variables assigns;
+    collectAssigns(loopNode->children[1], assigns);
+
+    if (   (variableId == nullptr)
+        || (variableId->getType() != ValueType::INTEGER)
+        || (startNode->type != INTEGER_CONSTANT)
+        || (limitNode->type != INTEGER_CONSTANT)
+        || (assigns.find(variableId) != assigns.end())) return;
+
+    long start = startNode->value.L;
+    long limit = limitNode->value.L;
+    long step  = compareNode->type == GT ? 1 : -1;
+    long span;
+
+    if (__builtin_sub_overflow(step > 0 ? limit : start,
+                               step > 0 ? start : limit, &span)) return;
+
+    if (span == LONG_MAX) return;
+
+    long trips = span >= 0 ? span + 1 : 0;
+    long final = start + trips*step;
+
+    if (   (trips <= UNROLL_TRIPS)
+        && (trips*countNodes(loopNode->children[1]) <= UNROLL_NODES))
+    {
+        unroll(node, start, trips, step);
+    }
+    else reduce(node, start, final, step);
+}
+
+bool Optimizer::isForStatement(Node *node)
+{
+    // The COMPOUND of the control variable's initial assignment
+    // and the LOOP that Parser::parseForStatement desugars FOR into.
+    return    (node->type == COMPOUND) && (node->children.size() == 2)
+           && (node->children[0] != nullptr)
+           && (node->children[0]->type == ASSIGN)
+           && (node->children[1] != nullptr)
+           && isCountedLoop(node->children[1])
+           && (   node->children[0]->children[0]->text
+               == node->children[1]->children[2]->children[0]->text);
+}
+
+void Optimizer::unroll(Node *forNode, long start, long trips, long step)
+{
+    Node *loopNode = forNode->children[1];
+    Node *bodyNode = loopNode->children[1];
+    SymtabEntry *variableId = entryOf(forNode->children[0]->children[0]);
+
+    // WRITE and WRITELN can only print a variable, so set it
+    // before each trip if the body prints it.
+    bool printed = writes(bodyNode, variableId);
+    NodeList statements;
+
+    for (long trip = 0; trip < trips; trip++)
+    {
+        long value = start + trip*step;
+
+        if (printed)
+        {
+            statements.push_back(newAssign(variableId, newInteger(value),
+                                           forNode->offset));
+        }
+
+        Node *tripNode = copy(bodyNode);
+        substitute(tripNode, variableId, value);
+        statements.push_back(tripNode);
+    }
+
+    // The control variable ends one step past the last trip.
+    statements.push_back(newAssign(variableId,
+                                   newInteger(start + trips*step),
+                                   forNode->offset));
+
+    forNode->children = statements;
+    unrolledCount++;
+}
+
+void Optimizer::reduce(Node *forNode, long start, long final, long step)
+{
+    Node *initNode = forNode->children[0];
+    Node *loopNode = forNode->children[1];
+    SymtabEntry *variableId = entryOf(initNode->children[0]);
+
+    vector<Node *> products;
+    collectProducts(loopNode->children[1], variableId, products);
+
+    // One temporary for each constant factor.
+    map<long, vector<Node *>> factors;
+    for (Node *product : products)
+    {
+        Node *constantNode = product->children[0]->type == INTEGER_CONSTANT
+                                ? product->children[0] : product->children[1];
+        factors[constantNode->value.L].push_back(product);
+    }
+
+    for (auto &factor : factors)
+    {
+        long constant = factor.first;
+        long value, increment;
+
+        // Every product through the one past the last trip must fit,
+        // since the temporary is added to after the last trip too.
+        if (   __builtin_mul_overflow(start, constant, &value)
+            || __builtin_mul_overflow(final, constant, &value)
+            || __builtin_mul_overflow(step, constant, &increment)) continue;
+
+        SymtabEntry *tempId = newTemporary(ValueType::INTEGER);
+
+        // $t := variable*constant, after the variable's initial assignment.
+        Node *productNode = new Node(MULTIPLY);
+        productNode->valueType = ValueType::INTEGER;
+        productNode->adopt(newVariable(variableId));
+        productNode->adopt(newInteger(constant));
+        forNode->children.insert(forNode->children.begin() + 1,
+                                 newAssign(tempId, productNode,
+                                           forNode->offset));
+
+        for (Node *product : factor.second)
+        {
+            makeVariable(product, tempId);
+            reducedCount++;
+        }
+
+        // $t := $t + increment, after the step of each trip.
+        // A COUNTED_LOOP steps it along with the control variable.
+        Node *sumNode = new Node(ADD);
+        sumNode->valueType = ValueType::INTEGER;
+        sumNode->adopt(newVariable(tempId));
+        sumNode->adopt(newInteger(increment));
+        loopNode->adopt(newAssign(tempId, sumNode, -1));
+    }
+}
+
+Node *Optimizer::copy(Node *node)
+{
+    if (node == nullptr) return nullptr;
+
+    Node *copyNode = new Node(node->type);
+    copyNode->offset    = node->offset;
+    copyNode->text      = node->text;
+    copyNode->entry     = node->entry;
+    copyNode->value     = node->value;
+    copyNode->valueType = node->valueType;
+    copyNode->id        = node->id;
+
+    for (Node *child : node->children) copyNode->adopt(copy(child));
+
+    return copyNode;
+}
+
+void Optimizer::substitute(Node *node, SymtabEntry *variableId, long value)
+{
+    // WRITE and WRITELN can only print a variable.
+    if ((node->type == WRITE) || (node->type == WRITELN)) return;
+
+    for (size_t i = 0; i < node->children.size(); i++)
+    {
+        Node *child = node->children[i];
+        if (child == nullptr) continue;
+
+        if ((child->type == VARIABLE) && (entryOf(child) == variableId))
+        {
+            node->children[i] = newInteger(value);
+        }
+        else substitute(child, variableId, value);
+    }
+}
+
+void Optimizer::collectProducts(Node *node, SymtabEntry *variableId,
+                                vector<Node *> &products)
+{
+    if (node == nullptr) return;
+
+    if ((node->type == MULTIPLY) && (node->valueType == ValueType::INTEGER))
+    {
+        Node *operand1 = node->children[0];
+        Node *operand2 = node->children[1];
+
+        auto isVariable = [this, variableId](Node *operand)
+        {
+            return    (operand->type == VARIABLE)
+                   && (entryOf(operand) == variableId);
+        };
+
+        if (   (isVariable(operand1) && (operand2->type == INTEGER_CONSTANT))
+            || (isVariable(operand2) && (operand1->type == INTEGER_CONSTANT)))
+        {
+            products.push_back(node);
+            return;
+        }
+    }
+
+    for (Node *child : node->children) collectProducts(child, variableId, products);
+}
+
+bool Optimizer::writes(Node *node, SymtabEntry *variableId)
+{
+    if (node == nullptr) return false;
+
+    if ((node->type == WRITE) || (node->type == WRITELN))
+    {
+        Variables reads;
+        collectReads(node, reads);
+        return reads.find(variableId) != reads.end();
+    }
+
+    for (Node *child : node->children)
+    {
+        if (writes(child, variableId)) return true;
+    }
+
+    return false;
+}
+
+int Optimizer::countNodes(Node *node) const
+{
+    if (node == nullptr) return 0;
+
+    int count = 1;
+    for (Node *child : node->children) count += countNodes(child);
+
+    return count;
+}
+
+Optimizer::Variables Optimizer::sweepList(Node *listNode, Variables live,
+                                          bool remove)
+{
+    if (listNode->type == LOOP) return sweepLoop(listNode, live, remove);
+
+    if (!isStatementList(listNode))
+    {
+        collectReads(listNode, live);
+        return live;
+    }
+
+    return sweep(listNode->children, live, nullptr, remove, remove);
+}
+
+Optimizer::Variables Optimizer::sweepLoop(Node *loopNode, Variables liveAfter,
+                                          bool remove)
+{
+    if (!isStatementList(loopNode))
+    {
+        collectReads(loopNode, liveAfter);
+        return liveAfter;
+    }
+
+    // What's live at the bottom of the body is also live at its top,
+    // through the back edge. Iterate until that stops growing.
+    Variables liveTop;
+    for (;;)
+    {
+        Variables liveBottom = liveAfter;
+        liveBottom.insert(liveTop.begin(), liveTop.end());
+
+        Variables live = sweep(loopNode->children, liveBottom, &liveAfter,
+                               false, false);
+        if (live == liveTop) break;
+
+        liveTop = live;
+    }
+
+    if (remove)
+    {
+        Variables liveBottom = liveAfter;
+        liveBottom.insert(liveTop.begin(), liveTop.end());
+
+        // Keep a FOR's body in place so that it can still fuse.
+        sweep(loopNode->children, liveBottom, &liveAfter,
+              !isCountedLoop(loopNode), true);
+    }
+
+    return liveTop;
+}
+
+Optimizer::Variables Optimizer::sweep(NodeList &list, Variables live,
+                                      const Variables *liveAtExit,
+                                      bool removeHere, bool remove)
+{
+    for (int i = list.size() - 1; i >= 0; i--)
+    {
+        Node *statementNode = list[i];
+
+        switch (statementNode->type)
+        {
+            case ASSIGN :
+            {
+                SymtabEntry *variableId = entryOf(statementNode->children[0]);
+                Node *rhs = statementNode->children[1];
+
+                if (   removeHere && (variableId != nullptr)
+                    && (live.find(variableId) == live.end()) && !canFail(rhs))
+                {
+                    list.erase(list.begin() + i);
+                    deadStoreCount++;
+
+                    break;
+                }
+
+                if (variableId != nullptr) live.erase(variableId);
+                collectReads(rhs, live);
+                break;
+            }
+
+            case TEST :
+            {
+                // A test can leave the loop.
+                if (liveAtExit != nullptr)
+                {
+                    live.insert(liveAtExit->begin(), liveAtExit->end());
+                }
+
+                collectReads(statementNode, live);
+                break;
+            }
+
+            case COMPOUND :
+            case LOOP :
+                live = sweepList(statementNode, live, remove);
+                break;
+
+            default :
+                collectReads(statementNode, live);
+                break;
+        }
+    }
+
+    return live;
+}
+
+bool Optimizer::canFail(Node *node) const
+{
+    if (node == nullptr) return false;
+
+    switch (node->type)
+    {
+        case DIVIDE :
+        case INTEGER_DIVIDE :
+        case MODULO :
+        {
+            // Only a nonzero constant divisor is safe, and for DIV
+            // not -1, whose quotient can overflow.
+            Node *divisor = node->children[1];
+            bool constant =    (divisor->type == INTEGER_CONSTANT)
+                            || (divisor->type == REAL_CONSTANT);
+
+            if (!constant || (divisor->value.D == 0.0)) return true;
+            if ((node->type != DIVIDE) && (divisor->value.D == -1.0)) return true;
+            break;
+        }
+
+        case ADD :
+        case SUBTRACT :
+        case MULTIPLY :
+        {
+            // Integers can overflow.
+            if (node->valueType == ValueType::INTEGER) return true;
+            break;
+        }
+
+        default : break;
+    }
+
+    for (Node *child : node->children)
+    {
+        if (canFail(child)) return true;
+    }
+
+    return false;
+}
+
+}  // namespace backend
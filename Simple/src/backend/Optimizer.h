@@ -0,0 +1,172 @@
+/**
+ * Optimizer class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef OPTIMIZER_H_
+#define OPTIMIZER_H_
+
+#include <vector>
+#include <map>
+#include <set>
+#include <tuple>
+
+#include "../intermediate/Symtab.h"
+#include "../intermediate/Node.h"
+
+namespace backend {
+
+using namespace std;
+using namespace intermediate;
+
+/**
+ * Optimize the statement lists of a type-checked parse tree, the
+ * children of each COMPOUND and LOOP node, before any other pass.
+ *
+ * Level 1 eliminates common subexpressions by local value numbering.
+ * An arithmetic expression whose value a variable still holds becomes
+ * that variable. One that's computed again but not held is computed
+ * once into a new temporary variable $tn, assigned just before the
+ * statement that first computed it.
+ *
+ * Level 2 also removes dead stores: assignments to a variable that
+ * is assigned again, or never read, before it's next read. A loop's
+ * liveness includes its back edge. An assignment that could raise a
+ * runtime error, by a division or an integer overflow, is kept.
+ *
+ * Level 3 also optimizes each desugared FOR whose control variable is
+ * an INTEGER that counts between constants, so that its trip count is
+ * known. A FOR of a few trips over a small body is unrolled into a
+ * copy of the body per trip, with the control variable replaced by
+ * its value. Otherwise each multiplication of the control variable by
+ * a constant becomes a temporary that's added to on every trip, by an
+ * assignment appended to the LOOP after its step.
+ * These run first, to give the other passes straight-line code.
+ *
+ * The test and step of a desugared FOR are left alone so that the
+ * loop can still be fused into a COUNTED_LOOP.
+ */
+class Optimizer
+{
+public:
+    static const int NONE = 0;
+    static const int COMMON_SUBEXPRESSIONS = 1;
+    static const int DEAD_STORES = 2;
+    static const int LOOPS = 3;
+
+    static const int UNROLL_TRIPS = 8;    // most trips of a loop to unroll
+    static const int UNROLL_NODES = 256;  // most nodes to unroll it into
+
+private:
+    typedef set<SymtabEntry *> Variables;
+    typedef tuple<int, int, long, long> Key;  // node type, value type, operands
+
+    /**
+     * The value numbers of one statement list.
+     */
+    struct Block
+    {
+        map<SymtabEntry *, int> variables;    // the value number of each variable
+        map<Key, int> expressions;            // the value number of each expression
+        map<int, Node *> firsts;              // the first expression of each number
+        map<Node *, Node *> statements;       // the statement of each first
+        map<int, vector<SymtabEntry *>> holders;  // the variables assigned each number
+        map<Node *, int> numbers;             // the value number of each node
+    };
+
+    Symtab *symtab;
+    int level;
+    int nextNumber;       // the next new value number
+    int tempCount;        // temporary variables created
+    int eliminatedCount;  // expressions replaced by variables
+    int deadStoreCount;   // assignments removed
+    int unrolledCount;    // loops unrolled
+    int reducedCount;     // multiplications reduced to additions
+
+public:
+    /**
+     * Constructor.
+     * @param symtab the symbol table.
+     * @param level NONE, COMMON_SUBEXPRESSIONS, DEAD_STORES or LOOPS.
+     */
+    Optimizer(Symtab *symtab, int level)
+        : symtab(symtab), level(level), nextNumber(1), tempCount(0),
+          eliminatedCount(0), deadStoreCount(0), unrolledCount(0),
+          reducedCount(0) {}
+
+    /**
+     * Optimize a parse tree in place.
+     * @param programNode the root of the tree.
+     */
+    void optimize(Node *programNode);
+
+    /**
+     * Getter.
+     * @return the count of expressions replaced by variables.
+     */
+    int getEliminatedCount() const { return eliminatedCount; }
+
+    /**
+     * Getter.
+     * @return the count of assignments removed.
+     */
+    int getDeadStoreCount() const { return deadStoreCount; }
+
+    /**
+     * Getter.
+     * @return the count of loops unrolled.
+     */
+    int getUnrolledCount() const { return unrolledCount; }
+
+    /**
+     * Getter.
+     * @return the count of multiplications reduced to additions.
+     */
+    int getReducedCount() const { return reducedCount; }
+
+private:
+    SymtabEntry *entryOf(Node *variableNode);
+    bool isStatementList(Node *node) const;
+    bool isCountedLoop(Node *loopNode);
+    bool isArithmetic(Node *node) const;
+    bool contains(Node *tree, Node *node) const;
+    void collectReads(Node *node, Variables &reads);
+    void collectAssigns(Node *node, Variables &assigns);
+    SymtabEntry *newTemporary(ValueType type);
+    Node *newVariable(SymtabEntry *variableId);
+    Node *newAssign(SymtabEntry *variableId, Node *exprNode, int offset);
+    Node *newInteger(long value);
+
+    // Common subexpressions.
+    void numberList(Node *listNode);
+    int number(Node *node, Node *statementNode, Block &block);
+    void rewrite(Node *node, NodeList &list, Block &block);
+    bool replace(Node *node, NodeList &list, Block &block);
+    SymtabEntry *hoist(Node *first, NodeList &list, Block &block);
+    void makeVariable(Node *node, SymtabEntry *variableId);
+
+    // Loops.
+    void optimizeLoops(Node *node);
+    bool isForStatement(Node *node);
+    void unroll(Node *forNode, long start, long trips, long step);
+    void reduce(Node *forNode, long start, long final, long step);
+    Node *copy(Node *node);
+    void substitute(Node *node, SymtabEntry *variableId, long value);
+    void collectProducts(Node *node, SymtabEntry *variableId,
+                         vector<Node *> &products);
+    bool writes(Node *node, SymtabEntry *variableId);
+    int countNodes(Node *node) const;
+
+    // Dead stores.
+    Variables sweepList(Node *listNode, Variables live, bool remove);
+    Variables sweepLoop(Node *loopNode, Variables liveAfter, bool remove);
+    Variables sweep(NodeList &list, Variables live,
+                    const Variables *liveAtExit, bool removeHere, bool remove);
+    bool canFail(Node *node) const;
+};
+
+}  // namespace backend
+
+#endif /* OPTIMIZER_H_ */
@@ -0,0 +1,157 @@
+/**
+ * Profiler class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "../intermediate/Node.h"
+#include "Profiler.h"
+
+namespace backend {
+
+using namespace std;
+using namespace intermediate;
+
+#if defined(__x86_64__) || defined(__i386__)
+static const string TICK_UNIT = "cycles";
+#else
+static const string TICK_UNIT = "ns";
+#endif
+
+static const int HEAT_BAR_WIDTH = 20;
+
+Profiler::Ticks Profiler::now()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return chrono::duration_cast<chrono::nanoseconds>(
+               chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+Profiler::Profiler() : typeCounters(NODE_TYPE_COUNT) {}
+
+void Profiler::enter()
+{
+    childTicks.push_back(0);
+}
+
+void Profiler::exit(NodeType type, int offset, Ticks elapsed)
+{
+    Ticks children = childTicks.back();
+    childTicks.pop_back();
+
+    // Charge the visit's own time to its node type and source offset,
+    // and its whole time to the enclosing visit.
+    Ticks self = elapsed > children ? elapsed - children : 0;
+    if (!childTicks.empty()) childTicks.back() += elapsed;
+
+    Counter &typeCounter = typeCounters[(int) type];
+    typeCounter.visits++;
+    typeCounter.self  += self;
+    typeCounter.total += elapsed;
+
+    Counter &offsetCounter = offsetCounters[offset];
+    offsetCounter.visits++;
+    offsetCounter.self  += self;
+    offsetCounter.total += elapsed;
+}
+
+void Profiler::print(string sourceFileName, LineMap *lines)
+{
+    Ticks allTicks = 0;
+    for (Counter &counter : typeCounters) allTicks += counter.self;
+    if (allTicks == 0) allTicks = 1;
+
+    printFlatProfile(allTicks);
+    printHeatMap(sourceFileName, lines, allTicks);
+}
+
+void Profiler::printFlatProfile(Ticks allTicks)
+{
+    vector<int> order;
+    for (int i = 0; i < NODE_TYPE_COUNT; i++)
+    {
+        if (typeCounters[i].visits > 0) order.push_back(i);
+    }
+
+    // Hottest node types first.
+    sort(order.begin(), order.end(), [this](int a, int b)
+         { return typeCounters[a].self > typeCounters[b].self; });
+
+    cout << endl << "Flat profile (" << TICK_UNIT << "):" << endl << endl;
+    printf("%7s %16s %16s %12s  %s\n",
+           "%self", "self", "total", "visits", "node type");
+
+    for (int i : order)
+    {
+        Counter &counter = typeCounters[i];
+        printf("%7.2f %16llu %16llu %12llu  %s\n",
+               100.0*counter.self/allTicks, counter.self, counter.total,
+               counter.visits, NODE_TYPE_STRINGS[i].c_str());
+    }
+}
+
+void Profiler::printHeatMap(string sourceFileName, LineMap *lines,
+                            Ticks allTicks)
+{
+    // Only now map the statement offsets to their lines.
+    vector<Counter> lineCounters;
+    for (auto &entry : offsetCounters)
+    {
+        int line = lines->lineNumber(entry.first);
+        if (line >= (int) lineCounters.size()) lineCounters.resize(line + 1);
+
+        lineCounters[line].visits += entry.second.visits;
+        lineCounters[line].self   += entry.second.self;
+        lineCounters[line].total  += entry.second.total;
+    }
+
+    ifstream source(sourceFileName);
+    string text;
+    int lineNumber = 0;
+
+    cout << endl << "Line heat map:" << endl << endl;
+    printf("%5s %7s %12s  %-*s  %s\n", "line", "%self", "visits",
+           HEAT_BAR_WIDTH, "", "source");
+
+    while (getline(source, text))
+    {
+        lineNumber++;
+
+        Counter counter;
+        if (lineNumber < (int) lineCounters.size())
+        {
+            counter = lineCounters[lineNumber];
+        }
+
+        double percent = 100.0*counter.self/allTicks;
+        string bar((int) (percent*HEAT_BAR_WIDTH/100.0 + 0.5), '#');
+
+        if (counter.visits > 0)
+        {
+            printf("%5d %7.2f %12llu  %-*s  %s\n", lineNumber, percent,
+                   counter.visits, HEAT_BAR_WIDTH, bar.c_str(), text.c_str());
+        }
+        else
+        {
+            printf("%5d %7s %12s  %-*s  %s\n", lineNumber, "", "",
+                   HEAT_BAR_WIDTH, "", text.c_str());
+        }
+    }
+}
+
+}  // namespace backend
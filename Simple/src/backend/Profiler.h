@@ -0,0 +1,112 @@
+/**
+ * Profiler class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "../intermediate/Node.h"
+#include "../intermediate/LineMap.h"
+
+/**
+ * Profiling hooks. Build with -DSIMPLE_PROFILE to compile them in.
+ * Otherwise they expand to nothing and the executor pays no cost.
+ */
+#ifdef SIMPLE_PROFILE
+#define PROFILE_VISIT(profiler, node, offset) \
+    backend::Profiler::Scope profileScope_(profiler, node, offset)
+#else
+#define PROFILE_VISIT(profiler, node, offset)
+#endif
+
+namespace backend {
+
+using namespace std;
+using namespace intermediate;
+
+class Profiler
+{
+public:
+    typedef unsigned long long Ticks;
+
+#ifdef SIMPLE_PROFILE
+    static constexpr bool ENABLED = true;
+#else
+    static constexpr bool ENABLED = false;
+#endif
+
+    /**
+     * Read the tick counter: the time stamp counter on x86,
+     * else the steady clock in nanoseconds.
+     * @return the current tick count.
+     */
+    static Ticks now();
+
+    /**
+     * Times one node visit from construction to destruction.
+     */
+    class Scope
+    {
+    private:
+        Profiler *profiler;
+        NodeType type;
+        int offset;
+        Ticks start;
+
+    public:
+        Scope(Profiler *profiler, Node *node, int offset)
+            : profiler(profiler), type(node->type), offset(offset), start(0)
+        {
+            if (profiler != nullptr)
+            {
+                profiler->enter();
+                start = now();
+            }
+        }
+
+        ~Scope()
+        {
+            if (profiler != nullptr) profiler->exit(type, offset, now() - start);
+        }
+    };
+
+    Profiler();
+
+    /**
+     * Print the flat profile by node type and the per-line heat map.
+     * @param sourceFileName the name of the profiled source file.
+     * @param lines the source's line map.
+     */
+    void print(string sourceFileName, LineMap *lines);
+
+private:
+    struct Counter
+    {
+        unsigned long long visits;
+        Ticks self;   // ticks spent in the node itself
+        Ticks total;  // ticks including the node's children
+
+        Counter() : visits(0), self(0), total(0) {}
+    };
+
+    vector<Counter> typeCounters;  // indexed by node type
+    unordered_map<int, Counter> offsetCounters;  // by statement offset
+    vector<Ticks>   childTicks;    // children's ticks of each active visit
+
+    void enter();
+    void exit(NodeType type, int offset, Ticks elapsed);
+
+    void printFlatProfile(Ticks allTicks);
+    void printHeatMap(string sourceFileName, LineMap *lines, Ticks allTicks);
+};
+
+}  // namespace backend
+
+#endif /* PROFILER_H_ */
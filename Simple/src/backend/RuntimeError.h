@@ -0,0 +1,35 @@
+/**
+ * Runtime error class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef RUNTIMEERROR_H_
+#define RUNTIMEERROR_H_
+
+#include <string>
+
+namespace backend {
+
+using namespace std;
+
+/**
+ * Thrown by the executor or the virtual machine after it reports a
+ * runtime error, to abandon the program without ending the process.
+ */
+class RuntimeError
+{
+public:
+    static const int STATUS = -2;  // exit status of a program that failed
+
+    int lineNumber;
+    string message;
+
+    RuntimeError(int lineNumber, string message)
+        : lineNumber(lineNumber), message(message) {}
+};
+
+}  // namespace backend
+
+#endif /* RUNTIMEERROR_H_ */
@@ -0,0 +1,124 @@
+/**
+ * Type specializer pass for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include "../intermediate/Symtab.h"
+#include "../intermediate/Node.h"
+#include "Specializer.h"
+
+namespace backend {
+
+using namespace std;
+using namespace intermediate;
+
+void Specializer::specialize(Node *node)
+{
+    if (node == nullptr) return;
+
+    switch (node->type)
+    {
+        // The executor reads these by their shapes.
+        case WRITE :
+        case WRITELN :
+        case ASSIGN_VAR_OP_CONST :
+        case TEST_VAR_CONST :
+        case WRITE_VAR :
+            return;
+
+        case ASSIGN :
+        {
+            // The executor looks variables up by their text, so do the same.
+            Node *variableNode = node->children[0];
+            variableNode->entry = symtab->lookup(variableNode->text);
+
+            specializeExpression(node->children[1]);
+            return;
+        }
+
+        case TEST :
+            specializeExpression(node->children[0]);
+            return;
+
+        default :
+            for (Node *child : node->children) specialize(child);
+            return;
+    }
+}
+
+void Specializer::specializeExpression(Node *node)
+{
+    if (node == nullptr) return;
+
+    for (Node *child : node->children) specializeExpression(child);
+
+    bool isInteger = node->valueType == ValueType::INTEGER;
+    bool isReal    = node->valueType == ValueType::REAL;
+
+    switch (node->type)
+    {
+        case ADD :
+            if      (isInteger) node->type = ADD_INT;
+            else if (isReal)    node->type = ADD_REAL;
+            break;
+
+        case SUBTRACT :
+            if      (isInteger) node->type = SUBTRACT_INT;
+            else if (isReal)    node->type = SUBTRACT_REAL;
+            break;
+
+        case MULTIPLY :
+            if      (isInteger) node->type = MULTIPLY_INT;
+            else if (isReal)    node->type = MULTIPLY_REAL;
+            break;
+
+        case DIVIDE :
+            if (isReal) node->type = DIVIDE_REAL;
+            break;
+
+        case EQ :
+        case LT :
+        case GT :
+        {
+            // Compare in integers only if both operands are integers.
+            ValueType type1 = node->children[0]->valueType;
+            ValueType type2 = node->children[1]->valueType;
+            bool integers =    (type1 == ValueType::INTEGER)
+                            && (type2 == ValueType::INTEGER);
+            bool numbers =    (   (type1 == ValueType::INTEGER)
+                               || (type1 == ValueType::REAL))
+                           && (   (type2 == ValueType::INTEGER)
+                               || (type2 == ValueType::REAL));
+
+            if (!numbers) break;
+
+            if (node->type == EQ)      node->type = integers ? EQ_INT : EQ_REAL;
+            else if (node->type == LT) node->type = integers ? LT_INT : LT_REAL;
+            else                       node->type = integers ? GT_INT : GT_REAL;
+            break;
+        }
+
+        case VARIABLE :
+        {
+            SymtabEntry *variableId = symtab->lookup(node->text);
+            if (variableId == nullptr) break;
+
+            node->entry = variableId;
+            if (variableId->getType() == ValueType::INTEGER)
+            {
+                node->type = VARIABLE_INT;
+            }
+            else if (variableId->getType() == ValueType::REAL)
+            {
+                node->type = VARIABLE_REAL;
+            }
+            break;
+        }
+
+        default : break;
+    }
+}
+
+}  // namespace backend
@@ -0,0 +1,55 @@
+/**
+ * Type specializer pass for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef SPECIALIZER_H_
+#define SPECIALIZER_H_
+
+#include "../intermediate/Symtab.h"
+#include "../intermediate/Node.h"
+
+namespace backend {
+
+using namespace std;
+using namespace intermediate;
+
+/**
+ * Rewrite the expression nodes of a type-checked parse tree into
+ * variants for their static types, so that the executor dispatches
+ * straight to an integer or a real operation without testing types:
+ *
+ *   ADD, SUBTRACT, MULTIPLY  => ADD_INT ... or ADD_REAL ...
+ *   DIVIDE                   => DIVIDE_REAL
+ *   EQ, LT, GT               => EQ_INT ... or EQ_REAL ...
+ *   VARIABLE                 => VARIABLE_INT or VARIABLE_REAL
+ *
+ * Run it after the superinstructions are fused and only on a tree
+ * that the executor will interpret. The fused nodes and the WRITE and
+ * WRITELN arguments, which the executor reads by their shapes, are
+ * left alone. A rewritten variable node and the target variable of an
+ * assignment cache their symbol table entries.
+ */
+class Specializer
+{
+private:
+    Symtab *symtab;
+
+public:
+    Specializer(Symtab *symtab) : symtab(symtab) {}
+
+    /**
+     * Specialize the expressions of a parse tree in place.
+     * @param node the root of the tree.
+     */
+    void specialize(Node *node);
+
+private:
+    void specializeExpression(Node *node);
+};
+
+}  // namespace backend
+
+#endif /* SPECIALIZER_H_ */
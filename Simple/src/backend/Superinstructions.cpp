@@ -0,0 +1,205 @@
+/**
+ * Superinstruction pass for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include "../intermediate/Symtab.h"
+#include "../intermediate/Node.h"
+#include "Superinstructions.h"
+
+namespace backend {
+
+using namespace std;
+using namespace intermediate;
+
+void Superinstructions::fuse(Node *node)
+{
+    if ((profile != nullptr) && profile->isCold(node)) return;
+
+    // Recognize a desugared FOR before its parts are fused.
+    if (node->type == LOOP) fuseCountedLoop(node);
+
+    for (Node *child : node->children)
+    {
+        if (child != nullptr) fuse(child);
+    }
+
+    switch (node->type)
+    {
+        case ASSIGN :  fuseAssign(node); break;
+        case TEST :    fuseTest(node);   break;
+        case WRITE :
+        case WRITELN : fuseWrite(node);  break;
+
+        default : break;
+    }
+}
+
+bool Superinstructions::resolve(Node *variableNode)
+{
+    // The executor looks variables up by their text, so do the same.
+    if (variableNode->type != VARIABLE) return false;
+
+    variableNode->entry = symtab->lookup(variableNode->text);
+    return variableNode->entry != nullptr;
+}
+
+bool Superinstructions::isConstant(Node *node) const
+{
+    return    (node->type == INTEGER_CONSTANT)
+           || (node->type == REAL_CONSTANT);
+}
+
+bool Superinstructions::isRelational(Node *node) const
+{
+    return (node->type == EQ) || (node->type == LT) || (node->type == GT);
+}
+
+bool Superinstructions::isVariable(Node *node, Node *variableNode) const
+{
+    return    (node != nullptr) && (node->type == VARIABLE)
+           && (node->text == variableNode->text);
+}
+
+bool Superinstructions::references(Node *node, Node *variableNode) const
+{
+    if (node == nullptr)                return false;
+    if (isVariable(node, variableNode)) return true;
+
+    for (Node *child : node->children)
+    {
+        if (references(child, variableNode)) return true;
+    }
+
+    return false;
+}
+
+bool Superinstructions::assigns(Node *node, Node *variableNode) const
+{
+    if (node == nullptr) return false;
+
+    if (   (node->type == ASSIGN)
+        && isVariable(node->children[0], variableNode)) return true;
+
+    for (Node *child : node->children)
+    {
+        if (assigns(child, variableNode)) return true;
+    }
+
+    return false;
+}
+
+void Superinstructions::fuseAssign(Node *assignNode)
+{
+    Node *rhs = assignNode->children[1];
+    if (rhs == nullptr || rhs->children.size() != 2) return;
+
+    bool arithmetic =    (rhs->type == ADD)      || (rhs->type == SUBTRACT)
+                      || (rhs->type == MULTIPLY) || (rhs->type == DIVIDE);
+    if (!arithmetic || !isConstant(rhs->children[1])) return;
+
+    // Leave division by a zero constant to the generic runtime error.
+    if ((rhs->type == DIVIDE) && (rhs->children[1]->value.D == 0.0)) return;
+
+    if (resolve(assignNode->children[0]) && resolve(rhs->children[0]))
+    {
+        assignNode->type = ASSIGN_VAR_OP_CONST;
+    }
+}
+
+void Superinstructions::fuseTest(Node *testNode)
+{
+    Node *exprNode = testNode->children[0];
+    bool negate = false;
+
+    // A WHILE test is NOT(relational).
+    if (exprNode != nullptr && exprNode->type == NodeType::NOT)
+    {
+        exprNode = exprNode->children[0];
+        negate = true;
+    }
+
+    if (   exprNode == nullptr || !isRelational(exprNode)
+        || !isConstant(exprNode->children[1])) return;
+
+    Node *variableNode = exprNode->children[0];
+    if (!resolve(variableNode)) return;
+
+    // The TEST node caches its operands: the variable's entry,
+    // the constant, the relational operator and the negation.
+    testNode->entry   = variableNode->entry;
+    testNode->value.D = exprNode->children[1]->value.D;
+    testNode->value.L = (long) exprNode->type;
+    testNode->value.B = negate;
+    testNode->type    = TEST_VAR_CONST;
+}
+
+void Superinstructions::fuseWrite(Node *writeNode)
+{
+    // Only a lone variable without a field width or decimal places.
+    if (writeNode->children.size() != 1) return;
+
+    Node *variableNode = writeNode->children[0];
+    if (!resolve(variableNode)) return;
+
+    // The WRITE_VAR node caches the variable's entry
+    // and whether to end the line.
+    writeNode->entry   = variableNode->entry;
+    writeNode->value.B = writeNode->type == WRITELN;
+    writeNode->type    = WRITE_VAR;
+}
+
+void Superinstructions::fuseCountedLoop(Node *loopNode)
+{
+    // The shape Parser::parseForStatement desugars FOR into,
+    // and then any steps of the optimizer's induction temporaries.
+    if (loopNode->children.size() < 3) return;
+
+    Node *testNode   = loopNode->children[0];
+    Node *bodyNode   = loopNode->children[1];
+    Node *assignNode = loopNode->children[2];
+
+    if ((testNode->type != TEST) || (assignNode->type != ASSIGN)) return;
+    if (bodyNode == nullptr) return;
+
+    Node *compareNode = testNode->children[0];
+    bool up = compareNode->type == GT;
+    if (!up && (compareNode->type != LT)) return;
+
+    Node *variableNode = compareNode->children[0];
+    if (variableNode->type != VARIABLE) return;
+
+    Node *stepNode = assignNode->children[1];
+    if (   !isVariable(assignNode->children[0], variableNode)
+        || (stepNode->type != (up ? ADD : SUBTRACT))
+        || !isVariable(stepNode->children[0], variableNode)
+        || (stepNode->children[1]->type != INTEGER_CONSTANT)
+        || (stepNode->children[1]->value.D != 1.0)) return;
+
+    // Each induction temporary steps by an integer constant.
+    for (size_t i = 3; i < loopNode->children.size(); i++)
+    {
+        Node *tempStepNode = loopNode->children[i];
+        if (   (tempStepNode == nullptr) || (tempStepNode->type != ASSIGN)
+            || (tempStepNode->children[1]->type != ADD)
+            || !isVariable(tempStepNode->children[1]->children[0],
+                           tempStepNode->children[0])
+            || (tempStepNode->children[1]->children[1]->type != INTEGER_CONSTANT)
+            || isVariable(tempStepNode->children[0], variableNode)
+            || !resolve(tempStepNode->children[0])) return;
+    }
+
+    // The body must not change the control variable.
+    if (assigns(bodyNode, variableNode) || !resolve(variableNode)) return;
+
+    // The LOOP node caches the control variable's entry, the step,
+    // and whether the body can see the control variable.
+    loopNode->entry   = variableNode->entry;
+    loopNode->value.D = up ? 1.0 : -1.0;
+    loopNode->value.B = references(bodyNode, variableNode);
+    loopNode->type    = COUNTED_LOOP;
+}
+
+}  // namespace backend
@@ -0,0 +1,68 @@
+/**
+ * Superinstruction pass for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef SUPERINSTRUCTIONS_H_
+#define SUPERINSTRUCTIONS_H_
+
+#include "../intermediate/Symtab.h"
+#include "../intermediate/Node.h"
+#include "ExecutionProfile.h"
+
+namespace backend {
+
+using namespace std;
+using namespace intermediate;
+
+/**
+ * Rewrite the hottest statement shapes of a parse tree into fused
+ * nodes that the executor runs without visiting their subtrees:
+ *
+ *   ASSIGN(v, op(w, c))        => ASSIGN_VAR_OP_CONST
+ *   TEST([NOT] rel(v, c))      => TEST_VAR_CONST
+ *   WRITE/WRITELN(v)           => WRITE_VAR
+ *   LOOP(TEST(GT|LT(v, limit)), stmt, ASSIGN(v, ADD|SUBTRACT(v, 1)),
+ *        [ASSIGN(t, ADD(t, c)) ...])
+ *                              => COUNTED_LOOP
+ *
+ * A fused node keeps its original children, so the tree still prints.
+ * The variables' symbol table entries are resolved here once instead
+ * of being looked up by name on every execution. With an execution
+ * profile, the statements that never ran are left as they are.
+ */
+class Superinstructions
+{
+private:
+    Symtab *symtab;
+    const ExecutionProfile *profile;  // null unless fusing only what ran
+
+public:
+    Superinstructions(Symtab *symtab, const ExecutionProfile *profile = nullptr)
+        : symtab(symtab), profile(profile) {}
+
+    /**
+     * Fuse the statements of a parse tree in place.
+     * @param node the root of the tree.
+     */
+    void fuse(Node *node);
+
+private:
+    bool resolve(Node *variableNode);
+    bool isConstant(Node *node) const;
+    bool isRelational(Node *node) const;
+    bool isVariable(Node *node, Node *variableNode) const;
+    bool references(Node *node, Node *variableNode) const;
+    bool assigns(Node *node, Node *variableNode) const;
+
+    void fuseAssign(Node *assignNode);
+    void fuseTest(Node *testNode);
+    void fuseWrite(Node *writeNode);
+    void fuseCountedLoop(Node *loopNode);
+};
+
+}  // namespace backend
+
+#endif /* SUPERINSTRUCTIONS_H_ */
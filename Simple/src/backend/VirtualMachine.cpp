@@ -0,0 +1,283 @@
+/**
+ * Virtual machine class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cmath>
+#include <climits>
+
+#include "../intermediate/Code.h"
+#include "../intermediate/CodeImage.h"
+#include "RuntimeError.h"
+#include "VirtualMachine.h"
+
+namespace backend {
+
+using namespace std;
+using namespace intermediate;
+
+// Every statement leaves the stack empty, so it can
+// never hold more values than there are instructions.
+
+/**
+ * Make the number that a relational operator pushes.
+ * @param value true or false.
+ * @return 1 or 0.
+ */
+static inline Number truth(bool value)
+{
+    return {(long) value, value ? 1.0 : 0.0};
+}
+
+VirtualMachine::VirtualMachine(Code *code)
+    : instructions(code->instructions.data()),
+      constants(code->constants.data()),
+      image(nullptr), lines(nullptr),
+      frame(code->variables.size(), {0, 0.0}),
+      stack(code->instructions.size() + 1, {0, 0.0}), out(&cout)
+{
+    for (string &s : code->strings) strings.push_back(s.c_str());
+}
+
+VirtualMachine::VirtualMachine(CodeImage *image)
+    : instructions(image->instructions()),
+      constants(image->constants()),
+      image(image), lines(nullptr),
+      frame(image->variableCount(), {0, 0.0}),
+      stack(image->instructionCount() + 1, {0, 0.0}), out(&cout)
+{
+    for (int i = 0; i < image->stringCount(); i++)
+    {
+        strings.push_back(image->stringAt(i));
+    }
+}
+
+int VirtualMachine::run()
+{
+    try
+    {
+        execute();
+    }
+    catch (RuntimeError &error)
+    {
+        return RuntimeError::STATUS;
+    }
+
+    return 0;
+}
+
+void VirtualMachine::execute()
+{
+    Number *variables = frame.data();
+    Number *sp = stack.data();  // points just past the top of the stack
+    const Instruction *ip = instructions;
+
+#ifdef __GNUC__
+    // Threaded dispatch: jump through a table of labels
+    // indexed by the opcode, in Opcode order.
+    static void *dispatch[] =
+    {
+        &&push, &&load, &&store,
+        &&add, &&subtract, &&multiply, &&divide, &&integerDivide, &&modulo,
+        &&addInt, &&subtractInt, &&multiplyInt,
+        &&eq, &&lt, &&gt, &&eqInt, &&ltInt, &&gtInt, &&not_,
+        &&jump, &&jumpIfTrue, &&jumpIfFalse,
+        &&printNumber, &&printString, &&printStringWidth, &&printLine,
+        &&halt
+    };
+    static_assert(sizeof(dispatch)/sizeof(dispatch[0]) == OPCODE_COUNT,
+                  "dispatch table out of step with Opcode");
+
+    #define NEXT goto *dispatch[(int) (ip++)->opcode]
+    #define CASE(label, opcode) label:
+#else
+    #define NEXT goto next
+    #define CASE(label, opcode) case Opcode::opcode:
+
+    next:
+    switch ((ip++)->opcode)
+    {
+#endif
+
+    NEXT;
+
+    CASE(push, PUSH)
+        *sp++ = constants[ip[-1].operand];
+        NEXT;
+
+    CASE(load, LOAD)
+        *sp++ = variables[ip[-1].operand];
+        NEXT;
+
+    CASE(store, STORE)
+        variables[ip[-1].operand] = *--sp;
+        NEXT;
+
+    CASE(add, ADD)
+        sp--; sp[-1].D += sp[0].D;
+        NEXT;
+
+    CASE(subtract, SUBTRACT)
+        sp--; sp[-1].D -= sp[0].D;
+        NEXT;
+
+    CASE(multiply, MULTIPLY)
+        sp--; sp[-1].D *= sp[0].D;
+        NEXT;
+
+    CASE(divide, DIVIDE)
+        sp--;
+        if (sp[0].D == 0.0) runtimeError(ip[-1], "Division by zero");
+        sp[-1].D /= sp[0].D;
+        NEXT;
+
+    CASE(integerDivide, INTEGER_DIVIDE)
+        sp--;
+        if (sp[0].L == 0) runtimeError(ip[-1], "Division by zero");
+        if ((sp[-1].L == LONG_MIN) && (sp[0].L == -1))
+        {
+            runtimeError(ip[-1], "Integer overflow");
+        }
+        sp[-1].L /= sp[0].L;
+        sp[-1].D = sp[-1].L;
+        NEXT;
+
+    CASE(modulo, MODULO)
+        sp--;
+        if (sp[0].L == 0) runtimeError(ip[-1], "Division by zero");
+        if ((sp[-1].L == LONG_MIN) && (sp[0].L == -1))
+        {
+            runtimeError(ip[-1], "Integer overflow");
+        }
+        sp[-1].L %= sp[0].L;
+        sp[-1].D = sp[-1].L;
+        NEXT;
+
+    CASE(addInt, ADD_INT)
+        sp--;
+        if (__builtin_add_overflow(sp[-1].L, sp[0].L, &sp[-1].L))
+        {
+            runtimeError(ip[-1], "Integer overflow");
+        }
+        sp[-1].D = sp[-1].L;
+        NEXT;
+
+    CASE(subtractInt, SUBTRACT_INT)
+        sp--;
+        if (__builtin_sub_overflow(sp[-1].L, sp[0].L, &sp[-1].L))
+        {
+            runtimeError(ip[-1], "Integer overflow");
+        }
+        sp[-1].D = sp[-1].L;
+        NEXT;
+
+    CASE(multiplyInt, MULTIPLY_INT)
+        sp--;
+        if (__builtin_mul_overflow(sp[-1].L, sp[0].L, &sp[-1].L))
+        {
+            runtimeError(ip[-1], "Integer overflow");
+        }
+        sp[-1].D = sp[-1].L;
+        NEXT;
+
+    CASE(eq, EQ)
+        sp--; sp[-1] = truth(sp[-1].D == sp[0].D);
+        NEXT;
+
+    CASE(lt, LT)
+        sp--; sp[-1] = truth(sp[-1].D < sp[0].D);
+        NEXT;
+
+    CASE(gt, GT)
+        sp--; sp[-1] = truth(sp[-1].D > sp[0].D);
+        NEXT;
+
+    CASE(eqInt, EQ_INT)
+        sp--; sp[-1] = truth(sp[-1].L == sp[0].L);
+        NEXT;
+
+    CASE(ltInt, LT_INT)
+        sp--; sp[-1] = truth(sp[-1].L < sp[0].L);
+        NEXT;
+
+    CASE(gtInt, GT_INT)
+        sp--; sp[-1] = truth(sp[-1].L > sp[0].L);
+        NEXT;
+
+    CASE(not_, NOT)
+        sp[-1] = truth(sp[-1].D == 0.0);
+        NEXT;
+
+    CASE(jump, JUMP)
+        ip = instructions + ip[-1].operand;
+        NEXT;
+
+    CASE(jumpIfTrue, JUMP_IF_TRUE)
+        if ((--sp)->D != 0.0) ip = instructions + ip[-1].operand;
+        NEXT;
+
+    CASE(jumpIfFalse, JUMP_IF_FALSE)
+        if ((--sp)->D == 0.0) ip = instructions + ip[-1].operand;
+        NEXT;
+
+    CASE(printNumber, PRINT_NUMBER)
+    {
+        // Same formats as Executor::printValue().
+        int count = ip[-1].operand;
+        long decimalPlaces = count > 1 ? (--sp)->L : 0;
+        long fieldWidth    = count > 0 ? (--sp)->L : -1;
+        double value = (--sp)->D;
+
+        *out << fixed << setprecision(decimalPlaces);
+        if (fieldWidth >= 0) *out << setw(fieldWidth);
+        *out << value;
+        NEXT;
+    }
+
+    CASE(printString, PRINT_STRING)
+        *out << strings[ip[-1].operand];
+        NEXT;
+
+    CASE(printStringWidth, PRINT_STRING_WIDTH)
+    {
+        long fieldWidth = (--sp)->L;
+        const char *value = strings[ip[-1].operand];
+
+        if (fieldWidth > 0) *out << setw(fieldWidth);
+        *out << value;
+        NEXT;
+    }
+
+    CASE(printLine, PRINT_LINE)
+        *out << endl;
+        NEXT;
+
+    CASE(halt, HALT)
+        return;
+
+#ifndef __GNUC__
+    }
+#endif
+
+    #undef NEXT
+    #undef CASE
+}
+
+void VirtualMachine::runtimeError(const Instruction &instruction,
+                                  string message)
+{
+    if ((lines == nullptr) && (image != nullptr)) lines = image->lines();
+    int lineNumber = lines != nullptr ? lines->lineNumber(instruction.offset)
+                                      : 0;
+
+    *out << "RUNTIME ERROR at line " << lineNumber << ": " << message << ": "
+         << endl;
+    throw RuntimeError(lineNumber, message);
+}
+
+}  // namespace backend
@@ -0,0 +1,91 @@
+/**
+ * Virtual machine class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef VIRTUALMACHINE_H_
+#define VIRTUALMACHINE_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../intermediate/Allocator.h"
+#include "../intermediate/Code.h"
+#include "../intermediate/CodeImage.h"
+#include "../intermediate/LineMap.h"
+
+namespace backend {
+
+using namespace std;
+using namespace intermediate;
+
+/**
+ * Executes the stack machine instructions emitted by the CodeParser,
+ * either as they were just compiled or from a mapped program image.
+ * Variables live in a frame array indexed by slot.
+ */
+class VirtualMachine
+{
+private:
+    const Instruction *instructions;
+    const Number *constants;
+    vector<const char *> strings;  // PRINT_STRING operands
+    CodeImage *image;       // null unless running an image
+    LineMap *lines;         // for runtime error messages
+    vector<Number> frame;   // variable values, by slot
+    vector<Number> stack;   // operand stack
+    ostream *out;           // where the program's output goes
+
+public:
+    /**
+     * Constructor to run code that was just compiled.
+     * @param code the code to execute.
+     */
+    VirtualMachine(Code *code);
+
+    /**
+     * Constructor to run a program image in place.
+     * @param image the image to execute.
+     */
+    VirtualMachine(CodeImage *image);
+
+    // Allocate executors from the executors' allocator.
+    static void *operator new(size_t size)
+    {
+        return Allocator::allocate<VirtualMachine>(Subsystem::EXECUTOR, size);
+    }
+    static void operator delete(void *executor, size_t size)
+    {
+        Allocator::release(Subsystem::EXECUTOR, executor, size);
+    }
+
+    /**
+     * Set the source's line map, used only to report runtime errors.
+     * @param lines the line map.
+     */
+    void setLineMap(LineMap *lines) { this->lines = lines; }
+
+    /**
+     * Send the program's output and runtime errors somewhere other
+     * than cout.
+     * @param out the output stream.
+     */
+    void setOutput(ostream *out) { this->out = out; }
+
+    /**
+     * Execute the code from its first instruction until HALT.
+     * @return 0, or RuntimeError::STATUS if there was a runtime error.
+     */
+    int run();
+
+private:
+    void execute();
+    void runtimeError(const Instruction &instruction, string message);
+};
+
+}  // namespace backend
+
+#endif /* VIRTUALMACHINE_H_ */
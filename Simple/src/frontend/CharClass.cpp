@@ -0,0 +1,217 @@
+/**
+ * Character classification routines for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CHARCLASS_X86 1
+#endif
+
+#include "CharClass.h"
+
+namespace frontend {
+
+// Scalar versions. They also finish the tails of the vector versions.
+
+static inline bool isSpace(char ch)
+{
+    return (ch == ' ') || ((ch >= '\t') && (ch <= '\r'));
+}
+
+static inline bool isAlnum(char ch)
+{
+    char lower = ch | 0x20;
+    return ((ch >= '0') && (ch <= '9')) || ((lower >= 'a') && (lower <= 'z'));
+}
+
+static int skipSpacesScalar(const char *text, int position, int length)
+{
+    while ((position < length) && isSpace(text[position])) position++;
+    return position;
+}
+
+static int skipAlnumScalar(const char *text, int position, int length)
+{
+    while ((position < length) && isAlnum(text[position])) position++;
+    return position;
+}
+
+static int findScalar(const char *text, int position, int length, char ch)
+{
+    while ((position < length) && (text[position] != ch)) position++;
+    return position;
+}
+
+static int countScalar(const char *text, int position, int length, char ch)
+{
+    int n = 0;
+    for (; position < length; position++) n += text[position] == ch;
+    return n;
+}
+
+#ifdef CHARCLASS_X86
+
+// SSE2 versions, 16 characters at a time. Bytes >= 0x80 compare as
+// negative and so never classify as spaces, letters or digits.
+
+static inline __m128i inRange16(__m128i chars, char low, char high)
+{
+    return _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8(low - 1)),
+                         _mm_cmplt_epi8(chars, _mm_set1_epi8(high + 1)));
+}
+
+static int skipSpacesSse2(const char *text, int position, int length)
+{
+    for (; position + 16 <= length; position += 16)
+    {
+        __m128i chars = _mm_loadu_si128((const __m128i *) (text + position));
+        __m128i space = _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8(' ')),
+                                     inRange16(chars, '\t', '\r'));
+        unsigned mask = ~_mm_movemask_epi8(space) & 0xFFFF;
+        if (mask != 0) return position + __builtin_ctz(mask);
+    }
+
+    return skipSpacesScalar(text, position, length);
+}
+
+static int skipAlnumSse2(const char *text, int position, int length)
+{
+    for (; position + 16 <= length; position += 16)
+    {
+        __m128i chars = _mm_loadu_si128((const __m128i *) (text + position));
+        __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+        __m128i alnum = _mm_or_si128(inRange16(chars, '0', '9'),
+                                     inRange16(lower, 'a', 'z'));
+        unsigned mask = ~_mm_movemask_epi8(alnum) & 0xFFFF;
+        if (mask != 0) return position + __builtin_ctz(mask);
+    }
+
+    return skipAlnumScalar(text, position, length);
+}
+
+static int findSse2(const char *text, int position, int length, char ch)
+{
+    __m128i target = _mm_set1_epi8(ch);
+
+    for (; position + 16 <= length; position += 16)
+    {
+        __m128i chars = _mm_loadu_si128((const __m128i *) (text + position));
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chars, target));
+        if (mask != 0) return position + __builtin_ctz(mask);
+    }
+
+    return findScalar(text, position, length, ch);
+}
+
+static int countSse2(const char *text, int position, int length, char ch)
+{
+    __m128i target = _mm_set1_epi8(ch);
+    int n = 0;
+
+    for (; position + 16 <= length; position += 16)
+    {
+        __m128i chars = _mm_loadu_si128((const __m128i *) (text + position));
+        n += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(chars, target)));
+    }
+
+    return n + countScalar(text, position, length, ch);
+}
+
+// AVX2 versions, 32 characters at a time.
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static inline __m256i inRange32(__m256i chars, char low, char high)
+{
+    return _mm256_and_si256(
+               _mm256_cmpgt_epi8(chars, _mm256_set1_epi8(low - 1)),
+               _mm256_cmpgt_epi8(_mm256_set1_epi8(high + 1), chars));
+}
+
+AVX2 static int skipSpacesAvx2(const char *text, int position, int length)
+{
+    for (; position + 32 <= length; position += 32)
+    {
+        __m256i chars = _mm256_loadu_si256((const __m256i *) (text + position));
+        __m256i space = _mm256_or_si256(
+                            _mm256_cmpeq_epi8(chars, _mm256_set1_epi8(' ')),
+                            inRange32(chars, '\t', '\r'));
+        unsigned mask = ~(unsigned) _mm256_movemask_epi8(space);
+        if (mask != 0) return position + __builtin_ctz(mask);
+    }
+
+    return skipSpacesSse2(text, position, length);
+}
+
+AVX2 static int skipAlnumAvx2(const char *text, int position, int length)
+{
+    for (; position + 32 <= length; position += 32)
+    {
+        __m256i chars = _mm256_loadu_si256((const __m256i *) (text + position));
+        __m256i lower = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+        __m256i alnum = _mm256_or_si256(inRange32(chars, '0', '9'),
+                                        inRange32(lower, 'a', 'z'));
+        unsigned mask = ~(unsigned) _mm256_movemask_epi8(alnum);
+        if (mask != 0) return position + __builtin_ctz(mask);
+    }
+
+    return skipAlnumSse2(text, position, length);
+}
+
+AVX2 static int findAvx2(const char *text, int position, int length, char ch)
+{
+    __m256i target = _mm256_set1_epi8(ch);
+
+    for (; position + 32 <= length; position += 32)
+    {
+        __m256i chars = _mm256_loadu_si256((const __m256i *) (text + position));
+        unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, target));
+        if (mask != 0) return position + __builtin_ctz(mask);
+    }
+
+    return findSse2(text, position, length, ch);
+}
+
+AVX2 static int countAvx2(const char *text, int position, int length, char ch)
+{
+    __m256i target = _mm256_set1_epi8(ch);
+    int n = 0;
+
+    for (; position + 32 <= length; position += 32)
+    {
+        __m256i chars = _mm256_loadu_si256((const __m256i *) (text + position));
+        n += __builtin_popcount(
+                 _mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, target)));
+    }
+
+    return n + countSse2(text, position, length, ch);
+}
+
+#endif  // CHARCLASS_X86
+
+const CharClass::Implementation &CharClass::implementation()
+{
+    static const Implementation scalar =
+        { "scalar", skipSpacesScalar, skipAlnumScalar, findScalar, countScalar };
+
+#ifdef CHARCLASS_X86
+    static const Implementation sse2 =
+        { "sse2", skipSpacesSse2, skipAlnumSse2, findSse2, countSse2 };
+    static const Implementation avx2 =
+        { "avx2", skipSpacesAvx2, skipAlnumAvx2, findAvx2, countAvx2 };
+
+    // Ask CPUID once, on first use.
+    static const Implementation &selected =
+          __builtin_cpu_supports("avx2") ? avx2
+        : __builtin_cpu_supports("sse2") ? sse2
+        :                                  scalar;
+    return selected;
+#else
+    return scalar;
+#endif
+}
+
+}  // namespace frontend
@@ -0,0 +1,81 @@
+/**
+ * Character classification routines for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef CHARCLASS_H_
+#define CHARCLASS_H_
+
+namespace frontend {
+
+/**
+ * Scan runs of characters in a contiguous source buffer.
+ * Each routine starts at text[position], stops at text[length],
+ * and has SSE2, AVX2 and scalar versions. The fastest version
+ * the CPU supports is chosen at run time.
+ */
+class CharClass
+{
+public:
+    /**
+     * Skip whitespace.
+     * @return the position of the first non-whitespace character,
+     *         or length if none.
+     */
+    static int skipSpaces(const char *text, int position, int length)
+    {
+        return implementation().skipSpaces(text, position, length);
+    }
+
+    /**
+     * Skip letters and digits.
+     * @return the position of the first character that is not a letter
+     *         or a digit, or length if none.
+     */
+    static int skipAlnum(const char *text, int position, int length)
+    {
+        return implementation().skipAlnum(text, position, length);
+    }
+
+    /**
+     * Find a character.
+     * @return the position of the character, or length if not found.
+     */
+    static int find(const char *text, int position, int length, char ch)
+    {
+        return implementation().find(text, position, length, ch);
+    }
+
+    /**
+     * Count the occurrences of a character.
+     * @return the count.
+     */
+    static int count(const char *text, int position, int length, char ch)
+    {
+        return implementation().count(text, position, length, ch);
+    }
+
+    /**
+     * Getter.
+     * @return the name of the selected implementation.
+     */
+    static const char *implementationName() { return implementation().name; }
+
+private:
+    struct Implementation
+    {
+        const char *name;
+        int (*skipSpaces)(const char *text, int position, int length);
+        int (*skipAlnum)(const char *text, int position, int length);
+        int (*find)(const char *text, int position, int length, char ch);
+        int (*count)(const char *text, int position, int length, char ch);
+    };
+
+    static const Implementation &implementation();
+};
+
+}  // namespace frontend
+
+#endif /* CHARCLASS_H_ */
@@ -0,0 +1,765 @@
+/**
+ * Code parser class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <string>
+#include <map>
+#include <vector>
+
+#include "Token.h"
+#include "CodeParser.h"
+
+namespace frontend {
+
+using namespace std;
+
+Token *CodeParser::nextToken()
+{
+    if (tokens == nullptr)
+    {
+        // Each streamed token replaces the one before.
+        delete bufferedToken;
+        bufferedToken = scanner->nextToken();
+        return bufferedToken;
+    }
+
+    // Walk the token buffer by index.
+    tokens->load(position++, bufferedToken);
+    return bufferedToken;
+}
+
+string CodeParser::tokenText() const
+{
+    // A buffered token holds no text unless it's an identifier.
+    return tokens != nullptr ? tokens->text(position - 1) : currentToken->text;
+}
+
+Code *CodeParser::parseProgram()
+{
+    currentToken = nextToken();  // first token!
+
+    if (currentToken->type == TokenType::PROGRAM)
+    {
+        currentToken = nextToken();  // consume PROGRAM
+    }
+    else syntaxError("Expecting PROGRAM");
+
+    if (currentToken->type == IDENTIFIER)
+    {
+        string programName = currentToken->text;
+        symtab->enter(programName);
+        code->programName = programName;
+
+        currentToken = nextToken();  // consume program name
+    }
+    else syntaxError("Expecting program name");
+
+    if (currentToken->type == SEMICOLON)
+    {
+        currentToken = nextToken();  // consume ;
+    }
+    else syntaxError("Missing ;");
+
+    if (currentToken->type != BEGIN) syntaxError("Expecting BEGIN");
+
+    parseCompoundStatement();
+    code->emit(Opcode::HALT, 0, offset);
+
+    if (currentToken->type == SEMICOLON) syntaxError("Expecting .");
+
+    // Type the program only if it parsed.
+    if (errorCount == 0) checkTypes();
+
+    return code;
+}
+
+void CodeParser::parseStatement()
+{
+    offset = currentToken->offset;
+
+    switch (currentToken->type)
+    {
+        case IDENTIFIER : parseAssignmentStatement(); break;
+        case BEGIN      : parseCompoundStatement();   break;
+        case REPEAT     : parseRepeatStatement();     break;
+        case WHILE      : parseWhileStatement();      break;
+        case IF         : parseIfStatement();         break;
+        case FOR        : parseForStatement();        break;
+        case WRITE      : parseWriteStatement();      break;
+        case WRITELN    : parseWritelnStatement();    break;
+        case SEMICOLON  : break;  // empty statement
+
+        default : syntaxError("Unexpected token");
+    }
+}
+
+void CodeParser::parseAssignmentStatement()
+{
+    // The current token should now be the left-hand-side variable name.
+
+    int slot = assignedSlot();
+    currentToken = nextToken();  // consume the LHS variable;
+
+    if (currentToken->type == COLON_EQUALS)
+    {
+        currentToken = nextToken();  // consume :=
+    }
+    else syntaxError("Missing :=");
+
+    // Evaluate the expression onto the stack, then store it.
+    assignments.push_back({slot, parseExpression()});
+    code->emit(Opcode::STORE, slot, offset);
+}
+
+void CodeParser::parseCompoundStatement()
+{
+    currentToken = nextToken();  // consume BEGIN
+    parseStatementList(END);
+
+    if (currentToken->type == END)
+    {
+        currentToken = nextToken();  // consume END
+    }
+    else syntaxError("Expecting END");
+}
+
+void CodeParser::parseStatementList(TokenType terminalType)
+{
+    while (   (currentToken->type != terminalType)
+           && (currentToken->type != END_OF_FILE))
+    {
+        parseStatement();
+
+        // A semicolon separates statements.
+        if (currentToken->type == SEMICOLON)
+        {
+            while (currentToken->type == SEMICOLON)
+            {
+                currentToken = nextToken();  // consume ;
+            }
+        }
+        else if (Parser::statementStarters.find(currentToken->type) !=
+                                                Parser::statementStarters.end())
+        {
+            syntaxError("Missing ;");
+        }
+    }
+}
+
+void CodeParser::parseRepeatStatement()
+{
+    // The current token should now be REPEAT.
+    //
+    //     top:  statements
+    //           test expression
+    //           JUMP_IF_FALSE top
+
+    int top = code->here();
+    currentToken = nextToken();  // consume REPEAT
+
+    parseStatementList(UNTIL);
+
+    if (currentToken->type == UNTIL)
+    {
+        offset = currentToken->offset;
+        currentToken = nextToken();  // consume UNTIL
+
+        parseExpression();
+        code->emit(Opcode::JUMP_IF_FALSE, top, offset);
+    }
+    else syntaxError("Expecting UNTIL");
+}
+
+void CodeParser::parseWhileStatement()
+{
+    // The current token should now be WHILE.
+    //
+    //     top:  test expression
+    //           JUMP_IF_FALSE exit
+    //           statement
+    //           JUMP top
+    //     exit:
+
+    int top = code->here();
+    currentToken = nextToken();  // consume WHILE
+
+    parseExpression();
+    int exitJump = emitJump(Opcode::JUMP_IF_FALSE);
+
+    if (currentToken->type == DO)
+    {
+        currentToken = nextToken();  // consume DO
+        parseStatement();
+    }
+    else syntaxError("Expecting DO");
+
+    code->emit(Opcode::JUMP, top, offset);
+    code->patch(exitJump, code->here());
+}
+
+void CodeParser::parseIfStatement()
+{
+    // The current token should now be IF.
+    //
+    //           test expression
+    //           JUMP_IF_FALSE else
+    //           THEN statement
+    //           JUMP exit           (only if there is an ELSE)
+    //     else: ELSE statement
+    //     exit:
+
+    currentToken = nextToken();  // consume IF
+
+    parseExpression();
+    int elseJump = emitJump(Opcode::JUMP_IF_FALSE);
+
+    if (currentToken->type == THEN)
+    {
+        currentToken = nextToken();  // consume THEN
+        parseStatement();
+    }
+    else syntaxError("Expecting THEN");
+
+    if (currentToken->type == ELSE)
+    {
+        int exitJump = emitJump(Opcode::JUMP);
+        code->patch(elseJump, code->here());
+
+        currentToken = nextToken();  // consume ELSE
+        parseStatement();
+
+        code->patch(exitJump, code->here());
+    }
+    else code->patch(elseJump, code->here());
+}
+
+void CodeParser::parseForStatement()
+{
+    // The current token should now be FOR.
+    //
+    //           initial expression
+    //           STORE variable
+    //           limit expression
+    //           STORE limit
+    //     top:  LOAD variable
+    //           LOAD limit
+    //           GT (TO) or LT (DOWNTO)
+    //           JUMP_IF_TRUE exit
+    //           statement
+    //           LOAD variable
+    //           PUSH 1
+    //           ADD (TO) or SUBTRACT (DOWNTO)
+    //           STORE variable
+    //           JUMP top
+    //     exit:
+
+    currentToken = nextToken();  // consume FOR
+
+    if (currentToken->type != IDENTIFIER)
+    {
+        syntaxError("Expecting control variable");
+        return;
+    }
+
+    int slot = assignedSlot();
+    parseAssignmentStatement();
+
+    if ((currentToken->type != TO) && (currentToken->type != DOWNTO))
+    {
+        syntaxError("Expecting TO/DOWNTO");
+        return;
+    }
+
+    bool up = currentToken->type == TO;
+    currentToken = nextToken();  // consume TO/DOWNTO
+
+    // The limit is evaluated once, into a hidden slot.
+    int limit = hiddenSlot("for-limit");
+    assignments.push_back({limit, parseExpression()});
+    code->emit(Opcode::STORE, limit, offset);
+
+    int top = code->here();
+    code->emit(Opcode::LOAD, slot, offset);
+    code->emit(Opcode::LOAD, limit, offset);
+    operations.push_back({code->emit(up ? Opcode::GT : Opcode::LT, 0, offset),
+                          newTyping(TypingKind::BOTH,
+                                    newTyping(TypingKind::VARIABLE, slot),
+                                    newTyping(TypingKind::VARIABLE, limit))});
+    int exitJump = emitJump(Opcode::JUMP_IF_TRUE);
+
+    if (currentToken->type == DO)
+    {
+        currentToken = nextToken();  // consume DO
+        parseStatement();
+    }
+    else syntaxError("Expecting DO");
+
+    int step = newTyping(TypingKind::BOTH, newTyping(TypingKind::VARIABLE, slot),
+                         newTyping(TypingKind::INTEGER));
+    code->emit(Opcode::LOAD, slot, offset);
+    code->emit(Opcode::PUSH, code->addInteger(1), offset);
+    operations.push_back({code->emit(up ? Opcode::ADD : Opcode::SUBTRACT,
+                                     0, offset),
+                          step});
+    code->emit(Opcode::STORE, slot, offset);
+    assignments.push_back({slot, step});
+    code->emit(Opcode::JUMP, top, offset);
+    code->patch(exitJump, code->here());
+}
+
+void CodeParser::parseWriteStatement()
+{
+    // The current token should now be WRITE.
+
+    currentToken = nextToken();  // consume WRITE
+
+    if (!parseWriteArguments()) syntaxError("Invalid WRITE statement");
+}
+
+void CodeParser::parseWritelnStatement()
+{
+    // The current token should now be WRITELN.
+
+    currentToken = nextToken();  // consume WRITELN
+
+    if (currentToken->type == LPAREN) parseWriteArguments();
+    code->emit(Opcode::PRINT_LINE, 0, offset);
+}
+
+bool CodeParser::parseWriteArguments()
+{
+    // The current token should now be (
+    //
+    // A variable is printed by PRINT_NUMBER, whose operand is the count
+    // of field width and decimal places values pushed after the value.
+    // A string is printed by PRINT_STRING, or by PRINT_STRING_WIDTH
+    // after its field width is pushed.
+
+    bool hasArgument = false;
+    bool isString = false;
+    int stringIndex = 0;
+    int formatCount = 0;
+
+    if (currentToken->type == LPAREN)
+    {
+        currentToken = nextToken();  // consume (
+    }
+    else syntaxError("Missing left parenthesis");
+
+    if (currentToken->type == IDENTIFIER)
+    {
+        parseVariable();
+        hasArgument = true;
+    }
+    else if (   (currentToken->type == CHARACTER)
+             || (currentToken->type == STRING))
+    {
+        stringIndex = code->addString(currentToken->value.S);
+        currentToken = nextToken();  // consume the string
+        hasArgument = isString = true;
+    }
+    else syntaxError("Invalid WRITE or WRITELN statement");
+
+    // Look for a field width and a count of decimal places.
+    if (hasArgument)
+    {
+        if (currentToken->type == COLON)
+        {
+            currentToken = nextToken();  // consume ,
+
+            if (currentToken->type == INTEGER)
+            {
+                // Field width
+                code->emit(Opcode::PUSH,
+                           code->addInteger(currentToken->value.L), offset);
+                formatCount++;
+                currentToken = nextToken();  // consume the number
+
+                if (currentToken->type == COLON)
+                {
+                    currentToken = nextToken();  // consume ,
+
+                    if (currentToken->type == INTEGER)
+                    {
+                        // Count of decimal places, which strings ignore.
+                        if (!isString)
+                        {
+                            code->emit(Opcode::PUSH,
+                                       code->addInteger(currentToken->value.L),
+                                       offset);
+                            formatCount++;
+                        }
+                        currentToken = nextToken();  // consume the number
+                    }
+                    else syntaxError("Invalid count of decimal places");
+                }
+            }
+            else syntaxError("Invalid field width");
+        }
+    }
+
+    if (hasArgument)
+    {
+        if (!isString) code->emit(Opcode::PRINT_NUMBER, formatCount, offset);
+        else if (formatCount == 0)
+        {
+            code->emit(Opcode::PRINT_STRING, stringIndex, offset);
+        }
+        else code->emit(Opcode::PRINT_STRING_WIDTH, stringIndex, offset);
+    }
+
+    if (currentToken->type == RPAREN)
+    {
+        currentToken = nextToken();  // consume )
+    }
+    else syntaxError("Missing right parenthesis");
+
+    return hasArgument;
+}
+
+int CodeParser::parseExpression()
+{
+    // The current token should now be an identifier, a number or (
+    //
+    // The same operator precedence parse as Parser::parseExpression(),
+    // except that operands are emitted as they're parsed and an operator
+    // is emitted when it's reduced, so only an operator stack and the
+    // operands' typings are needed.
+
+    vector<TokenType> operators;
+    vector<int> operands;  // the typing of each operand on the stack
+    int openCount = 0;     // unmatched ( markers on the operator stack
+
+    while (true)
+    {
+        while (currentToken->type == LPAREN)
+        {
+            operators.push_back(LPAREN);
+            openCount++;
+            currentToken = nextToken();  // consume (
+        }
+
+        operands.push_back(parseOperand());
+
+        // Close any parenthesized subexpressions that end here.
+        while ((currentToken->type == RPAREN) && (openCount > 0))
+        {
+            while (operators.back() != LPAREN) reduce(operators, operands);
+            operators.pop_back();
+            openCount--;
+            currentToken = nextToken();  // consume )
+        }
+
+        TokenType tokenType = currentToken->type;
+        int precedence = Parser::precedences[(int) tokenType];
+        if (precedence == Parser::NO_OPERATOR) break;
+
+        // Reduce the pending operators that bind at least as tightly.
+        while (   !operators.empty()
+               && (Parser::precedences[(int) operators.back()] > precedence))
+        {
+            reduce(operators, operands);
+        }
+
+        // A second relational operator ends the expression.
+        if (   (precedence == Parser::RELATIONAL) && !operators.empty()
+            && (   Parser::precedences[(int) operators.back()]
+                == Parser::RELATIONAL))
+        {
+            break;
+        }
+
+        while (   !operators.empty()
+               && (Parser::precedences[(int) operators.back()] == precedence))
+        {
+            reduce(operators, operands);
+        }
+
+        operators.push_back(tokenType);
+        currentToken = nextToken();  // consume the operator
+    }
+
+    // Reduce what remains. Each unmatched ( is an error.
+    while (!operators.empty())
+    {
+        if (operators.back() == LPAREN)
+        {
+            operators.pop_back();
+            syntaxError("Expecting )");
+        }
+        else reduce(operators, operands);
+    }
+
+    return operands.back();
+}
+
+void CodeParser::reduce(vector<TokenType> &operators, vector<int> &operands)
+{
+    // Both operands are already on the stack.
+    Opcode opcode;
+    int second = operands.back();
+    operands.pop_back();
+    int first = operands.back();
+    operands.pop_back();
+
+    switch (Parser::operatorNodes[(int) operators.back()])
+    {
+        case EQ       : opcode = Opcode::EQ;       break;
+        case LT       : opcode = Opcode::LT;       break;
+        case GT       : opcode = Opcode::GT;       break;
+        case ADD      : opcode = Opcode::ADD;      break;
+        case SUBTRACT : opcode = Opcode::SUBTRACT; break;
+        case MULTIPLY : opcode = Opcode::MULTIPLY; break;
+
+        case INTEGER_DIVIDE : opcode = Opcode::INTEGER_DIVIDE; break;
+        case MODULO         : opcode = Opcode::MODULO;         break;
+
+        default       : opcode = Opcode::DIVIDE;   break;
+    }
+
+    operators.pop_back();
+    int instruction = code->emit(opcode, 0, offset);
+
+    // Like the TypeChecker's types of the expression nodes.
+    int typing;
+    switch (opcode)
+    {
+        case Opcode::ADD :
+        case Opcode::SUBTRACT :
+        case Opcode::MULTIPLY :
+            typing = newTyping(TypingKind::BOTH, first, second);
+            operations.push_back({instruction, typing});
+            break;
+
+        case Opcode::EQ :
+        case Opcode::LT :
+        case Opcode::GT :
+            operations.push_back({instruction,
+                                  newTyping(TypingKind::BOTH, first, second)});
+            typing = newTyping(TypingKind::OTHER);
+            break;
+
+        case Opcode::INTEGER_DIVIDE :
+        case Opcode::MODULO :
+            integerChecks.push_back({first, second,
+                                     opcode == Opcode::MODULO, offset});
+            typing = newTyping(TypingKind::INTEGER);
+            break;
+
+        default : typing = newTyping(TypingKind::OTHER); break;
+    }
+
+    operands.push_back(typing);
+}
+
+int CodeParser::parseOperand()
+{
+    // The current token should now be an identifier or a number.
+
+    if (currentToken->type == IDENTIFIER) return parseVariable();
+
+    else if (   (currentToken->type == INTEGER)
+             || (currentToken->type == REAL))
+    {
+        bool integer = currentToken->type == INTEGER;
+        int constant = integer ? code->addInteger(currentToken->value.L)
+                               : code->addConstant(currentToken->value.D);
+
+        code->emit(Opcode::PUSH, constant, offset);
+        currentToken = nextToken();  // consume the number
+
+        return newTyping(integer ? TypingKind::INTEGER : TypingKind::OTHER);
+    }
+
+    else syntaxError("Unexpected token");
+
+    return newTyping(TypingKind::OTHER);
+}
+
+int CodeParser::parseVariable()
+{
+    // The current token should now be an identifier.
+
+    // Has the variable been "declared"?
+    string variableName = currentToken->text;
+    SymtabEntry *variableId = symtab->lookup(toLowerCase(variableName));
+    if (variableId == nullptr) semanticError("Undeclared identifier");
+
+    int slot = slotOf(variableId, variableName);
+    code->emit(Opcode::LOAD, slot, offset);
+    currentToken = nextToken();  // consume the identifier
+
+    return newTyping(TypingKind::VARIABLE, slot);
+}
+
+int CodeParser::assignedSlot()
+{
+    // Enter the current token's variable into the symbol table
+    // if it isn't already in there.
+    string variableName = currentToken->text;
+    SymtabEntry *variableId = symtab->lookup(toLowerCase(variableName));
+    if (variableId == nullptr) variableId = symtab->enter(variableName);
+
+    return slotOf(variableId, variableName);
+}
+
+int CodeParser::slotOf(SymtabEntry *variableId, string name)
+{
+    // Allocate the variable's frame slot on first use.
+    auto it = slots.find(variableId);
+    if (it != slots.end()) return it->second;
+
+    int slot = code->variables.size();
+    code->variables.push_back(name);
+    slotEntries.push_back(variableId);
+    slots[variableId] = slot;
+
+    return slot;
+}
+
+int CodeParser::hiddenSlot(string name)
+{
+    // A slot that no variable name can refer to.
+    code->variables.push_back(name);
+    slotEntries.push_back(nullptr);
+
+    return code->variables.size() - 1;
+}
+
+int CodeParser::emitJump(Opcode opcode)
+{
+    // The target is backpatched once it is known.
+    return code->emit(opcode, -1, offset);
+}
+
+int CodeParser::newTyping(TypingKind kind, int first, int second)
+{
+    typings.push_back({kind, first, second});
+    return typings.size() - 1;
+}
+
+void CodeParser::checkTypes()
+{
+    // An unassigned variable, such as one set from outside the program,
+    // keeps its entry's type. Start every assigned one as an INTEGER
+    // and widen to REAL each one that is assigned anything else, until
+    // none changes. A type only widens, so this stops.
+    int slotCount = code->variables.size();
+    vector<bool> integerSlots(slotCount);
+    vector<bool> integers(typings.size());
+
+    for (int slot = 0; slot < slotCount; slot++)
+    {
+        SymtabEntry *variableId = slotEntries[slot];
+        integerSlots[slot] =    (variableId != nullptr)
+                             && (variableId->getType() == ValueType::INTEGER);
+    }
+    for (auto &assignment : assignments) integerSlots[assignment.first] = true;
+
+    bool changed = true;
+    while (changed)
+    {
+        // Operands come before their results.
+        for (size_t i = 0; i < typings.size(); i++)
+        {
+            Typing &typing = typings[i];
+
+            switch (typing.kind)
+            {
+                case TypingKind::INTEGER  : integers[i] = true;  break;
+                case TypingKind::OTHER    : integers[i] = false; break;
+                case TypingKind::VARIABLE :
+                    integers[i] = integerSlots[typing.first];
+                    break;
+                case TypingKind::BOTH :
+                    integers[i] =    integers[typing.first]
+                                  && integers[typing.second];
+                    break;
+            }
+        }
+
+        changed = false;
+        for (auto &assignment : assignments)
+        {
+            if (integerSlots[assignment.first] && !integers[assignment.second])
+            {
+                integerSlots[assignment.first] = false;
+                changed = true;
+            }
+        }
+    }
+
+    for (int slot = 0; slot < slotCount; slot++)
+    {
+        if (slotEntries[slot] != nullptr)
+        {
+            slotEntries[slot]->setType(integerSlots[slot] ? ValueType::INTEGER
+                                                          : ValueType::REAL);
+        }
+    }
+
+    // Operate on INTEGER operands in integers.
+    for (auto &operation : operations)
+    {
+        if (!integers[operation.second]) continue;
+
+        Opcode &opcode = code->instructions[operation.first].opcode;
+        switch (opcode)
+        {
+            case Opcode::ADD :      opcode = Opcode::ADD_INT;      break;
+            case Opcode::SUBTRACT : opcode = Opcode::SUBTRACT_INT; break;
+            case Opcode::MULTIPLY : opcode = Opcode::MULTIPLY_INT; break;
+            case Opcode::EQ :       opcode = Opcode::EQ_INT;       break;
+            case Opcode::LT :       opcode = Opcode::LT_INT;       break;
+            case Opcode::GT :       opcode = Opcode::GT_INT;       break;
+
+            default : break;
+        }
+    }
+
+    for (IntegerCheck &check : integerChecks)
+    {
+        if (!integers[check.first] || !integers[check.second])
+        {
+            typeError(string("Integer operands required for ")
+                      + (check.modulo ? "MOD" : "DIV"), check.offset);
+        }
+    }
+}
+
+void CodeParser::syntaxError(string message)
+{
+    source->output() << "SYNTAX ERROR at line " << source->lineNumber(offset)
+                     << ": " << message << " at '" << tokenText()
+                     << "'" << endl;
+    errorCount++;
+
+    // Recover by skipping the rest of the statement.
+    // Skip to a statement follower token.
+    currentToken = nextToken();
+    while (Parser::statementFollowers.find(currentToken->type) ==
+                                                Parser::statementFollowers.end())
+    {
+        currentToken = nextToken();
+    }
+}
+
+void CodeParser::semanticError(string message)
+{
+    source->output() << "SEMANTIC ERROR at line " << source->lineNumber(offset)
+                     << ": " << message << " at '" << tokenText()
+                     << "'" << endl;
+    errorCount++;
+}
+
+void CodeParser::typeError(string message, int offset)
+{
+    source->output() << "TYPE ERROR at line " << source->lineNumber(offset)
+                     << ": " << message << endl;
+    errorCount++;
+}
+
+}  // namespace frontend
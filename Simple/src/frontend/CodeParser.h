@@ -0,0 +1,156 @@
+/**
+ * Code parser class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef CODEPARSER_H_
+#define CODEPARSER_H_
+
+#include <map>
+#include <vector>
+
+#include "Scanner.h"
+#include "Token.h"
+#include "TokenBuffer.h"
+#include "Parser.h"
+#include "../intermediate/Symtab.h"
+#include "../intermediate/Code.h"
+
+namespace frontend {
+
+using namespace std;
+using namespace intermediate;
+
+/**
+ * A single-pass alternative to the Parser that emits stack machine
+ * instructions while it parses instead of building a parse tree.
+ * Forward jumps are emitted with a placeholder target and backpatched
+ * once the target is known. It accepts the same language and reports
+ * the same errors as the Parser, whose token sets it shares.
+ *
+ * A variable's type depends on every assignment to it, so the types are
+ * inferred once the whole program is parsed, by the TypeChecker's rules.
+ * While parsing, each operand gets a typing that says how its type
+ * follows from the types of the variables that it reads. Then each
+ * arithmetic or relational instruction whose operands are INTEGER
+ * becomes its _INT form.
+ */
+class CodeParser
+{
+private:
+    // An operand is INTEGER or not outright, INTEGER if a variable is,
+    // or INTEGER if both of two other operands are.
+    enum class TypingKind { INTEGER, OTHER, VARIABLE, BOTH };
+
+    struct Typing
+    {
+        TypingKind kind;
+        int first;   // the variable's slot, or the first operand's typing
+        int second;  // the second operand's typing
+    };
+
+    // A DIV or MOD, whose operands must both be INTEGER.
+    struct IntegerCheck
+    {
+        int first, second;  // the operands' typings
+        bool modulo;
+        int offset;         // source offset of the statement
+    };
+
+    Scanner *scanner;
+    TokenBuffer *tokens;    // pre-scanned tokens, or null to stream
+    int position;           // index of the next buffered token
+    Token *bufferedToken;   // reused for each buffered token,
+                            // or the last streamed one
+    Source *source;
+    Symtab *symtab;
+    Code *code;
+    map<SymtabEntry *, int> slots;  // variable slots in the code's frame
+    vector<SymtabEntry *> slotEntries;  // each slot's entry, null if hidden
+    vector<Typing> typings;         // operands before their results
+    vector<pair<int, int>> assignments;  // each stored slot and typing
+    vector<pair<int, int>> operations;   // each instruction with an _INT
+                                         // form and its operands' typing
+    vector<IntegerCheck> integerChecks;
+    Token *currentToken;
+    int offset;             // source offset of the current statement
+    int errorCount;
+
+public:
+    /**
+     * Constructor to parse tokens as the scanner produces them.
+     * @param scanner the scanner.
+     * @param symtab the symbol table.
+     */
+    CodeParser(Scanner *scanner, Symtab *symtab)
+        : scanner(scanner), tokens(nullptr), position(0),
+          bufferedToken(nullptr), source(scanner->getSource()),
+          symtab(symtab), code(new Code()), currentToken(nullptr),
+          offset(0), errorCount(0) {}
+
+    /**
+     * Constructor to parse tokens that were all scanned beforehand.
+     * @param tokens the token buffer.
+     * @param symtab the symbol table.
+     */
+    CodeParser(TokenBuffer *tokens, Symtab *symtab)
+        : scanner(nullptr), tokens(tokens), position(0),
+          bufferedToken(new Token(' ')), source(tokens->getSource()),
+          symtab(symtab), code(new Code()), currentToken(nullptr),
+          offset(0), errorCount(0) {}
+
+    ~CodeParser() { delete bufferedToken; }
+
+    int getErrorCount() const { return errorCount; }
+    Source *getSource() const { return source; }
+
+    /**
+     * Getter.
+     * @return the number of tokens scanned, buffered or streamed.
+     */
+    int getTokenCount() const
+    {
+        return tokens != nullptr ? tokens->size() : scanner->getTokenCount();
+    }
+
+    Code *parseProgram();
+
+private:
+    Token *nextToken();
+    string tokenText() const;
+
+    void parseStatement();
+    void parseAssignmentStatement();
+    void parseCompoundStatement();
+    void parseRepeatStatement();
+    void parseWhileStatement();
+    void parseIfStatement();
+    void parseForStatement();
+    void parseWriteStatement();
+    void parseWritelnStatement();
+    int parseExpression();
+    int parseOperand();
+    int parseVariable();
+
+    void parseStatementList(TokenType terminalType);
+    bool parseWriteArguments();
+    void reduce(vector<TokenType> &operators, vector<int> &operands);
+
+    int assignedSlot();
+    int slotOf(SymtabEntry *variableId, string name);
+    int hiddenSlot(string name);
+    int emitJump(Opcode opcode);
+
+    int newTyping(TypingKind kind, int first = -1, int second = -1);
+    void checkTypes();
+
+    void syntaxError(string message);
+    void semanticError(string message);
+    void typeError(string message, int offset);
+};
+
+}  // namespace frontend
+
+#endif /* CODEPARSER_H_ */
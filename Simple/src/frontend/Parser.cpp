@@ -7,62 +7,114 @@
  */
 #include <string>
 #include <map>
+#include <array>
 
 #include "Token.h"
+#include "TypeChecker.h"
 #include "Parser.h"
 
 namespace frontend {
 
 using namespace std;
 
-set<TokenType> Parser::statementStarters;
-set<TokenType> Parser::statementFollowers;
-set<TokenType> Parser::relationalOperators;
-set<TokenType> Parser::simpleExpressionOperators;
-set<TokenType> Parser::termOperators;
-set<TokenType> Parser::factorOperators;
+// The token sets and operator tables are built before main()
+// and never modified, so any number of parsers can share them.
 
-void Parser::initialize()
+// Tokens that can start a statement.
+const set<TokenType> Parser::statementStarters =
 {
-    // Tokens that can start a statement.
-    statementStarters.insert(BEGIN);
-    statementStarters.insert(IDENTIFIER);
-    statementStarters.insert(REPEAT);
-    statementStarters.insert(WHILE);
-    statementStarters.insert(DO);
-    statementStarters.insert(IF);
-    statementStarters.insert(TokenType::WRITE);
-    statementStarters.insert(TokenType::WRITELN);
-
-    // Tokens that can immediately follow a statement.
-    statementFollowers.insert(SEMICOLON);
-    statementFollowers.insert(END);
-    statementFollowers.insert(UNTIL);
-    statementFollowers.insert(END_OF_FILE);
-
-    relationalOperators.insert(EQUALS);
-    relationalOperators.insert(LESS_THAN);
-    relationalOperators.insert(GREATER_THAN);
-
-    simpleExpressionOperators.insert(PLUS);
-    simpleExpressionOperators.insert(MINUS);
-
-    termOperators.insert(STAR);
-    termOperators.insert(SLASH);
-
-    factorOperators.insert(TokenType::NOT);
-    factorOperators.insert(TokenType::IF);
+    BEGIN, IDENTIFIER, REPEAT, WHILE, DO, IF, FOR,
+    TokenType::WRITE, TokenType::WRITELN
+};
+
+// Tokens that can immediately follow a statement.
+const set<TokenType> Parser::statementFollowers =
+{
+    SEMICOLON, END, UNTIL, END_OF_FILE
+};
+
+const set<TokenType> Parser::factorOperators =
+{
+    TokenType::NOT, TokenType::IF
+};
+
+/**
+ * Build the precedence table of the binary operators.
+ * Every other token type has NO_OPERATOR.
+ * @return the table, indexed by token type.
+ */
+static array<int, TOKEN_TYPE_COUNT> makePrecedences()
+{
+    array<int, TOKEN_TYPE_COUNT> precedences {};
+
+    precedences[(int) EQUALS]       = Parser::RELATIONAL;
+    precedences[(int) LESS_THAN]    = Parser::RELATIONAL;
+    precedences[(int) GREATER_THAN] = Parser::RELATIONAL;
+    precedences[(int) PLUS]         = Parser::ADDITIVE;
+    precedences[(int) MINUS]        = Parser::ADDITIVE;
+    precedences[(int) STAR]         = Parser::MULTIPLICATIVE;
+    precedences[(int) SLASH]        = Parser::MULTIPLICATIVE;
+    precedences[(int) DIV]          = Parser::MULTIPLICATIVE;
+    precedences[(int) MOD]          = Parser::MULTIPLICATIVE;
+
+    return precedences;
+}
+
+/**
+ * Build the table of the binary operators' parse tree node types.
+ * @return the table, indexed by token type.
+ */
+static array<NodeType, TOKEN_TYPE_COUNT> makeOperatorNodes()
+{
+    array<NodeType, TOKEN_TYPE_COUNT> operatorNodes {};
+
+    operatorNodes[(int) EQUALS]       = EQ;
+    operatorNodes[(int) LESS_THAN]    = LT;
+    operatorNodes[(int) GREATER_THAN] = GT;
+    operatorNodes[(int) PLUS]         = ADD;
+    operatorNodes[(int) MINUS]        = SUBTRACT;
+    operatorNodes[(int) STAR]         = MULTIPLY;
+    operatorNodes[(int) SLASH]        = DIVIDE;
+    operatorNodes[(int) DIV]          = INTEGER_DIVIDE;
+    operatorNodes[(int) MOD]          = MODULO;
+
+    return operatorNodes;
+}
+
+const array<int, TOKEN_TYPE_COUNT> Parser::precedences = makePrecedences();
+const array<NodeType, TOKEN_TYPE_COUNT> Parser::operatorNodes =
+                                                        makeOperatorNodes();
+
+Token *Parser::nextToken()
+{
+    if (tokens == nullptr)
+    {
+        // Each streamed token replaces the one before.
+        delete bufferedToken;
+        bufferedToken = scanner->nextToken();
+        return bufferedToken;
+    }
+
+    // Walk the token buffer by index.
+    tokens->load(position++, bufferedToken);
+    return bufferedToken;
+}
+
+string Parser::tokenText() const
+{
+    // A buffered token holds no text unless it's an identifier.
+    return tokens != nullptr ? tokens->text(position - 1) : currentToken->text;
 }
 
 Node *Parser::parseProgram()
 {
     Node *programNode = new Node(NodeType::PROGRAM);
 
-    currentToken = scanner->nextToken();  // first token!
+    currentToken = nextToken();  // first token!
 
     if (currentToken->type == TokenType::PROGRAM)
     {
-        currentToken = scanner->nextToken();  // consume PROGRAM
+        currentToken = nextToken();  // consume PROGRAM
     }
     else syntaxError("Expecting PROGRAM");
 
@@ -72,13 +124,13 @@ Node *Parser::parseProgram()
         symtab->enter(programName);
         programNode->text = programName;
 
-        currentToken = scanner->nextToken();  // consume program name
+        currentToken = nextToken();  // consume program name
     }
     else syntaxError("Expecting program name");
 
     if (currentToken->type == SEMICOLON)
     {
-        currentToken = scanner->nextToken();  // consume ;
+        currentToken = nextToken();  // consume ;
     }
     else syntaxError("Missing ;");
 
@@ -88,14 +140,35 @@ Node *Parser::parseProgram()
     programNode->adopt(parseCompoundStatement());
 
     if (currentToken->type == SEMICOLON) syntaxError("Expecting .");
+
+    // Type the program only if it parsed.
+    if (errorCount == 0)
+    {
+        TypeChecker checker(source, symtab);
+        errorCount += checker.check(programNode);
+        depth = checker.getDepth();
+        deepOffset = checker.getDeepOffset();
+    }
+
     return programNode;
 }
 
+int Parser::checkDepth()
+{
+    if (depth <= MAX_DEPTH) return 0;
+
+    source->output() << "NESTING ERROR at line "
+                     << source->lineNumber(deepOffset) << ": Parse tree is "
+                     << depth << " levels deep, more than " << MAX_DEPTH
+                     << endl;
+    return 1;
+}
+
 Node *Parser::parseStatement()
 {
     Node *stmtNode = nullptr;
-    int savedLineNumber = currentToken->lineNumber;
-    lineNumber = savedLineNumber;
+    int savedOffset = currentToken->offset;
+    offset = savedOffset;
 
     switch (currentToken->type)
     {
@@ -104,6 +177,7 @@ Node *Parser::parseStatement()
         case REPEAT		:	stmtNode = parseRepeatStatement();     break;
         case WHILE 		:   stmtNode = parseWhileStatement();     break;
         case IF			:   stmtNode = parseIfStatement();     	break;
+        case FOR 		:   stmtNode = parseForStatement();     break;
         case WRITE 		:   stmtNode = parseWriteStatement();      break;
         case WRITELN 	:   stmtNode = parseWritelnStatement();    break;
         case SEMICOLON 	:   stmtNode = nullptr; break;  // empty statement
@@ -112,7 +186,7 @@ Node *Parser::parseStatement()
         default : syntaxError("Unexpected token");
     }
 
-    if (stmtNode != nullptr) stmtNode->lineNumber = savedLineNumber;
+    if (stmtNode != nullptr) stmtNode->offset = savedOffset;
     return stmtNode;
 }
 
@@ -134,11 +208,11 @@ Node *Parser::parseAssignmentStatement()
     lhsNode->entry = variableId;
     assignmentNode->adopt(lhsNode);
 
-    currentToken = scanner->nextToken();  // consume the LHS variable;
+    currentToken = nextToken();  // consume the LHS variable;
 
     if (currentToken->type == COLON_EQUALS)
     {
-        currentToken = scanner->nextToken();  // consume :=
+        currentToken = nextToken();  // consume :=
     }
     else syntaxError("Missing :=");
 
@@ -152,14 +226,14 @@ Node *Parser::parseAssignmentStatement()
 Node *Parser::parseCompoundStatement()
 {
     Node *compoundNode = new Node(COMPOUND);
-    compoundNode->lineNumber = currentToken->lineNumber;
+    compoundNode->offset = currentToken->offset;
 
-    currentToken = scanner->nextToken();  // consume BEGIN
+    currentToken = nextToken();  // consume BEGIN
     parseStatementList(compoundNode, END);
 
     if (currentToken->type == END)
     {
-        currentToken = scanner->nextToken();  // consume END
+        currentToken = nextToken();  // consume END
     }
     else syntaxError("Expecting END");
 
@@ -179,7 +253,7 @@ void Parser::parseStatementList(Node *parentNode, TokenType terminalType)
         {
             while (currentToken->type == SEMICOLON)
             {
-                currentToken = scanner->nextToken();  // consume ;
+                currentToken = nextToken();  // consume ;
             }
         }
         else if (statementStarters.find(currentToken->type) !=
@@ -196,7 +270,7 @@ Node *Parser::parseRepeatStatement()
 
     // Create a LOOP node.
     Node *loopNode = new Node(LOOP);
-    currentToken = scanner->nextToken();  // consume REPEAT
+    currentToken = nextToken();  // consume REPEAT
 
     parseStatementList(loopNode, UNTIL);
 
@@ -204,9 +278,9 @@ Node *Parser::parseRepeatStatement()
     {
         // Create a TEST node. It adopts the test expression node.
         Node *testNode = new Node(TEST);
-        lineNumber = currentToken->lineNumber;
-        testNode->lineNumber = lineNumber;
-        currentToken = scanner->nextToken();  // consume UNTIL
+        offset = currentToken->offset;
+        testNode->offset = offset;
+        currentToken = nextToken();  // consume UNTIL
 
         testNode->adopt(parseExpression());
 
@@ -224,7 +298,7 @@ Node *Parser::parseWhileStatement()
 
 	// Create a LOOP node->
 	Node *loopNode = new Node(LOOP);
-	currentToken = scanner->nextToken(); // consume WHILE
+	currentToken = nextToken(); // consume WHILE
 
 	Node *testNode = new Node(TEST);
 	Node *notNode = new Node(NodeType::NOT);
@@ -236,7 +310,7 @@ Node *Parser::parseWhileStatement()
 	//missing some line # stuff still
 
 	if (currentToken->type == DO) {
-		currentToken = scanner->nextToken(); //consume DO?
+		currentToken = nextToken(); //consume DO?
 		loopNode->adopt(parseStatement());
 	}
 	else
@@ -249,17 +323,13 @@ Node *Parser::parseForStatement(){
 
     Node *compoundNode = new Node(COMPOUND);
 
-
-    Node *newValue = new Node(INTEGER_CONSTANT);
-
     SymtabEntry *a;
     Node *oldVariable = new Node(VARIABLE);
     if(currentToken->type == FOR)
     {
-        currentToken = scanner->nextToken(); // Consume FOR
+        currentToken = nextToken(); // Consume FOR
 
         //Since For statement needs to keep track of previous variables, store them
-        oldVariable->value = currentToken->value;
         string variablename= toLowerCase(currentToken->text);
         oldVariable->text = currentToken->text;
 
@@ -286,14 +356,12 @@ Node *Parser::parseForStatement(){
             		addNode = new Node(SUBTRACT);
             	}
 
-        currentToken = scanner->nextToken(); //Consumes TO/DOWNTO
+        currentToken = nextToken(); //Consumes TO/DOWNTO
 
 
-        newValue->value = currentToken->value;
-        currentToken = scanner->nextToken();
-
         gtltNode->adopt(oldVariable); //create assignment
-        gtltNode->adopt(newValue);
+        gtltNode->adopt(hiddenLimit(compoundNode, parseExpression())); //the limit
+
 
         Node *testNode = new Node(TEST); //create a test node
         testNode->adopt(gtltNode);
@@ -301,7 +369,11 @@ Node *Parser::parseForStatement(){
         Node *loopNode = new Node(LOOP); //create loop in parse tree
         loopNode->adopt(testNode); //adopt the left hand side of tree (test)
 
-        currentToken = scanner->nextToken();
+        if (currentToken->type == DO)
+        {
+            currentToken = nextToken(); //Consumes DO
+        }
+        else syntaxError("Expecting DO");
 
         loopNode->adopt(parseStatement()); //adopt middle part of tree (DO statement)
 
@@ -309,6 +381,7 @@ Node *Parser::parseForStatement(){
 
         int constant = 1;
         Node *Constant = new Node(INTEGER_CONSTANT);
+        Constant->value.L = constant;
         Constant->value.D = constant;
         addNode->adopt(Constant);
 
@@ -323,11 +396,42 @@ Node *Parser::parseForStatement(){
     return compoundNode;
 }
 
+Node *Parser::hiddenLimit(Node *forNode, Node *limitNode)
+{
+    // A constant limit can't change.
+    if (   (limitNode->type == INTEGER_CONSTANT)
+        || (limitNode->type == REAL_CONSTANT)) return limitNode;
+
+    // Evaluate any other limit once, after the control variable's
+    // initial assignment, into a variable that no name in the source
+    // can refer to, so that the body can't change it. The CodeParser
+    // does the same.
+    string name;
+    do name = "$limit" + to_string(++limitCount);
+    while (symtab->lookup(name) != nullptr);
+
+    SymtabEntry *limitId = symtab->enter(name);
+
+    Node *assignNode = new Node(ASSIGN);
+    Node *lhsNode    = new Node(VARIABLE);
+    lhsNode->text    = name;
+    lhsNode->entry   = limitId;
+    assignNode->adopt(lhsNode);
+    assignNode->adopt(limitNode);
+    forNode->adopt(assignNode);
+
+    Node *variableNode  = new Node(VARIABLE);
+    variableNode->text  = name;
+    variableNode->entry = limitId;
+
+    return variableNode;
+}
+
 Node *Parser::parseIfStatement()
 {
     // The current token should now be IF.
 	Node *ifNode = new Node(LOOP);
-	currentToken = scanner->nextToken();  // consume IF
+	currentToken = nextToken();  // consume IF
 
 
 	//Parse the expression.
@@ -336,22 +440,19 @@ Node *Parser::parseIfStatement()
 
 	//Find the THEN
 	if (currentToken->type == THEN) {
-		currentToken = scanner->nextToken(); //consume THEN
+		currentToken = nextToken(); //consume THEN
 	}
 	else
 		syntaxError("Expecting THEN");
 
-	printf("finish THEN now: '%s' \n", currentToken->text.c_str());
-
 	//parse the THEN statement
 	//IF node adopts the statement as the second child
 	ifNode->adopt(parseExpression());
-	currentToken = scanner->nextToken();  // consume
-	printf("finish adding child now: '%s' \n", currentToken->text.c_str());
+	currentToken = nextToken();  // consume
 
 	//Look for else
 	if (currentToken->type == ELSE) {
-		currentToken = scanner->nextToken(); //consume ELSE
+		currentToken = nextToken(); //consume ELSE
 
 		//Parse the else Statement
 		//IF node adopts the statement as the third child
@@ -369,7 +470,7 @@ Node *Parser::parseWriteStatement()
 
     // Create a WRITE node-> It adopts the variable or string node.
     Node *writeNode = new Node(NodeType::WRITE);
-    currentToken = scanner->nextToken();  // consume WRITE
+    currentToken = nextToken();  // consume WRITE
 
     parseWriteArguments(writeNode);
     if (writeNode->children.size() == 0)
@@ -386,7 +487,7 @@ Node *Parser::parseWritelnStatement()
 
     // Create a WRITELN node. It adopts the variable or string node.
     Node *writelnNode = new Node(NodeType::WRITELN);
-    currentToken = scanner->nextToken();  // consume WRITELN
+    currentToken = nextToken();  // consume WRITELN
 
     if (currentToken->type == LPAREN) parseWriteArguments(writelnNode);
     return writelnNode;
@@ -400,7 +501,7 @@ void Parser::parseWriteArguments(Node *node)
 
     if (currentToken->type == LPAREN)
     {
-        currentToken = scanner->nextToken();  // consume (
+        currentToken = nextToken();  // consume (
     }
     else syntaxError("Missing left parenthesis");
 
@@ -422,7 +523,7 @@ void Parser::parseWriteArguments(Node *node)
     {
         if (currentToken->type == COLON)
         {
-            currentToken = scanner->nextToken();  // consume ,
+            currentToken = nextToken();  // consume ,
 
             if (currentToken->type == INTEGER)
             {
@@ -431,7 +532,7 @@ void Parser::parseWriteArguments(Node *node)
 
                 if (currentToken->type == COLON)
                 {
-                    currentToken = scanner->nextToken();  // consume ,
+                    currentToken = nextToken();  // consume ,
 
                     if (currentToken->type == INTEGER)
                     {
@@ -447,119 +548,108 @@ void Parser::parseWriteArguments(Node *node)
 
     if (currentToken->type == RPAREN)
     {
-        currentToken = scanner->nextToken();  // consume )
+        currentToken = nextToken();  // consume )
     }
     else syntaxError("Missing right parenthesis");
 }
 
 Node *Parser::parseExpression()
 {
-    // The current token should now be an identifier or a number.
-
-    // The expression's root node->
-    Node *exprNode = parseSimpleExpression();
-
-    // The current token might now be a relational operator.
-    if (relationalOperators.find(currentToken->type) != relationalOperators.end())
+    // The current token should now be an identifier, a number or (
+    //
+    // Parse by operator precedence with explicit operand and operator
+    // stacks, so the native stack stays flat however deeply the
+    // expression nests. Each ( is pushed onto the operator stack as a
+    // marker that has NO_OPERATOR precedence, so nothing reduces past it.
+
+    vector<Node *> operands;
+    vector<TokenType> operators;
+    int openCount = 0;  // unmatched ( markers on the operator stack
+
+    while (true)
     {
-        TokenType tokenType = currentToken->type;
-        Node *opNode = tokenType == EQUALS    ? new Node(EQ)
-                    : tokenType == LESS_THAN ? new Node(LT)
-                    :                          nullptr;
+        while (currentToken->type == LPAREN)
+        {
+            operators.push_back(LPAREN);
+            openCount++;
+            currentToken = nextToken();  // consume (
+        }
 
-        currentToken = scanner->nextToken();  // consume relational operator
+        operands.push_back(parseOperand());
 
-        // The relational operator node adopts the first simple expression
-        // node as its first child and the second simple expression node
-        // as its second child. Then it becomes the expression's root node.
-        if (opNode != nullptr)
+        // Close any parenthesized subexpressions that end here.
+        while ((currentToken->type == RPAREN) && (openCount > 0))
         {
-            opNode->adopt(exprNode);
-            opNode->adopt(parseSimpleExpression());
-            exprNode = opNode;
+            while (operators.back() != LPAREN) reduce(operands, operators);
+            operators.pop_back();
+            openCount--;
+            currentToken = nextToken();  // consume )
         }
-    }
 
-    return exprNode;
-}
+        TokenType tokenType = currentToken->type;
+        int precedence = precedences[(int) tokenType];
+        if (precedence == NO_OPERATOR) break;
 
-Node *Parser::parseSimpleExpression()
-{
-    // The current token should now be an identifier or a number.
+        // Reduce the pending operators that bind at least as tightly.
+        while (   !operators.empty()
+               && (precedences[(int) operators.back()] > precedence))
+        {
+            reduce(operands, operators);
+        }
 
-    // The simple expression's root node->
-    Node *simpExprNode = parseTerm();
+        // A second relational operator ends the expression.
+        if (   (precedence == RELATIONAL) && !operators.empty()
+            && (precedences[(int) operators.back()] == RELATIONAL))
+        {
+            break;
+        }
 
-    // Keep parsing more terms as long as the current token
-    // is a + or - operator.
-    while (simpleExpressionOperators.find(currentToken->type) !=
-                                                simpleExpressionOperators.end())
-    {
-        Node *opNode = currentToken->type == PLUS ? new Node(ADD)
-                                                : new Node(SUBTRACT);
+        while (   !operators.empty()
+               && (precedences[(int) operators.back()] == precedence))
+        {
+            reduce(operands, operators);
+        }
 
-        currentToken = scanner->nextToken();  // consume the operator
+        operators.push_back(tokenType);
+        currentToken = nextToken();  // consume the operator
+    }
 
-        // The add or subtract node adopts the first term node as its
-        // first child and the next term node as its second child.
-        // Then it becomes the simple expression's root node.
-        opNode->adopt(simpExprNode);
-        opNode->adopt(parseTerm());
-        simpExprNode = opNode;
+    // Reduce what remains. Each unmatched ( is an error.
+    while (!operators.empty())
+    {
+        if (operators.back() == LPAREN)
+        {
+            operators.pop_back();
+            syntaxError("Expecting )");
+        }
+        else reduce(operands, operators);
     }
 
-    return simpExprNode;
+    return operands.back();
 }
 
-Node *Parser::parseTerm()
+void Parser::reduce(vector<Node *> &operands, vector<TokenType> &operators)
 {
-    // The current token should now be an identifier or a number.
-
-    // The term's root node->
-    Node *termNode = parseFactor();
-
-    // Keep parsing more factors as long as the current token
-    // is a * or / operator.
-    while (termOperators.find(currentToken->type) != termOperators.end())
-    {
-        Node *opNode = currentToken->type == STAR ? new Node(MULTIPLY)
-                                                : new Node(DIVIDE);
-
-        currentToken = scanner->nextToken();  // consume the operator
-
-        // The multiply or divide node adopts the first factor node as its
-        // as its first child and the next factor node as its second child.
-        // Then it becomes the term's root node.
-        opNode->adopt(termNode);
-        opNode->adopt(parseFactor());
-        termNode = opNode;
-    }
-
-    return termNode;
+    // The operator node adopts the two topmost operands
+    // and replaces them on the operand stack.
+    Node *opNode = new Node(operatorNodes[(int) operators.back()]);
+    operators.pop_back();
+
+    Node *rhsNode = operands.back();
+    operands.pop_back();
+    opNode->adopt(operands.back());
+    opNode->adopt(rhsNode);
+    operands.back() = opNode;
 }
 
-Node *Parser::parseFactor()
+Node *Parser::parseOperand()
 {
-    // The current token should now be an identifier or a number or (
+    // The current token should now be an identifier or a number.
 
     if      (currentToken->type == IDENTIFIER) return parseVariable();
     else if (currentToken->type == INTEGER)    return parseIntegerConstant();
     else if (currentToken->type == REAL)       return parseRealConstant();
 
-    else if (currentToken->type == LPAREN)
-    {
-        currentToken = scanner->nextToken();  // consume (
-        Node *exprNode = parseExpression();
-
-        if (currentToken->type == RPAREN)
-        {
-            currentToken = scanner->nextToken();  // consume )
-        }
-        else syntaxError("Expecting )");
-
-        return exprNode;
-    }
-
     else syntaxError("Unexpected token");
     return nullptr;
 }
@@ -577,7 +667,7 @@ Node *Parser::parseVariable()
     node->text  = variableName;
     node->entry = variableId;
 
-    currentToken = scanner->nextToken();  // consume the identifier
+    currentToken = nextToken();  // consume the identifier
     return node;
 }
 
@@ -588,7 +678,7 @@ Node *Parser::parseIntegerConstant()
     Node *integerNode = new Node(INTEGER_CONSTANT);
     integerNode->value = currentToken->value;
 
-    currentToken = scanner->nextToken();  // consume the number
+    currentToken = nextToken();  // consume the number
     return integerNode;
 }
 
@@ -599,7 +689,7 @@ Node *Parser::parseRealConstant()
     Node *realNode = new Node(REAL_CONSTANT);
     realNode->value = currentToken->value;
 
-    currentToken = scanner->nextToken();  // consume the number
+    currentToken = nextToken();  // consume the number
     return realNode;
 }
 
@@ -608,34 +698,36 @@ Node *Parser::parseStringConstant()
     // The current token should now be string.
 
     Node *stringNode = new Node(STRING_CONSTANT);
-    stringNode->value = currentToken->value;
+    stringNode->text = currentToken->value.S;
 
-    currentToken = scanner->nextToken();  // consume the string
+    currentToken = nextToken();  // consume the string
     return stringNode;
 }
 
 void Parser::syntaxError(string message)
 {
-    printf("SYNTAX ERROR at line %d: %s at '%s'\n",
-           lineNumber, message.c_str(), currentToken->text.c_str());
+    source->output() << "SYNTAX ERROR at line " << source->lineNumber(offset)
+                     << ": " << message << " at '" << tokenText()
+                     << "'" << endl;
     errorCount++;
 
     //ADDED IN - needed line 517  in order for it not to be a infinite loop
-    currentToken = scanner->nextToken();
+    currentToken = nextToken();
     // Recover by skipping the rest of the statement.
     // Skip to a statement follower token.
 //    printf("recovery attempt \n");
     while (statementFollowers.find(currentToken->type) ==
                                                     statementFollowers.end())
     {
-        currentToken = scanner->nextToken();
+        currentToken = nextToken();
     }
 }
 
 void Parser::semanticError(string message)
 {
-    printf("SEMANTIC ERROR at line %d: %s at '%s'\n",
-           lineNumber, message.c_str(), currentToken->text.c_str());
+    source->output() << "SEMANTIC ERROR at line " << source->lineNumber(offset)
+                     << ": " << message << " at '" << tokenText()
+                     << "'" << endl;
     errorCount++;
 }
 
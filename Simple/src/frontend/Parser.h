@@ -9,9 +9,12 @@
 #define PARSER_H_
 
 #include <set>
+#include <array>
+#include <vector>
 
 #include "Scanner.h"
 #include "Token.h"
+#include "TokenBuffer.h"
 #include "../intermediate/Symtab.h"
 #include "../intermediate/Node.h"
 
@@ -24,33 +27,91 @@ class Parser
 {
 private:
     Scanner *scanner;
+    TokenBuffer *tokens;    // pre-scanned tokens, or null to stream
+    int position;           // index of the next buffered token
+    Token *bufferedToken;   // reused for each buffered token,
+                            // or the last streamed one
+    Source *source;
     Symtab *symtab;
     Token *currentToken;
-    int lineNumber;
+    int offset;             // source offset of the current statement
     int errorCount;
+    int limitCount;         // hidden FOR limit variables
+    int depth;              // of the parse tree, once it's typed
+    int deepOffset;         // source offset of its deepest statement
 
-    static set<TokenType> statementStarters;          // what starts a statement
-    static set<TokenType> statementFollowers;         // what follows a statement
-    static set<TokenType> relationalOperators;        // relational operators
-    static set<TokenType> simpleExpressionOperators;  // simple expression operators
-    static set<TokenType> termOperators;              // term operators
-    static set<TokenType> factorOperators;			  // factor operators (but this is just NOT)
+    static const set<TokenType> statementStarters;   // what starts a statement
+    static const set<TokenType> statementFollowers;  // what follows a statement
+    static const set<TokenType> factorOperators;	 // factor operators (but this is just NOT)
+
+    static const array<int, TOKEN_TYPE_COUNT> precedences;          // by token type
+    static const array<NodeType, TOKEN_TYPE_COUNT> operatorNodes;   // by token type
+
+    friend class CodeParser;  // shares the token sets and operator tables
 
 public:
+    // Binary operator precedence levels. Relational operators don't
+    // associate: an expression has at most one at each nesting level.
+    static const int NO_OPERATOR    = 0;
+    static const int RELATIONAL     = 1;
+    static const int ADDITIVE       = 2;
+    static const int MULTIPLICATIVE = 3;
+
+    // The deepest parse tree that the passes after parsing may walk.
+    // Fusing, specializing, optimizing, compiling and executing all
+    // recurse once per level, a few hundred bytes of stack each, so
+    // this leaves a wide margin within an 8 MB stack.
+    static const int MAX_DEPTH = 10000;
+
     /**
-     * Initialize the static sets.
+     * Constructor to parse tokens as the scanner produces them.
+     * @param scanner the scanner.
+     * @param symtab the symbol table.
      */
-    static void initialize();
-
     Parser(Scanner *scanner, Symtab *symtab)
-        : scanner(scanner), symtab(symtab), currentToken(nullptr),
-          lineNumber(1), errorCount(0) {}
+        : scanner(scanner), tokens(nullptr), position(0),
+          bufferedToken(nullptr), source(scanner->getSource()),
+          symtab(symtab), currentToken(nullptr), offset(0), errorCount(0),
+          limitCount(0), depth(0), deepOffset(-1) {}
+
+    /**
+     * Constructor to parse tokens that were all scanned beforehand.
+     * @param tokens the token buffer.
+     * @param symtab the symbol table.
+     */
+    Parser(TokenBuffer *tokens, Symtab *symtab)
+        : scanner(nullptr), tokens(tokens), position(0),
+          bufferedToken(new Token(' ')), source(tokens->getSource()),
+          symtab(symtab), currentToken(nullptr), offset(0), errorCount(0),
+          limitCount(0), depth(0), deepOffset(-1) {}
+
+    ~Parser() { delete bufferedToken; }
 
     int getErrorCount() const { return errorCount; }
+    Source *getSource() const { return source; }
+
+    /**
+     * Getter.
+     * @return the number of tokens scanned, buffered or streamed.
+     */
+    int getTokenCount() const
+    {
+        return tokens != nullptr ? tokens->size() : scanner->getTokenCount();
+    }
 
     Node *parseProgram();
 
+    /**
+     * Report a parse tree too deep for the passes after parsing.
+     * Printing the tree has no limit, so only they call this.
+     * @return 1 if the tree is deeper than MAX_DEPTH, else 0.
+     */
+    int checkDepth();
+
 private:
+    Token *nextToken();
+    string tokenText() const;
+
     Node *parseStatement();
     Node *parseAssignmentStatement();
     Node *parseCompoundStatement();
@@ -61,9 +122,7 @@ private:
     Node *parseWriteStatement();
     Node *parseWritelnStatement();
     Node *parseExpression();
-    Node *parseSimpleExpression();
-    Node *parseTerm();
-    Node *parseFactor();
+    Node *parseOperand();
     Node *parseVariable();
     Node *parseIntegerConstant();
     Node *parseRealConstant();
@@ -71,6 +130,8 @@ private:
 
     void parseStatementList(Node *parentNode, TokenType terminalType);
     void parseWriteArguments(Node *node);
+    void reduce(vector<Node *> &operands, vector<TokenType> &operators);
+    Node *hiddenLimit(Node *forNode, Node *limitNode);
 
     void syntaxError(string message);
     void semanticError(string message);
@@ -10,6 +10,7 @@
 
 #include "Source.h"
 #include "Token.h"
+#include "TokenBuffer.h"
 
 namespace frontend {
 
@@ -19,13 +20,26 @@ class Scanner
 {
 private:
     Source *source;
+    int tokenCount;  // tokens scanned so far
 
 public:
     /**
      * Constructor.
      * @param source the input source.
      */
-    Scanner(Source *source) : source(source) {}
+    Scanner(Source *source) : source(source), tokenCount(0) {}
+
+    /**
+     * Getter.
+     * @return the input source.
+     */
+    Source *getSource() const { return source; }
+
+    /**
+     * Getter.
+     * @return the number of tokens scanned so far.
+     */
+    int getTokenCount() const { return tokenCount; }
 
     /**
      * Extract the next token from the source.
@@ -33,23 +47,74 @@ public:
      */
     Token *nextToken()
     {
-        char ch = source->currentChar();
-        skipped:
-        // Skip blanks and other whitespace characters.
-        while (isspace(ch)) ch = source->nextChar();
-
-        if(ch == '{') {
-        	while(ch != '}')
-        		ch = source->nextChar();
-        	ch = source->nextChar();
-        	//while (isspace(ch)) ch = source->nextChar();
-        	goto skipped;
+        tokenCount++;
+
+        char ch = skipBlanks();
+        return scanToken(ch, new Token(ch));
+    }
+
+    /**
+     * Scan the entire source ahead of parsing.
+     * @return the buffer of all the tokens, ending with END_OF_FILE.
+     */
+    TokenBuffer *scanAll()
+    {
+        TokenBuffer *tokens = new TokenBuffer(source);
+        Token token(' ');  // scanned into for every token
+        TokenType type;
+
+        do
+        {
+            char ch = skipBlanks();
+            int start = source->offset();
+
+            token.reset(ch);
+            type = scanToken(ch, &token)->type;
+
+            int end = type == END_OF_FILE ? start : source->offset();
+            tokens->append(&token, start, end - start);
+            tokenCount++;
+        } while (type != END_OF_FILE);
+
+        return tokens;
+    }
+
+private:
+    /**
+     * Skip whitespace and comments.
+     * @return the first character of the next token.
+     */
+    char skipBlanks()
+    {
+        const char *text = source->chars();
+        int length = source->length();
+
+        for (;;)
+        {
+            // Skip blanks and other whitespace characters.
+            int position = CharClass::skipSpaces(text, source->offset(), length);
+            char ch = source->skipTo(position);
+
+            if (ch != '{') return ch;
+
+            // Skip the comment through the closing }.
+            source->skipTo(CharClass::find(text, position + 1, length, '}'));
+            source->nextChar();
         }
+    }
 
-        if (isalpha(ch))      return Token::Word(ch, source);
-        else if (isdigit(ch)) return Token::Number(ch, source);
-        else if (ch == '\'')  return Token::String(ch, source);
-        else                  return Token::SpecialSymbol(ch, source);
+    /**
+     * Scan a token.
+     * @param ch the first character of the token.
+     * @param token the token to scan into, started with ch.
+     * @return the token.
+     */
+    Token *scanToken(char ch, Token *token)
+    {
+        if (isalpha(ch))      return Token::Word(ch, source, token);
+        else if (isdigit(ch)) return Token::Number(ch, source, token);
+        else if (ch == '\'')  return Token::String(ch, source, token);
+        else                  return Token::SpecialSymbol(ch, source, token);
     }
 };
 
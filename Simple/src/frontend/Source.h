@@ -10,19 +10,26 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
 
+#include "CharClass.h"
+#include "../intermediate/LineMap.h"
+
 namespace frontend {
 
 using namespace std;
+using intermediate::LineMap;
 
 class Source
 {
 private:
-    ifstream source;
+    string buffer;     // the entire source text
     string sourceFileName;
-    int  lineNum;      // current source line number
+    int  position;     // offset of the current character in the buffer
     char currentCh;    // current source character
+    LineMap *lineMap;  // line numbers, computed on demand
+    ostream *out;      // where the frontend's error messages go
 
 public:
     static const char EOL = '\n';
@@ -31,9 +38,11 @@ public:
      * Constructor
      * @param sourceFileName the source file name.
      */
-    Source(string sourceFileName) : lineNum(1)
+    Source(string sourceFileName)
+        : sourceFileName(sourceFileName), position(-1), lineMap(nullptr),
+          out(&cout)
     {
-        source.open(sourceFileName);
+        ifstream source(sourceFileName);
 
         if (source.fail())
         {
@@ -41,14 +50,59 @@ public:
             exit(-1);
         }
 
+        // Read the whole file into one contiguous buffer.
+        stringstream contents;
+        contents << source.rdbuf();
+        buffer = contents.str();
+        lineMap = new LineMap(buffer.data(), buffer.length());
+
         currentCh = nextChar();  // read the first character of the file
     }
 
+    /**
+     * Constructor for source text that is already in memory.
+     * @param sourceName a name for the source, such as its file name.
+     * @param text the source text.
+     */
+    Source(string sourceName, string text)
+        : buffer(text), sourceFileName(sourceName), position(-1),
+          lineMap(new LineMap(buffer.data(), buffer.length())), out(&cout)
+    {
+        currentCh = nextChar();  // read the first character
+    }
+
+    ~Source() { delete lineMap; }
+
+    /**
+     * Send the frontend's error messages somewhere other than cout.
+     * @param out the output stream.
+     */
+    void setOutput(ostream *out) { this->out = out; }
+
     /**
      * Getter.
+     * @return where the frontend's error messages go.
+     */
+    ostream &output() const { return *out; }
+
+    /**
+     * Getter. Computed from the offset, so only use it for diagnostics.
      * @return the current source line number.
      */
-    int lineNumber() const { return lineNum; }
+    int lineNumber() const { return lineMap->lineNumber(position); }
+
+    /**
+     * Getter. Computed from the offset, so only use it for diagnostics.
+     * @param offset a source offset.
+     * @return the offset's source line number.
+     */
+    int lineNumber(int offset) const { return lineMap->lineNumber(offset); }
+
+    /**
+     * Getter.
+     * @return the map from source offsets to line numbers.
+     */
+    LineMap *lines() const { return lineMap; }
 
     /**
      * Getter.
@@ -56,22 +110,61 @@ public:
      */
     char currentChar() const { return currentCh; }
 
+    /**
+     * Getter.
+     * @return the offset of the current character in the source text.
+     */
+    int offset() const { return position; }
+
+    /**
+     * Getter.
+     * @return the source text.
+     */
+    const char *chars() const { return buffer.data(); }
+
+    /**
+     * Getter.
+     * @return the length of the source text.
+     */
+    int length() const { return buffer.length(); }
+
+    /**
+     * Getter.
+     * @param start the offset of the first character.
+     * @param length the number of characters.
+     * @return a piece of the source text.
+     */
+    string text(int start, int length) const
+    {
+        return buffer.substr(start, length);
+    }
+
     /**
      * Read and return the next input source character.
      * @return the character, or EOF if at the end of the file.
      */
     char nextChar()
     {
-        currentCh = source.get();
+        if (position < (int) buffer.length()) position++;
 
-        if (source.eof()) currentCh = EOF;
-        else if (currentCh == EOL) lineNum++;
+        currentCh = position < (int) buffer.length() ? buffer[position] : EOF;
 
-        else if (source.fail())
-        {
-            cout << "*** ERROR: Failed to read " << sourceFileName << endl;
-            exit(-1);
-        }
+        return currentCh;
+    }
+
+    /**
+     * Skip ahead to a later character.
+     * @param newPosition the offset of the new current character.
+     * @return the character, or EOF if at the end of the file.
+     */
+    char skipTo(int newPosition)
+    {
+        int end = buffer.length();
+        if (newPosition > end) newPosition = end;
+        if (newPosition <= position) return currentCh;
+
+        position  = newPosition;
+        currentCh = position < end ? buffer[position] : EOF;
 
         return currentCh;
     }
@@ -8,65 +8,69 @@
 #include <string>
 #include <map>
 #include <ctype.h>
+#include <charconv>
+#include <system_error>
 
 #include "../Object.h"
+#include "CharClass.h"
 #include "Token.h"
 
 namespace frontend {
 
 using namespace std;
 
-map<string, TokenType> Token::reservedWords;
-
-void Token::initialize()
+// Built before main() and never modified,
+// so any number of scanners can share it.
+const map<string, TokenType> Token::reservedWords =
 {
-    reservedWords["PROGRAM"] = PROGRAM;
-    reservedWords["BEGIN"]   = BEGIN;
-    reservedWords["END"]     = END;
-    reservedWords["REPEAT"]  = REPEAT;
-    reservedWords["UNTIL"]   = UNTIL;
-    reservedWords["WRITE"]   = WRITE;
-    reservedWords["WRITELN"] = WRITELN;
-    reservedWords["DIV"] 	 = DIV;
-    reservedWords["MOD"]  	 = MOD;
-    reservedWords["AND"]     = AND;
-    reservedWords["OR"] 	 = OR;
-    reservedWords["NOT"]  	 = NOT;
-    reservedWords["CONST"]   = CONST;
-    reservedWords["TYPE"]	 = TYPE;
-    reservedWords["VAR"]	 = VAR;
-    reservedWords["PROCEDURE"]   = PROCEDURE;
-    reservedWords["FUNCTION"]    = FUNCTION;
-    reservedWords["WHILE"] 	 = WHILE;
-    reservedWords["DO"]  	 = DO;
-    reservedWords["FOR"]  	 = FOR;
-    reservedWords["TO"]		 = TO;
-    reservedWords["DOWNTO"]  = DOWNTO;
-    reservedWords["IF"]  	 = IF;
-    reservedWords["THEN"]    = THEN;
-    reservedWords["ELSE"] 	 = ELSE;
-    reservedWords["CASE"]    = CASE;
-    reservedWords["OF"]  	 = OF;
-
-}
-
-Token *Token::Word(char firstChar, Source *source)
+    { "PROGRAM", PROGRAM },
+    { "BEGIN",   BEGIN },
+    { "END",     END },
+    { "REPEAT",  REPEAT },
+    { "UNTIL",   UNTIL },
+    { "WRITE",   WRITE },
+    { "WRITELN", WRITELN },
+    { "DIV",     DIV },
+    { "MOD",     MOD },
+    { "AND",     AND },
+    { "OR",      OR },
+    { "NOT",     NOT },
+    { "CONST",   CONST },
+    { "TYPE",    TYPE },
+    { "VAR",     VAR },
+    { "PROCEDURE", PROCEDURE },
+    { "FUNCTION",  FUNCTION },
+    { "WHILE",   WHILE },
+    { "DO",      DO },
+    { "FOR",     FOR },
+    { "TO",      TO },
+    { "DOWNTO",  DOWNTO },
+    { "IF",      IF },
+    { "THEN",    THEN },
+    { "ELSE",    ELSE },
+    { "CASE",    CASE },
+    { "OF",      OF }
+};
+
+Token *Token::Word(char firstChar, Source *source, Token *token)
 {
-    Token *token = new Token(firstChar);
-    token->lineNumber = source->lineNumber();
+    token->offset = source->offset();
 
-    // Loop to get the rest of the characters of the word token.
-    // Append letters and digits to the token.
-    for (char ch = source->nextChar(); isalnum(ch); ch = source->nextChar())
-    {
-        token->text += ch;
-    }
+    // Find the end of the letters and digits of the word token
+    // in one scan, and take them all at once.
+    const char *text = source->chars();
+    int start = source->offset();
+    int end = CharClass::skipAlnum(text, start + 1, source->length());
+
+    token->text.assign(text + start, end - start);
+    source->skipTo(end);
 
     // Is it a reserved word or an identifier?
     string upper = toUpperCase(token->text);
-    if (Token::reservedWords.find(upper) != Token::reservedWords.end())
+    auto reserved = Token::reservedWords.find(upper);
+    if (reserved != Token::reservedWords.end())
     {
-        token->type = Token::reservedWords[upper];
+        token->type = reserved->second;
     }
     else
     {
@@ -76,45 +80,93 @@ Token *Token::Word(char firstChar, Source *source)
     return token;
 }
 
-Token *Token::Number(char firstChar, Source *source)
+Token *Token::Number(char firstChar, Source *source, Token *token)
 {
-    Token *token = new Token(firstChar);
-    int pointCount = 0;
-
-    // Loop to get the rest of the characters of the number token.
-    // Append digits to the token.
-    for (char ch = source->nextChar();
-         isdigit(ch) || (ch == '.');
-         ch = source->nextChar())
+    token->offset = source->offset();
+
+    // Find the extent of the number directly in the source buffer:
+    // digits, then an optional fraction, then an optional exponent.
+    const char *text = source->chars();
+    int length = source->length();
+    int start  = source->offset();
+    int end    = start;
+    bool real  = false;
+
+    while ((end < length) && isdigit(text[end])) end++;
+
+    // A fraction, but not the .. of a range.
+    if ((end + 1 < length) && (text[end] == '.') && isdigit(text[end + 1]))
     {
-        if (ch == '.') pointCount++;
-        token->text += ch;
+        real = true;
+        for (end++; (end < length) && isdigit(text[end]); end++);
+
+        // A second decimal point makes an invalid token.
+        if ((end + 1 < length) && (text[end] == '.') && isdigit(text[end + 1]))
+        {
+            while ((end < length) && (isdigit(text[end]) || (text[end] == '.')))
+            {
+                end++;
+            }
+
+            token->text.assign(text + start, end - start);
+            source->skipTo(end);
+            tokenError(token, "Invalid token", source);
+
+            return token;
+        }
     }
 
-    // Integer constant.
-    if (pointCount == 0)
+    // An exponent, only if there are digits after the e and any sign.
+    if ((end < length) && ((text[end] == 'e') || (text[end] == 'E')))
     {
-        token->type    = TokenType::INTEGER;
-        token->value.L = stol(token->text);
-        token->value.D = token->value.L;  // allow using integer value as double
+        int digits = end + 1;
+        if ((digits < length) && ((text[digits] == '+') || (text[digits] == '-')))
+        {
+            digits++;
+        }
+
+        if ((digits < length) && isdigit(text[digits]))
+        {
+            real = true;
+            for (end = digits; (end < length) && isdigit(text[end]); end++);
+        }
     }
 
-    // Real constant.
-    else if (pointCount == 1)
+    token->text.assign(text + start, end - start);
+    source->skipTo(end);
+
+    // Convert in place without allocating or consulting the locale.
+    errc ec;
+    if (!real)
+    {
+        long value = 0;
+        ec = from_chars(text + start, text + end, value).ec;
+
+        token->type    = TokenType::INTEGER;
+        token->value.L = value;
+        token->value.D = value;  // allow using integer value as double
+    }
+    else
     {
+        double value = 0.0;
+        ec = from_chars(text + start, text + end, value).ec;
+
         token->type    = TokenType::REAL;
-        token->value.D = stod(token->text);
+        token->value.D = value;
     }
 
-    else tokenError(token, "Invalid token", source);
+    if (ec == errc::result_out_of_range)
+    {
+        token->type = TokenType::ERROR;
+        tokenError(token, real ? "Real constant out of range"
+                               : "Integer constant out of range", source);
+    }
 
     return token;
 }
 
-Token *Token::String(char firstChar, Source *source)
+Token *Token::String(char firstChar, Source *source, Token *token)
 {
-    Token *token = new Token(firstChar);  // the leading '
-
     char ch = source->nextChar(); //pick up the character following the leading '
     if(ch == '\'') {//if ''
     	token->text += ch; //add the ' -- may be for closing or for apostrophe
@@ -166,10 +218,8 @@ Token *Token::String(char firstChar, Source *source)
     return token;
 }
 
-Token *Token::SpecialSymbol(char firstChar, Source *source)
+Token *Token::SpecialSymbol(char firstChar, Source *source, Token *token)
 {
-    Token *token = new Token(firstChar);
-
     switch (firstChar)
     {
         case '.' :
@@ -288,9 +338,9 @@ Token *Token::SpecialSymbol(char firstChar, Source *source)
 
 void Token::tokenError(Token *token, string message, Source *source)
 {
-	token->lineNumber = source->lineNumber();
-    printf("TOKEN ERROR at line %d: %s at '%s'\n",
-           token->lineNumber, message.c_str(), token->text.c_str());
+    source->output() << "TOKEN ERROR at line " << source->lineNumber()
+                     << ": " << message << " at '" << token->text << "'"
+                     << endl;
 }
 
 }  // namespace frontend
@@ -12,11 +12,14 @@
 #include <map>
 
 #include "../Object.h"
+#include "../intermediate/Allocator.h"
 #include "Source.h"
 
 namespace frontend {
 
 using namespace std;
+using intermediate::Allocator;
+using intermediate::Subsystem;
 
 enum class TokenType
 {	//reserved words
@@ -45,6 +48,9 @@ static const string TOKEN_TYPE_STRINGS[] =
     //other token types
 	"IDENTIFIER", "INTEGER", "REAL", "STRING", "CHARACTER", "EOF", "ERROR"
 };
+
+constexpr int TOKEN_TYPE_COUNT =
+                    sizeof(TOKEN_TYPE_STRINGS)/sizeof(TOKEN_TYPE_STRINGS[0]);
 //reserved words
 constexpr TokenType PROGRAM      = TokenType::PROGRAM;
 constexpr TokenType BEGIN        = TokenType::BEGIN;
@@ -114,18 +120,13 @@ class Token
 {
 private:
     /**
-     * The table (as a map) of reserved words. Initialize the table.
+     * The table (as a map) of reserved words.
      */
-    static map<string, TokenType> reservedWords;
+    static const map<string, TokenType> reservedWords;
 
 public:
-    /**
-     * Initialize the static map.
-     */
-    static void initialize();
-
     TokenType type;  // what type of token
-    int lineNumber;  // source line number of the token
+    int offset;      // source offset of the token
     string text;     // text of the token
     Object value;    // the value (if any) of the token
 
@@ -133,42 +134,73 @@ public:
      * Constructor.
      * @param firstChar the first character of the token.
      */
-    Token(char firstChar) : type(ERROR), lineNumber(0), text("")
+    Token(char firstChar) : type(ERROR), offset(-1), text("")
     {
         text += firstChar;
     }
 
     /**
-     * Construct a word token.
+     * Start the token over, so that one token object can be scanned
+     * into again and again.
+     * @param firstChar the first character of the next token.
+     */
+    void reset(char firstChar)
+    {
+        type   = ERROR;
+        offset = -1;
+        text.assign(1, firstChar);
+
+        value.L = 0;
+        value.D = 0.0;
+        value.S.clear();
+        value.B = false;
+    }
+
+    // Allocate tokens from the scanner's allocator.
+    static void *operator new(size_t size)
+    {
+        return Allocator::allocate<Token>(Subsystem::SCANNER, size);
+    }
+    static void operator delete(void *token, size_t size)
+    {
+        Allocator::release(Subsystem::SCANNER, token, size);
+    }
+
+    /**
+     * Scan a word token.
      * @param firstChar the first character of the token.
      * @param source the input source.
+     * @param token the token to scan into, started with firstChar.
      * @return the word token.
      */
-    static Token *Word(char firstChar, Source *source);
+    static Token *Word(char firstChar, Source *source, Token *token);
 
     /**
-     * Construct a number token and set its value.
+     * Scan a number token and set its value.
      * @param firstChar the first character of the token.
      * @param source the input source.
+     * @param token the token to scan into, started with firstChar.
      * @return the number token.
      */
-    static Token *Number(char firstChar, Source *source);
+    static Token *Number(char firstChar, Source *source, Token *token);
 
     /**
-     * Construct a string token and set its value.
+     * Scan a string token and set its value.
      * @param firstChar the first character of the token.
      * @param source the input source.
+     * @param token the token to scan into, started with firstChar.
      * @return the string token.
      */
-    static Token *String(char firstChar, Source *source);
+    static Token *String(char firstChar, Source *source, Token *token);
 
     /**
-     * Construct a special symbol token and set its value.
+     * Scan a special symbol token and set its value.
      * @param firstChar the first character of the token.
      * @param source the input source.
+     * @param token the token to scan into, started with firstChar.
      * @return the special symbol token.
      */
-    static Token *SpecialSymbol(char firstChar, Source *source);
+    static Token *SpecialSymbol(char firstChar, Source *source, Token *token);
 
     static void tokenError(Token *token, string message, Source *source);
 };
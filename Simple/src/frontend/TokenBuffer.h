@@ -0,0 +1,148 @@
+/**
+ * Token buffer class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef TOKENBUFFER_H_
+#define TOKENBUFFER_H_
+
+#include <string>
+#include <vector>
+
+#include "../Object.h"
+#include "Source.h"
+#include "Token.h"
+
+namespace frontend {
+
+using namespace std;
+
+/**
+ * The tokens of an entire source, scanned ahead of parsing and stored
+ * as parallel arrays so that the parser walks them by index.
+ * Only literal tokens have an entry in the value side table.
+ */
+class TokenBuffer
+{
+private:
+    Source *source;
+
+    vector<unsigned char> types;     // token types
+    vector<int>           starts;    // offsets of the tokens in the source
+    vector<int>           lengths;   // lengths of the tokens' text
+    vector<int>           literals;  // index into values, or -1
+    vector<Object>        values;    // literal value side table
+
+public:
+    /**
+     * Constructor.
+     * @param source the source that the tokens come from.
+     */
+    TokenBuffer(Source *source) : source(source) {}
+
+    // Allocate buffers from the scanner's allocator.
+    static void *operator new(size_t size)
+    {
+        return Allocator::allocate<TokenBuffer>(Subsystem::SCANNER, size);
+    }
+    static void operator delete(void *buffer, size_t size)
+    {
+        Allocator::release(Subsystem::SCANNER, buffer, size);
+    }
+
+    /**
+     * Append a scanned token.
+     * @param token the token.
+     * @param start the offset of the token in the source.
+     * @param length the length of the token's text.
+     */
+    void append(Token *token, int start, int length)
+    {
+        types.push_back((unsigned char) token->type);
+        starts.push_back(start);
+        lengths.push_back(length);
+
+        bool literal =    (token->type == INTEGER) || (token->type == REAL)
+                       || (token->type == STRING)  || (token->type == CHARACTER);
+        if (literal)
+        {
+            literals.push_back(values.size());
+            values.push_back(token->value);
+        }
+        else literals.push_back(-1);
+    }
+
+    /**
+     * Getter.
+     * @return the number of tokens, including the final END_OF_FILE.
+     */
+    int size() const { return types.size(); }
+
+    /**
+     * Getter. Any index past the end is the END_OF_FILE token.
+     * @param i the token index.
+     * @return the token's type.
+     */
+    TokenType type(int i) const { return (TokenType) types[clamp(i)]; }
+
+    /**
+     * Getter.
+     * @return the source that the tokens come from.
+     */
+    Source *getSource() const { return source; }
+
+    /**
+     * Getter.
+     * @param i the token index.
+     * @return the token's source offset.
+     */
+    int offset(int i) const { return starts[clamp(i)]; }
+
+    /**
+     * Getter.
+     * @param i the token index.
+     * @return the token's text.
+     */
+    string text(int i) const
+    {
+        i = clamp(i);
+        return source->text(starts[i], lengths[i]);
+    }
+
+    /**
+     * Fill a token object with what a parser reads of a token: its type
+     * and offset, a literal's value and an identifier's name. The text
+     * of any other token is only for error messages, and text() reads
+     * it from the source then. The token keeps its strings' storage,
+     * so reloading it doesn't allocate.
+     * @param i the token index.
+     * @param token the token object to overwrite.
+     */
+    void load(int i, Token *token) const
+    {
+        i = clamp(i);
+        token->type   = (TokenType) types[i];
+        token->offset = starts[i];
+
+        if (token->type == IDENTIFIER)
+        {
+            token->text.assign(source->chars() + starts[i], lengths[i]);
+        }
+        else if (literals[i] >= 0)
+        {
+            const Object &value = values[literals[i]];
+            token->value.L = value.L;
+            token->value.D = value.D;
+            token->value.S.assign(value.S);
+        }
+    }
+
+private:
+    int clamp(int i) const { return i < size() ? i : size() - 1; }
+};
+
+}  // namespace frontend
+
+#endif /* TOKENBUFFER_H_ */
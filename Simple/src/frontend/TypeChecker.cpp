@@ -0,0 +1,194 @@
+/**
+ * Type checker class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "Source.h"
+#include "../intermediate/Symtab.h"
+#include "../intermediate/Node.h"
+#include "TypeChecker.h"
+
+namespace frontend {
+
+using namespace std;
+using namespace intermediate;
+
+int TypeChecker::check(Node *programNode)
+{
+    order(programNode);
+
+    // Start every assigned variable as an INTEGER and widen to REAL
+    // each one that is assigned anything else, until none changes.
+    // A type only widens, so this stops.
+    collectVariables();
+    while (inferVariables());
+
+    for (auto &variable : variableTypes)
+    {
+        variable.first->setType(variable.second);
+    }
+
+    annotate();
+    return errorCount;
+}
+
+void TypeChecker::order(Node *programNode)
+{
+    // Each frame is a node and the index of its next child to visit.
+    vector<pair<Node *, size_t>> stack;
+    stack.push_back({programNode, 0});
+
+    while (!stack.empty())
+    {
+        Node *node = stack.back().first;
+        size_t next = stack.back().second;
+
+        // Entering the node.
+        if ((next == 0) && (node->offset >= 0) && (node->type != PROGRAM))
+        {
+            offset = node->offset;
+        }
+
+        if ((next == 0) && ((int) stack.size() > depth))
+        {
+            depth = stack.size();
+            deepOffset = offset;
+        }
+
+        // A WHILE without a body has a null child.
+        while ((next < node->children.size()) && (node->children[next] == nullptr))
+        {
+            next++;
+        }
+
+        if (next < node->children.size())
+        {
+            stack.back().second = next + 1;
+            stack.push_back({node->children[next], 0});
+        }
+        else
+        {
+            stack.pop_back();
+            nodes.push_back(node);
+            offsets.push_back(offset);
+        }
+    }
+}
+
+void TypeChecker::collectVariables()
+{
+    for (Node *node : nodes)
+    {
+        if (node->type == ASSIGN)
+        {
+            // The executor looks variables up by their text, so do the same.
+            SymtabEntry *variableId = symtab->lookup(node->children[0]->text);
+            if (variableId != nullptr) variableTypes[variableId] = ValueType::INTEGER;
+        }
+    }
+}
+
+bool TypeChecker::inferVariables()
+{
+    bool changed = false;
+
+    // Children come before their parents, so each expression's
+    // operands are typed before it is.
+    for (Node *node : nodes)
+    {
+        node->valueType = typeOf(node);
+
+        if (node->type == ASSIGN)
+        {
+            auto found = variableTypes.find(symtab->lookup(node->children[0]->text));
+
+            if (   (found != variableTypes.end())
+                && (found->second == ValueType::INTEGER)
+                && (node->children[1]->valueType != ValueType::INTEGER))
+            {
+                found->second = ValueType::REAL;
+                changed = true;
+            }
+        }
+    }
+
+    return changed;
+}
+
+ValueType TypeChecker::typeOf(Node *node)
+{
+    switch (node->type)
+    {
+        case INTEGER_CONSTANT : return ValueType::INTEGER;
+        case REAL_CONSTANT :    return ValueType::REAL;
+        case STRING_CONSTANT :  return ValueType::STRING;
+
+        case VARIABLE :
+        {
+            // A variable that's never assigned, such as one set
+            // from outside the program, keeps its entry's type.
+            SymtabEntry *variableId = symtab->lookup(node->text);
+            auto found = variableTypes.find(variableId);
+
+            if (found != variableTypes.end()) return found->second;
+            return variableId != nullptr ? variableId->getType()
+                                         : ValueType::UNKNOWN;
+        }
+
+        // The operands already have their types.
+        case ADD :
+        case SUBTRACT :
+        case MULTIPLY :
+            return    (node->children[0]->valueType == ValueType::INTEGER)
+                   && (node->children[1]->valueType == ValueType::INTEGER)
+                        ? ValueType::INTEGER : ValueType::REAL;
+
+        case DIVIDE :         return ValueType::REAL;
+        case INTEGER_DIVIDE :
+        case MODULO :         return ValueType::INTEGER;
+
+        case EQ :
+        case LT :
+        case GT :
+        case NodeType::NOT :  return ValueType::BOOLEAN;
+
+        // Only expressions have a type.
+        default : return ValueType::UNKNOWN;
+    }
+}
+
+void TypeChecker::annotate()
+{
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        Node *node = nodes[i];
+        node->valueType = typeOf(node);
+
+        if ((node->type == INTEGER_DIVIDE) || (node->type == MODULO))
+        {
+            if (   (node->children[0]->valueType != ValueType::INTEGER)
+                || (node->children[1]->valueType != ValueType::INTEGER))
+            {
+                offset = offsets[i];
+                typeError(string("Integer operands required for ")
+                          + (node->type == MODULO ? "MOD" : "DIV"));
+            }
+        }
+    }
+}
+
+void TypeChecker::typeError(string message)
+{
+    source->output() << "TYPE ERROR at line " << source->lineNumber(offset)
+                     << ": " << message << endl;
+    errorCount++;
+}
+
+}  // namespace frontend
@@ -0,0 +1,76 @@
+/**
+ * Type checker class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef TYPECHECKER_H_
+#define TYPECHECKER_H_
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "Source.h"
+#include "../intermediate/Symtab.h"
+#include "../intermediate/Node.h"
+
+namespace frontend {
+
+using namespace std;
+using namespace intermediate;
+
+/**
+ * Infers the static type of every variable and expression of a parse
+ * tree. Constants have their own types, and / always makes a REAL.
+ * +, - and * make an INTEGER from INTEGER operands, and DIV and MOD
+ * require them. A variable is an INTEGER only if every value assigned
+ * to it anywhere in the program is, else a REAL.
+ *
+ * Every pass visits the nodes in one postorder list, so each node's
+ * type comes from its children's stored types, and a deep expression
+ * needs no deep call stack.
+ */
+class TypeChecker
+{
+private:
+    Source *source;
+    Symtab *symtab;
+    map<SymtabEntry *, ValueType> variableTypes;  // while inferring
+    vector<Node *> nodes;  // the parse tree in postorder
+    vector<int> offsets;   // source offset of each node's statement
+    int offset;      // source offset of the current statement
+    int depth;       // of the deepest node, counting the root as 1
+    int deepOffset;  // source offset of that node's statement
+    int errorCount;
+
+public:
+    TypeChecker(Source *source, Symtab *symtab)
+        : source(source), symtab(symtab), offset(-1), depth(0),
+          deepOffset(-1), errorCount(0) {}
+
+    int getDepth() const { return depth; }
+    int getDeepOffset() const { return deepOffset; }
+
+    /**
+     * Set the types of the variables' symbol table entries and of the
+     * expression nodes.
+     * @param programNode the root of the parse tree.
+     * @return the count of type errors.
+     */
+    int check(Node *programNode);
+
+private:
+    void order(Node *programNode);
+    void collectVariables();
+    bool inferVariables();
+    ValueType typeOf(Node *node);
+    void annotate();
+
+    void typeError(string message);
+};
+
+}  // namespace frontend
+
+#endif /* TYPECHECKER_H_ */
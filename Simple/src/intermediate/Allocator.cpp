@@ -0,0 +1,76 @@
+/**
+ * Allocator classes for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <atomic>
+
+#include "Allocator.h"
+
+namespace intermediate {
+
+using namespace std;
+
+static HeapAllocator heapAllocator;
+static ArenaAllocator arenaAllocator;
+
+// By subsystem. They count nothing unless countAll() wraps them.
+static Allocator *allocators[SUBSYSTEM_COUNT] =
+{
+    &heapAllocator, &arenaAllocator, &arenaAllocator, &heapAllocator
+};
+
+Allocator *Allocator::get(Subsystem subsystem)
+{
+    return allocators[(int) subsystem];
+}
+
+void Allocator::set(Subsystem subsystem, Allocator *allocator)
+{
+    allocators[(int) subsystem] = allocator;
+}
+
+void Allocator::countAll()
+{
+    for (int i = 0; i < SUBSYSTEM_COUNT; i++)
+    {
+        allocators[i] = new CountingAllocator(allocators[i]);
+    }
+}
+
+void *CountingAllocator::allocate(size_t size, void (*destroy)(void *))
+{
+    void *memory = allocator->allocate(size, destroy);
+
+    long live = liveBytes.fetch_add(size, memory_order_relaxed) + size;
+    allocationCount.fetch_add(1, memory_order_relaxed);
+
+    // Raise the peak unless another thread raised it higher.
+    long peak = peakBytes.load(memory_order_relaxed);
+    while (   (live > peak)
+           && !peakBytes.compare_exchange_weak(peak, live,
+                                               memory_order_relaxed))
+    {
+    }
+
+    return memory;
+}
+
+void CountingAllocator::release(void *memory, size_t size)
+{
+    liveBytes.fetch_sub(size, memory_order_relaxed);
+    allocator->release(memory, size);
+}
+
+bool CountingAllocator::getCounts(AllocationCounts &counts) const
+{
+    counts.liveBytes       = liveBytes.load(memory_order_relaxed);
+    counts.peakBytes       = peakBytes.load(memory_order_relaxed);
+    counts.allocationCount = allocationCount.load(memory_order_relaxed);
+
+    return true;
+}
+
+}  // namespace intermediate
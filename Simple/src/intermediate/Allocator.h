@@ -0,0 +1,188 @@
+/**
+ * Allocator classes for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef ALLOCATOR_H_
+#define ALLOCATOR_H_
+
+#include <cstddef>
+#include <string>
+#include <atomic>
+
+#include "Arena.h"
+
+namespace intermediate {
+
+using namespace std;
+
+/**
+ * The parts of the interpreter whose objects are accounted apart.
+ */
+enum class Subsystem
+{
+    SCANNER, PARSER, SYMTAB, EXECUTOR
+};
+
+static const string SUBSYSTEM_STRINGS[] =
+{
+    "scanner", "parser", "symtab", "executor"
+};
+
+constexpr int SUBSYSTEM_COUNT =
+    sizeof(SUBSYSTEM_STRINGS)/sizeof(SUBSYSTEM_STRINGS[0]);
+
+/**
+ * The allocation counts of a subsystem.
+ */
+struct AllocationCounts
+{
+    long liveBytes;        // allocated and not yet released
+    long peakBytes;        // the most ever live at once
+    long allocationCount;  // objects allocated
+};
+
+/**
+ * Where the objects of a subsystem get their memory. Classes opt in
+ * with operator new and delete that call the static allocate() and
+ * release() with their subsystem. Each subsystem has its own allocator,
+ * which can be replaced before the subsystem allocates anything.
+ *
+ * Parse tree nodes and symbol table entries come from the thread's
+ * current arena, if any. Tokens, which the scanner deletes as it goes,
+ * and the executors come from the heap. Only a run with statistics
+ * counts each subsystem's allocations, after countAll().
+ */
+class Allocator
+{
+public:
+    virtual ~Allocator() {}
+
+    /**
+     * Allocate memory for an object.
+     * @param size the object size.
+     * @param destroy the object's destructor, for an allocator that
+     *                releases all its memory at once, or null if the
+     *                object needs none.
+     * @return the memory.
+     */
+    virtual void *allocate(size_t size, void (*destroy)(void *)) = 0;
+
+    /**
+     * Release an object's memory.
+     * @param memory the memory.
+     * @param size the object size.
+     */
+    virtual void release(void *memory, size_t size) = 0;
+
+    /**
+     * Get the allocation counts.
+     * @param counts set to the counts.
+     * @return true if this allocator counts, else false.
+     */
+    virtual bool getCounts(AllocationCounts &) const { return false; }
+
+    /**
+     * Get a subsystem's allocator.
+     * @param subsystem the subsystem.
+     * @return its allocator.
+     */
+    static Allocator *get(Subsystem subsystem);
+
+    /**
+     * Replace a subsystem's allocator.
+     * @param subsystem the subsystem.
+     * @param allocator the new allocator.
+     */
+    static void set(Subsystem subsystem, Allocator *allocator);
+
+    /**
+     * Count the allocations of every subsystem from now on,
+     * before the subsystems allocate anything.
+     */
+    static void countAll();
+
+    /**
+     * Allocate memory for an object of class T from its subsystem's
+     * allocator.
+     * @param subsystem the subsystem.
+     * @param size the object size.
+     * @return the memory.
+     */
+    template<class T>
+    static void *allocate(Subsystem subsystem, size_t size)
+    {
+        return get(subsystem)->allocate(size, Arena::finalizer<T>());
+    }
+
+    /**
+     * Release memory allocated by allocate().
+     * @param subsystem the subsystem.
+     * @param memory the memory.
+     * @param size the object size.
+     */
+    static void release(Subsystem subsystem, void *memory, size_t size)
+    {
+        if (memory != nullptr) get(subsystem)->release(memory, size);
+    }
+};
+
+/**
+ * Memory from the heap.
+ */
+class HeapAllocator : public Allocator
+{
+public:
+    void *allocate(size_t size, void (*)(void *)) override
+    {
+        return ::operator new(size);
+    }
+
+    void release(void *memory, size_t) override { ::operator delete(memory); }
+};
+
+/**
+ * Memory from the thread's current arena, or from the heap if there
+ * is none. Arena memory is only reclaimed when the arena is destroyed.
+ */
+class ArenaAllocator : public Allocator
+{
+public:
+    void *allocate(size_t size, void (*destroy)(void *)) override
+    {
+        return Arena::allocate(size, destroy);
+    }
+
+    void release(void *memory, size_t) override { Arena::release(memory); }
+};
+
+/**
+ * Count the allocations of another allocator. Threads can share one.
+ */
+class CountingAllocator : public Allocator
+{
+private:
+    Allocator *allocator;  // where the memory comes from
+    atomic<long> liveBytes;
+    atomic<long> peakBytes;
+    atomic<long> allocationCount;
+
+public:
+    /**
+     * Constructor.
+     * @param allocator the allocator to count.
+     */
+    CountingAllocator(Allocator *allocator)
+        : allocator(allocator), liveBytes(0), peakBytes(0),
+          allocationCount(0) {}
+
+    void *allocate(size_t size, void (*destroy)(void *)) override;
+    void release(void *memory, size_t size) override;
+    bool getCounts(AllocationCounts &counts) const override;
+};
+
+}  // namespace intermediate
+
+#endif /* ALLOCATOR_H_ */
@@ -0,0 +1,267 @@
+/**
+ * Arena class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <cstddef>
+#include <new>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+namespace intermediate {
+
+using namespace std;
+
+/**
+ * Whether an object of class T must be destroyed before its arena's
+ * memory is freed. A class that keeps all its memory in the arena,
+ * such as in ArenaString and ArenaMemory containers, specializes this
+ * to false so that its objects cost nothing to release.
+ */
+template<class T>
+struct NeedsFinalizer
+{
+    static const bool value = !is_trivially_destructible<T>::value;
+};
+
+/**
+ * Bump allocation for the objects of one program's compilation session,
+ * such as its parse tree nodes and symbol table entries, all released
+ * together when the arena is destroyed. Classes opt in with operator new
+ * and delete that call allocate() and release(). Each thread has its own
+ * current arena, so programs that run concurrently never share one.
+ *
+ * Only the objects that need a finalizer get one. When the rest are
+ * all that's left, destroying the arena just frees its few chunks.
+ */
+class Arena
+{
+private:
+    struct Chunk
+    {
+        char *memory;
+        size_t size;
+    };
+
+    struct Finalizer
+    {
+        void (*destroy)(void *);
+        void *object;
+    };
+
+    vector<Chunk> chunks;
+    char *next;              // next free byte in the last chunk
+    char *end;               // end of the last chunk
+    size_t bytes;            // allocated by this arena
+    vector<Finalizer> finalizers;
+    Arena *previous;         // the thread's current arena before this one
+
+    static const size_t FIRST_CHUNK_SIZE = 64*1024;
+    static const size_t MAX_CHUNK_SIZE   = 4*1024*1024;
+
+    static Arena *&currentArena()
+    {
+        thread_local Arena *arena = nullptr;
+        return arena;
+    }
+
+    template<class T>
+    static void destroy(void *object) { static_cast<T *>(object)->~T(); }
+
+public:
+    /**
+     * Constructor. The new arena becomes the thread's current arena.
+     */
+    Arena() : next(nullptr), end(nullptr), bytes(0), previous(currentArena())
+    {
+        currentArena() = this;
+    }
+
+    /**
+     * Destructor. Finalize the objects in reverse order of allocation,
+     * free the memory, and restore the thread's previous arena.
+     */
+    ~Arena()
+    {
+        for (auto it = finalizers.rbegin(); it != finalizers.rend(); it++)
+        {
+            it->destroy(it->object);
+        }
+        for (Chunk &chunk : chunks) ::operator delete(chunk.memory);
+
+        currentArena() = previous;
+    }
+
+    Arena(const Arena &) = delete;
+    Arena &operator =(const Arena &) = delete;
+
+    /**
+     * Getter.
+     * @return the thread's current arena, or null if none.
+     */
+    static Arena *current() { return currentArena(); }
+
+    /**
+     * Getter.
+     * @return the number of bytes allocated from this arena.
+     */
+    size_t bytesAllocated() const { return bytes; }
+
+    /**
+     * Getter.
+     * @return the destructor of class T if its objects need a finalizer,
+     *         else null.
+     */
+    template<class T>
+    static void (*finalizer())(void *)
+    {
+        return NeedsFinalizer<T>::value ? destroy<T> : nullptr;
+    }
+
+    /**
+     * Allocate memory for an object of class T from the thread's current
+     * arena, or from the heap if there is none. The object's destructor
+     * runs when the arena is destroyed if the object needs a finalizer.
+     * @param size the object size.
+     * @return the memory.
+     */
+    template<class T>
+    static void *allocate(size_t size)
+    {
+        return allocate(size, finalizer<T>());
+    }
+
+    /**
+     * Allocate memory for an object from the thread's current arena,
+     * or from the heap if there is none.
+     * @param size the object size.
+     * @param destroy the object's destructor, run when the arena is
+     *                destroyed, or null if it needs none.
+     * @return the memory.
+     */
+    static void *allocate(size_t size, void (*destroy)(void *))
+    {
+        Arena *arena = currentArena();
+        if (arena == nullptr) return ::operator new(size);
+
+        void *memory = arena->bump(size);
+        if (destroy != nullptr) arena->finalizers.push_back({ destroy, memory });
+
+        return memory;
+    }
+
+    /**
+     * Release memory allocated by allocate(). Arena memory is only
+     * reclaimed all at once, when the arena is destroyed.
+     * @param memory the memory.
+     */
+    static void release(void *memory)
+    {
+        Arena *arena = currentArena();
+        if ((arena == nullptr) || !arena->owns(memory)) ::operator delete(memory);
+    }
+
+private:
+    void *bump(size_t size)
+    {
+        size = (size + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+
+        if ((size_t) (end - next) < size)
+        {
+            // Each chunk is twice the size of the one before, up to a
+            // limit that bounds the unused tail of the last chunk.
+            size_t chunkSize = chunks.empty() ? FIRST_CHUNK_SIZE
+                                              : 2*chunks.back().size;
+            if (chunkSize > MAX_CHUNK_SIZE) chunkSize = MAX_CHUNK_SIZE;
+            if (chunkSize < size) chunkSize = size;
+
+            char *memory = (char *) ::operator new(chunkSize);
+            chunks.push_back({ memory, chunkSize });
+            next = memory;
+            end  = memory + chunkSize;
+        }
+
+        void *memory = next;
+        next  += size;
+        bytes += size;
+
+        return memory;
+    }
+
+    bool owns(const void *memory) const
+    {
+        // Memory that's released is most likely recent.
+        for (auto it = chunks.rbegin(); it != chunks.rend(); it++)
+        {
+            if (   ((const char *) memory >= it->memory)
+                && ((const char *) memory <  it->memory + it->size))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
+
+/**
+ * A standard library allocator whose memory comes from the thread's
+ * current arena, or from the heap if there is none. A container that
+ * uses it can be abandoned with its arena instead of destroyed.
+ * Memory that a container frees, such as when a vector grows, stays
+ * in the arena until the arena is destroyed.
+ */
+template<class T>
+class ArenaMemory
+{
+public:
+    typedef T value_type;
+
+    ArenaMemory() {}
+    template<class U> ArenaMemory(const ArenaMemory<U> &) {}
+
+    T *allocate(size_t count)
+    {
+        return static_cast<T *>(Arena::allocate(count*sizeof(T), nullptr));
+    }
+
+    void deallocate(T *memory, size_t) { Arena::release(memory); }
+
+    template<class U>
+    bool operator ==(const ArenaMemory<U> &) const { return true; }
+    template<class U>
+    bool operator !=(const ArenaMemory<U> &) const { return false; }
+};
+
+/**
+ * A string whose characters are in the arena. It converts to and from
+ * a string, so it can stand in for one as a member.
+ */
+class ArenaString
+    : public basic_string<char, char_traits<char>, ArenaMemory<char>>
+{
+public:
+    typedef basic_string<char, char_traits<char>, ArenaMemory<char>> Base;
+
+    ArenaString() {}
+    ArenaString(const char *text) : Base(text) {}
+    ArenaString(const string &text) : Base(text.data(), text.size()) {}
+
+    ArenaString &operator =(const string &text)
+    {
+        assign(text.data(), text.size());
+        return *this;
+    }
+
+    operator string() const { return string(data(), size()); }
+};
+
+}  // namespace intermediate
+
+#endif /* ARENA_H_ */
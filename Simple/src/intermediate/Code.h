@@ -0,0 +1,179 @@
+/**
+ * Bytecode class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef CODE_H_
+#define CODE_H_
+
+#include <string>
+#include <vector>
+#include <cstdio>
+
+namespace intermediate {
+
+using namespace std;
+
+/**
+ * Instructions of a stack machine. Relational operators push 1 for true
+ * and 0 for false. The _INT operators, and DIV and MOD, take INTEGER
+ * operands and report any overflow; the others take REAL ones.
+ */
+enum class Opcode : unsigned char
+{
+    PUSH, LOAD, STORE,
+    ADD, SUBTRACT, MULTIPLY, DIVIDE, INTEGER_DIVIDE, MODULO,
+    ADD_INT, SUBTRACT_INT, MULTIPLY_INT,
+    EQ, LT, GT, EQ_INT, LT_INT, GT_INT, NOT,
+    JUMP, JUMP_IF_TRUE, JUMP_IF_FALSE,
+    PRINT_NUMBER, PRINT_STRING, PRINT_STRING_WIDTH, PRINT_LINE,
+    HALT
+};
+
+static const string OPCODE_STRINGS[] =
+{
+    "PUSH", "LOAD", "STORE",
+    "ADD", "SUBTRACT", "MULTIPLY", "DIVIDE", "INTEGER_DIVIDE", "MODULO",
+    "ADD_INT", "SUBTRACT_INT", "MULTIPLY_INT",
+    "EQ", "LT", "GT", "EQ_INT", "LT_INT", "GT_INT", "NOT",
+    "JUMP", "JUMP_IF_TRUE", "JUMP_IF_FALSE",
+    "PRINT_NUMBER", "PRINT_STRING", "PRINT_STRING_WIDTH", "PRINT_LINE",
+    "HALT"
+};
+
+constexpr int OPCODE_COUNT = sizeof(OPCODE_STRINGS)/sizeof(OPCODE_STRINGS[0]);
+
+/**
+ * A value on the stack or in a variable. An INTEGER is in L and also
+ * in D, so that a REAL operator can read either kind in D.
+ */
+struct Number
+{
+    long L;
+    double D;
+};
+
+struct Instruction
+{
+    Opcode opcode;
+    int operand;  // constant, variable, string, count or jump target index
+    int offset;   // source offset, for runtime errors
+};
+
+class Code
+{
+public:
+    string programName;
+    vector<Instruction> instructions;
+    vector<Number> constants;  // PUSH operands
+    vector<string> strings;    // PRINT_STRING operands
+    vector<string> variables;  // variable names, indexed by LOAD/STORE slot
+
+    /**
+     * Append an instruction.
+     * @param opcode the opcode.
+     * @param operand the operand.
+     * @param offset the source offset.
+     * @return the index of the instruction, for backpatching.
+     */
+    int emit(Opcode opcode, int operand, int offset)
+    {
+        instructions.push_back({opcode, operand, offset});
+        return instructions.size() - 1;
+    }
+
+    /**
+     * Getter.
+     * @return the index of the next instruction to be emitted.
+     */
+    int here() const { return instructions.size(); }
+
+    /**
+     * Set the target of an already emitted jump.
+     * @param jump the index of the jump instruction.
+     * @param target the index of the target instruction.
+     */
+    void patch(int jump, int target) { instructions[jump].operand = target; }
+
+    /**
+     * Add a REAL constant.
+     * @param value the constant's value.
+     * @return the constant's index.
+     */
+    int addConstant(double value)
+    {
+        constants.push_back({0, value});
+        return constants.size() - 1;
+    }
+
+    /**
+     * Add an INTEGER constant.
+     * @param value the constant's value.
+     * @return the constant's index.
+     */
+    int addInteger(long value)
+    {
+        constants.push_back({value, (double) value});
+        return constants.size() - 1;
+    }
+
+    /**
+     * Add a string.
+     * @param value the string's value.
+     * @return the string's index.
+     */
+    int addString(string value)
+    {
+        strings.push_back(value);
+        return strings.size() - 1;
+    }
+
+    /**
+     * Print a listing of the instructions.
+     */
+    void print() const
+    {
+        printf("Code for %s:\n\n", programName.c_str());
+
+        for (size_t i = 0; i < instructions.size(); i++)
+        {
+            const Instruction &instruction = instructions[i];
+            printf("%6d  %-18s", (int) i,
+                   OPCODE_STRINGS[(int) instruction.opcode].c_str());
+
+            switch (instruction.opcode)
+            {
+                case Opcode::PUSH :
+                    printf(" %g", constants[instruction.operand].D);
+                    break;
+
+                case Opcode::LOAD :
+                case Opcode::STORE :
+                    printf(" %s", variables[instruction.operand].c_str());
+                    break;
+
+                case Opcode::PRINT_STRING :
+                case Opcode::PRINT_STRING_WIDTH :
+                    printf(" '%s'", strings[instruction.operand].c_str());
+                    break;
+
+                case Opcode::JUMP :
+                case Opcode::JUMP_IF_TRUE :
+                case Opcode::JUMP_IF_FALSE :
+                case Opcode::PRINT_NUMBER :
+                    printf(" %d", instruction.operand);
+                    break;
+
+                default : break;
+            }
+
+            printf("\n");
+        }
+    }
+};
+
+}  // namespace intermediate
+
+#endif /* CODE_H_ */
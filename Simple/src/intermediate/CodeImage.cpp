@@ -0,0 +1,350 @@
+/**
+ * Code image class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "Code.h"
+#include "LineMap.h"
+#include "CodeImage.h"
+
+namespace intermediate {
+
+using namespace std;
+
+static const char MAGIC[4] = { 'S', 'I', 'M', 'G' };
+
+/**
+ * Round a file offset up to the next multiple of 8.
+ * @param offset the offset.
+ * @return the aligned offset.
+ */
+static uint64_t align(uint64_t offset) { return (offset + 7) & ~(uint64_t) 7; }
+
+bool CodeImage::write(Code *code, LineMap *lines, string imageFileName)
+{
+    const vector<int> &lineStarts = lines->starts();
+
+    // Build the string pool: the program name, the strings,
+    // and then the variable names.
+    vector<uint32_t> stringOffsets;
+    string pool;
+
+    stringOffsets.push_back(pool.size());
+    pool.append(code->programName).push_back('\0');
+
+    for (string &s : code->strings)
+    {
+        stringOffsets.push_back(pool.size());
+        pool.append(s).push_back('\0');
+    }
+    for (string &name : code->variables)
+    {
+        stringOffsets.push_back(pool.size());
+        pool.append(name).push_back('\0');
+    }
+
+    // Lay out the sections.
+    Header header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version          = VERSION;
+    header.instructionSize  = sizeof(Instruction);
+    header.instructionCount = code->instructions.size();
+    header.constantCount    = code->constants.size();
+    header.lineCount        = lineStarts.size();
+    header.stringCount      = code->strings.size();
+    header.variableCount    = code->variables.size();
+
+    header.instructionsAt  = align(sizeof(Header));
+    header.constantsAt     = align(header.instructionsAt
+                               + header.instructionCount*sizeof(Instruction));
+    header.linesAt         = align(header.constantsAt
+                               + header.constantCount*sizeof(Number));
+    header.stringOffsetsAt = align(header.linesAt
+                               + header.lineCount*sizeof(int));
+    header.poolAt          = align(header.stringOffsetsAt
+                               + stringOffsets.size()*sizeof(uint32_t));
+    header.size            = header.poolAt + pool.size();
+
+    ofstream image(imageFileName, ios::binary | ios::trunc);
+    if (image.fail())
+    {
+        cout << "*** ERROR: Failed to create " << imageFileName << endl;
+        return false;
+    }
+
+    // Write a section at its file offset, padding up to it with zeros.
+    auto section = [&image](uint64_t at, const void *data, size_t length)
+    {
+        static const char zeros[8] = {};
+        image.write(zeros, at - (uint64_t) image.tellp());
+        image.write((const char *) data, length);
+    };
+
+    image.write((const char *) &header, sizeof(Header));
+    section(header.instructionsAt, code->instructions.data(),
+            header.instructionCount*sizeof(Instruction));
+    section(header.constantsAt, code->constants.data(),
+            header.constantCount*sizeof(Number));
+    section(header.linesAt, lineStarts.data(),
+            header.lineCount*sizeof(int));
+    section(header.stringOffsetsAt, stringOffsets.data(),
+            stringOffsets.size()*sizeof(uint32_t));
+    section(header.poolAt, pool.data(), pool.size());
+
+    image.close();
+    return !image.fail();
+}
+
+CodeImage *CodeImage::map(string imageFileName)
+{
+    int fd = open(imageFileName.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        cout << "*** ERROR: Failed to open " << imageFileName << endl;
+        return nullptr;
+    }
+
+    struct stat status;
+    void *base = MAP_FAILED;
+    size_t size = 0;
+
+    if ((fstat(fd, &status) == 0) && (status.st_size >= (off_t) sizeof(Header)))
+    {
+        size = status.st_size;
+        base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);  // the mapping stays valid
+
+    if (base == MAP_FAILED)
+    {
+        cout << "*** ERROR: Failed to map " << imageFileName << endl;
+        return nullptr;
+    }
+
+    if (!isValid(base, size))
+    {
+        cout << "*** ERROR: " << imageFileName
+             << " is not a compatible program image" << endl;
+        munmap(base, size);
+        return nullptr;
+    }
+
+    return new CodeImage(base, size, true);
+}
+
+CodeImage *CodeImage::wrap(const void *bytes, size_t size)
+{
+    bool aligned = ((uintptr_t) bytes & 7) == 0;
+    return aligned && isValid(bytes, size)
+                ? new CodeImage((void *) bytes, size, false) : nullptr;
+}
+
+bool CodeImage::isValid(const void *base, size_t size)
+{
+    // Check that the image was written by this version for this machine.
+    if (size < sizeof(Header)) return false;
+
+    const Header *header = (const Header *) base;
+    if (   (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0)
+        || (header->version != VERSION)
+        || (header->instructionSize != sizeof(Instruction))
+        || (header->size != size))
+    {
+        return false;
+    }
+
+    // Check that every section lies within the image.
+    uint64_t offsetCount = 1 + (uint64_t) header->stringCount
+                             + header->variableCount;
+    if (   (header->instructionsAt + (uint64_t) header->instructionCount
+                                     *sizeof(Instruction) > size)
+        || (header->constantsAt + (uint64_t) header->constantCount
+                                  *sizeof(Number) > size)
+        || (header->linesAt + (uint64_t) header->lineCount*sizeof(int) > size)
+        || (header->stringOffsetsAt + offsetCount*sizeof(uint32_t) > size)
+        || (header->poolAt > size)
+        || (header->lineCount == 0))
+    {
+        return false;
+    }
+
+    // Every string must start within the pool, which ends with a NUL.
+    const char *pool = (const char *) base + header->poolAt;
+    const uint32_t *stringOffsets =
+        (const uint32_t *) ((const char *) base + header->stringOffsetsAt);
+    uint64_t poolSize = size - header->poolAt;
+
+    if ((poolSize == 0) || (pool[poolSize - 1] != '\0')) return false;
+    for (uint64_t i = 0; i < offsetCount; i++)
+    {
+        if (stringOffsets[i] >= poolSize) return false;
+    }
+
+    return verify((const Instruction *) ((const char *) base
+                                         + header->instructionsAt),
+                  header);
+}
+
+bool CodeImage::verify(const Instruction *instructions, const Header *header)
+{
+    // Follow every path through the code, as the virtual machine would,
+    // and check that each operand is in range and that each instruction
+    // is always reached with the same stack depth. Then no image can
+    // index outside its tables, underflow or overflow the stack,
+    // or run off the end of the code.
+    int count = header->instructionCount;
+    if (count == 0) return false;
+
+    vector<int> depths(count, -1);  // stack depth before each instruction
+    vector<int> pending;            // reached but not yet followed
+
+    depths[0] = 0;
+    pending.push_back(0);
+
+    // Record the stack depth at which an instruction is reached.
+    auto reach = [&depths, &pending, count](int target, int depth)
+    {
+        if ((target < 0) || (target >= count) || (depth < 0)) return false;
+        if (depths[target] < 0)
+        {
+            depths[target] = depth;
+            pending.push_back(target);
+            return true;
+        }
+
+        return depths[target] == depth;
+    };
+
+    while (!pending.empty())
+    {
+        int i = pending.back();
+        pending.pop_back();
+
+        const Instruction &instruction = instructions[i];
+        int operand = instruction.operand;
+        int depth = depths[i];
+        int next = -1;          // the stack depth after a fall through
+
+        switch (instruction.opcode)
+        {
+            case Opcode::PUSH :
+                if ((operand < 0) || (operand >= (int) header->constantCount))
+                {
+                    return false;
+                }
+                next = depth + 1;
+                break;
+
+            case Opcode::LOAD :
+            case Opcode::STORE :
+                if ((operand < 0) || (operand >= (int) header->variableCount))
+                {
+                    return false;
+                }
+                next = instruction.opcode == Opcode::LOAD ? depth + 1
+                                                          : depth - 1;
+                break;
+
+            case Opcode::ADD :
+            case Opcode::SUBTRACT :
+            case Opcode::MULTIPLY :
+            case Opcode::DIVIDE :
+            case Opcode::INTEGER_DIVIDE :
+            case Opcode::MODULO :
+            case Opcode::ADD_INT :
+            case Opcode::SUBTRACT_INT :
+            case Opcode::MULTIPLY_INT :
+            case Opcode::EQ :
+            case Opcode::LT :
+            case Opcode::GT :
+            case Opcode::EQ_INT :
+            case Opcode::LT_INT :
+            case Opcode::GT_INT :
+                next = depth >= 2 ? depth - 1 : -1;
+                break;
+
+            case Opcode::NOT :
+                next = depth >= 1 ? depth : -1;
+                break;
+
+            case Opcode::JUMP :
+                if (!reach(operand, depth)) return false;
+                continue;
+
+            case Opcode::JUMP_IF_TRUE :
+            case Opcode::JUMP_IF_FALSE :
+                next = depth - 1;
+                if (!reach(operand, next)) return false;
+                break;
+
+            case Opcode::PRINT_NUMBER :
+                if ((operand < 0) || (operand > 2)) return false;
+                next = depth - 1 - operand;
+                break;
+
+            case Opcode::PRINT_STRING :
+            case Opcode::PRINT_STRING_WIDTH :
+                if ((operand < 0) || (operand >= (int) header->stringCount))
+                {
+                    return false;
+                }
+                next = instruction.opcode == Opcode::PRINT_STRING ? depth
+                                                                  : depth - 1;
+                break;
+
+            case Opcode::PRINT_LINE :
+                next = depth;
+                break;
+
+            case Opcode::HALT :
+                continue;
+
+            default : return false;  // not an opcode
+        }
+
+        if (!reach(i + 1, next)) return false;
+    }
+
+    return true;
+}
+
+CodeImage::CodeImage(void *base, size_t size, bool mapped)
+    : base(base), size(size), mapped(mapped), header((const Header *) base),
+      stringOffsets((const uint32_t *) ((const char *) base
+                                        + header->stringOffsetsAt)),
+      pool((const char *) base + header->poolAt),
+      lineMap(nullptr)
+{
+}
+
+CodeImage::~CodeImage()
+{
+    if (mapped) munmap(base, size);
+    delete lineMap;
+}
+
+LineMap *CodeImage::lines()
+{
+    if (lineMap == nullptr)
+    {
+        lineMap = new LineMap((const int *) ((const char *) base
+                                             + header->linesAt),
+                              header->lineCount);
+    }
+
+    return lineMap;
+}
+
+}  // namespace intermediate
@@ -0,0 +1,132 @@
+/**
+ * Code image class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef CODEIMAGE_H_
+#define CODEIMAGE_H_
+
+#include <string>
+#include <cstdint>
+
+#include "Code.h"
+#include "LineMap.h"
+
+namespace intermediate {
+
+using namespace std;
+
+/**
+ * A precompiled program: the code emitted by the CodeParser, written
+ * to a file that is later mapped into memory and executed in place.
+ * Every section is 8-byte aligned and in native byte order, so an image
+ * only runs on the kind of machine that wrote it. An image is verified
+ * before it is used, so a damaged one is rejected rather than run.
+ *
+ *     header
+ *     instructions     Instruction[instructionCount]
+ *     constants        Number[constantCount]
+ *     line starts      int32[lineCount], for runtime error messages
+ *     string offsets   uint32[1 + stringCount + variableCount]
+ *     string pool      NUL-terminated program name, strings
+ *                      and variable names
+ */
+class CodeImage
+{
+public:
+    static const uint32_t VERSION = 3;
+
+    struct Header
+    {
+        char magic[4];             // "SIMG"
+        uint32_t version;          // VERSION
+        uint32_t instructionSize;  // sizeof(Instruction)
+        uint32_t instructionCount;
+        uint32_t constantCount;
+        uint32_t lineCount;
+        uint32_t stringCount;
+        uint32_t variableCount;
+        uint64_t instructionsAt;   // section file offsets
+        uint64_t constantsAt;
+        uint64_t linesAt;
+        uint64_t stringOffsetsAt;
+        uint64_t poolAt;
+        uint64_t size;             // of the whole image
+    };
+
+private:
+    void *base;          // the image's first byte
+    size_t size;
+    bool mapped;         // true if base is a mapping of the image file
+    const Header *header;
+    const uint32_t *stringOffsets;
+    const char *pool;
+    LineMap *lineMap;    // built only for runtime error messages
+
+    CodeImage(void *base, size_t size, bool mapped);
+
+    static bool isValid(const void *base, size_t size);
+    static bool verify(const Instruction *instructions, const Header *header);
+
+public:
+    /**
+     * Write the code to an image file.
+     * @param code the code.
+     * @param lines the source's line map.
+     * @param imageFileName the image file name.
+     * @return true if successful.
+     */
+    static bool write(Code *code, LineMap *lines, string imageFileName);
+
+    /**
+     * Map an image file into memory.
+     * @param imageFileName the image file name.
+     * @return the image, or null if it couldn't be mapped or isn't valid.
+     */
+    static CodeImage *map(string imageFileName);
+
+    /**
+     * Use an image that is already in memory, such as one received by
+     * the server. The caller keeps the bytes alive while the image is used.
+     * @param bytes the image's first byte, aligned to 8 bytes.
+     * @param size the image size.
+     * @return the image, or null if it isn't valid.
+     */
+    static CodeImage *wrap(const void *bytes, size_t size);
+
+    ~CodeImage();
+
+    const Instruction *instructions() const
+    {
+        return (const Instruction *) ((const char *) base
+                                      + header->instructionsAt);
+    }
+
+    const Number *constants() const
+    {
+        return (const Number *) ((const char *) base + header->constantsAt);
+    }
+
+    int instructionCount() const { return header->instructionCount; }
+    int stringCount() const      { return header->stringCount; }
+    int variableCount() const    { return header->variableCount; }
+
+    const char *programName() const { return pool + stringOffsets[0]; }
+    const char *stringAt(int i) const
+    {
+        return pool + stringOffsets[1 + i];
+    }
+
+    /**
+     * Getter. The line map is built from the image's line starts
+     * on the first call, which only a runtime error makes.
+     * @return the map from source offsets to line numbers.
+     */
+    LineMap *lines();
+};
+
+}  // namespace intermediate
+
+#endif /* CODEIMAGE_H_ */
@@ -0,0 +1,101 @@
+/**
+ * Line map class for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef LINEMAP_H_
+#define LINEMAP_H_
+
+#include <vector>
+#include <algorithm>
+
+#include "../frontend/CharClass.h"
+
+namespace intermediate {
+
+using namespace std;
+using frontend::CharClass;
+
+/**
+ * Maps source offsets to line and column numbers. Tokens and nodes only
+ * keep offsets. The index of line starts is built on the first lookup,
+ * which only diagnostics and tree dumps do.
+ */
+class LineMap
+{
+private:
+    const char *text;
+    int length;
+    vector<int> lineStarts;  // offset of the first character of each line
+
+public:
+    /**
+     * Constructor.
+     * @param text the source text.
+     * @param length the length of the source text.
+     */
+    LineMap(const char *text, int length) : text(text), length(length) {}
+
+    /**
+     * Constructor for when only the line starts were kept,
+     * such as in a precompiled program image.
+     * @param starts the offset of the first character of each line.
+     * @param count the count of lines.
+     */
+    LineMap(const int *starts, int count)
+        : text(nullptr), length(0), lineStarts(starts, starts + count) {}
+
+    /**
+     * Getter.
+     * @return the offset of the first character of each line.
+     */
+    const vector<int> &starts()
+    {
+        if (lineStarts.empty()) build();
+        return lineStarts;
+    }
+
+    /**
+     * Get the line number of a source offset.
+     * @param offset the offset.
+     * @return the line number, starting with 1, or 0 if no offset.
+     */
+    int lineNumber(int offset)
+    {
+        if (offset < 0) return 0;
+        if (lineStarts.empty()) build();
+
+        return upper_bound(lineStarts.begin(), lineStarts.end(), offset)
+               - lineStarts.begin();
+    }
+
+    /**
+     * Get the column number of a source offset.
+     * @param offset the offset.
+     * @return the column number, starting with 1, or 0 if no offset.
+     */
+    int columnNumber(int offset)
+    {
+        int line = lineNumber(offset);
+        return line > 0 ? offset - lineStarts[line - 1] + 1 : 0;
+    }
+
+private:
+    void build()
+    {
+        lineStarts.push_back(0);
+
+        for (int p = CharClass::find(text, 0, length, '\n');
+             p < length;
+             p = CharClass::find(text, p + 1, length, '\n'))
+        {
+            lineStarts.push_back(p + 1);
+        }
+    }
+};
+
+}  // namespace intermediate
+
+#endif /* LINEMAP_H_ */
@@ -13,6 +13,8 @@
 
 #include "../Object.h"
 #include "SymtabEntry.h"
+#include "Allocator.h"
+#include "ValueType.h"
 
 namespace intermediate {
 
@@ -21,19 +23,37 @@ using namespace std;
 enum class NodeType
 {
     PROGRAM, COMPOUND, ASSIGN, LOOP, TEST, WRITE, WRITELN,
-    ADD, SUBTRACT, MULTIPLY, DIVIDE, EQ, LT,
+    ADD, SUBTRACT, MULTIPLY, DIVIDE, INTEGER_DIVIDE, MODULO, EQ, LT, GT,
     VARIABLE, INTEGER_CONSTANT, REAL_CONSTANT, STRING_CONSTANT,
-	NOT
+	NOT,
+
+    // Expressions specialized by their static types.
+    ADD_INT, SUBTRACT_INT, MULTIPLY_INT,
+    ADD_REAL, SUBTRACT_REAL, MULTIPLY_REAL, DIVIDE_REAL,
+    EQ_INT, LT_INT, GT_INT, EQ_REAL, LT_REAL, GT_REAL,
+    VARIABLE_INT, VARIABLE_REAL,
+
+    // Superinstructions fused from the common statement shapes.
+    ASSIGN_VAR_OP_CONST, TEST_VAR_CONST, WRITE_VAR, COUNTED_LOOP
 };
 
 static const string NODE_TYPE_STRINGS[] =
 {
     "PROGRAM", "COMPOUND", "ASSIGN", "LOOP", "TEST", "WRITE", "WRITELN",
-    "ADD", "SUBTRACT", "MULTIPLY", "DIVIDE", "EQ", "LT",
+    "ADD", "SUBTRACT", "MULTIPLY", "DIVIDE", "INTEGER_DIVIDE", "MODULO",
+    "EQ", "LT", "GT",
     "VARIABLE", "INTEGER_CONSTANT", "REAL_CONSTANT", "STRING_CONSTANT",
-	"NOT"
+	"NOT",
+    "ADD_INT", "SUBTRACT_INT", "MULTIPLY_INT",
+    "ADD_REAL", "SUBTRACT_REAL", "MULTIPLY_REAL", "DIVIDE_REAL",
+    "EQ_INT", "LT_INT", "GT_INT", "EQ_REAL", "LT_REAL", "GT_REAL",
+    "VARIABLE_INT", "VARIABLE_REAL",
+    "ASSIGN_VAR_OP_CONST", "TEST_VAR_CONST", "WRITE_VAR", "COUNTED_LOOP"
 };
 
+constexpr int NODE_TYPE_COUNT =
+    sizeof(NODE_TYPE_STRINGS)/sizeof(NODE_TYPE_STRINGS[0]);
+
 constexpr NodeType PROGRAM          = NodeType::PROGRAM;
 constexpr NodeType COMPOUND         = NodeType::COMPOUND;
 constexpr NodeType ASSIGN           = NodeType::ASSIGN;
@@ -45,30 +65,103 @@ constexpr NodeType ADD              = NodeType::ADD;
 constexpr NodeType SUBTRACT         = NodeType::SUBTRACT;
 constexpr NodeType MULTIPLY         = NodeType::MULTIPLY;
 constexpr NodeType DIVIDE           = NodeType::DIVIDE;
+constexpr NodeType INTEGER_DIVIDE   = NodeType::INTEGER_DIVIDE;
+constexpr NodeType MODULO           = NodeType::MODULO;
 constexpr NodeType EQ               = NodeType::EQ;
 constexpr NodeType LT               = NodeType::LT;
+constexpr NodeType GT               = NodeType::GT;
 constexpr NodeType VARIABLE         = NodeType::VARIABLE;
 constexpr NodeType INTEGER_CONSTANT = NodeType::INTEGER_CONSTANT;
 constexpr NodeType REAL_CONSTANT    = NodeType::REAL_CONSTANT;
 constexpr NodeType STRING_CONSTANT  = NodeType::STRING_CONSTANT;
 constexpr NodeType NOT 				= NodeType::NOT;
 
+constexpr NodeType ADD_INT       = NodeType::ADD_INT;
+constexpr NodeType SUBTRACT_INT  = NodeType::SUBTRACT_INT;
+constexpr NodeType MULTIPLY_INT  = NodeType::MULTIPLY_INT;
+constexpr NodeType ADD_REAL      = NodeType::ADD_REAL;
+constexpr NodeType SUBTRACT_REAL = NodeType::SUBTRACT_REAL;
+constexpr NodeType MULTIPLY_REAL = NodeType::MULTIPLY_REAL;
+constexpr NodeType DIVIDE_REAL   = NodeType::DIVIDE_REAL;
+constexpr NodeType EQ_INT        = NodeType::EQ_INT;
+constexpr NodeType LT_INT        = NodeType::LT_INT;
+constexpr NodeType GT_INT        = NodeType::GT_INT;
+constexpr NodeType EQ_REAL       = NodeType::EQ_REAL;
+constexpr NodeType LT_REAL       = NodeType::LT_REAL;
+constexpr NodeType GT_REAL       = NodeType::GT_REAL;
+constexpr NodeType VARIABLE_INT  = NodeType::VARIABLE_INT;
+constexpr NodeType VARIABLE_REAL = NodeType::VARIABLE_REAL;
+
+constexpr NodeType ASSIGN_VAR_OP_CONST = NodeType::ASSIGN_VAR_OP_CONST;
+constexpr NodeType TEST_VAR_CONST      = NodeType::TEST_VAR_CONST;
+constexpr NodeType WRITE_VAR           = NodeType::WRITE_VAR;
+constexpr NodeType COUNTED_LOOP        = NodeType::COUNTED_LOOP;
+
+class Node;
+
+// A node's children, in the arena with the node.
+typedef vector<Node *, ArenaMemory<Node *>> NodeList;
+
+/**
+ * A node's value: the numeric fields of an Object and its flag, but no
+ * string, so that a node holds nothing that a destructor must free.
+ */
+struct NodeValue
+{
+    long   L;
+    double D;
+    bool   B;
+
+    NodeValue() : L(0), D(0.0), B(false) {}
+    NodeValue(const Object &object) : L(object.L), D(object.D), B(object.B) {}
+
+    operator Object() const
+    {
+        Object object(L);
+        object.D = D;
+        object.B = B;
+
+        return object;
+    }
+};
+
+/**
+ * A parse tree node. Its name, or a string constant's characters, and
+ * its list of children are all in the arena, and its value only holds
+ * numbers, so a node needs no finalizer.
+ */
 class Node
 {
 public:
     NodeType type;
-    int lineNumber;
-    string text;
+    int offset;  // source offset, or -1 if none
+    ArenaString text;     // name or string constant
     SymtabEntry *entry;
-    Object value;
-    vector<Node *> children;
+    NodeValue value;      // numeric constant or the executor's scratch
+    ValueType valueType;  // an expression's type, set by the type checker
+    int id;               // preorder index in the parsed tree, or -1
+    NodeList children;
 
     Node(NodeType type)
-        : type(type), lineNumber(0), entry(nullptr) {}
+        : type(type), offset(-1), entry(nullptr),
+          valueType(ValueType::UNKNOWN), id(-1) {}
 
     void adopt(Node *child) { children.push_back(child); }
+
+    // Allocate nodes from the parser's allocator.
+    static void *operator new(size_t size)
+    {
+        return Allocator::allocate<Node>(Subsystem::PARSER, size);
+    }
+    static void operator delete(void *node, size_t size)
+    {
+        Allocator::release(Subsystem::PARSER, node, size);
+    }
 };
 
+template<>
+struct NeedsFinalizer<Node> { static const bool value = false; };
+
 }  // namespace intermediate
 
 #endif /* NODE_H_ */
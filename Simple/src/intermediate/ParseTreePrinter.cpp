@@ -6,6 +6,10 @@
  * San Jose State University
  */
 #include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
 
 #include "Node.h"
 #include "ParseTreePrinter.h"
@@ -14,53 +18,355 @@ namespace intermediate {
 
 using namespace std;
 
-const string ParseTreePrinter::INDENT_SIZE = "    ";
-
 void ParseTreePrinter::print(Node *node)
 {
-    // Opening tag.
-    line += indentation;
-    line += "<" + NODE_TYPE_STRINGS[(int) node->type];
-
-    // Attributes.
-    if      (node->type == PROGRAM)          line += " " + node->text;
-    else if (node->type == VARIABLE)         line += " " + node->text;
-    else if (node->type == INTEGER_CONSTANT) line += " " + to_string(node->value.L);
-    else if (node->type == REAL_CONSTANT)    line += " " + to_string(node->value.D);
-    else if (node->type == STRING_CONSTANT)  line += " '" + node->value.S + "'";
-    if (node->lineNumber > 0)                line += " line " + to_string(node->lineNumber);
-
-    // Print the node's children followed by the closing tag.
-    vector<Node *> children = node->children;
-    if (children.size() > 0)
+    if (buffer.empty()) buffer.resize(BUFFER_SIZE);
+    if (format == BINARY) append("STRE", 4);
+
+    printOpen(node, 0, true);
+    if (hasChildren(node)) stack.push_back({node, 0, false});
+
+    // Each pass either descends into the next child of the node on top
+    // of the stack or, when it has none left, closes it.
+    while (!stack.empty())
     {
-        line += ">";
-        printLine();
+        Frame &frame = stack.back();
+        NodeList &children = frame.node->children;
+
+        // A WHILE without a body has a null child.
+        while ((frame.next < children.size()) && (children[frame.next] == nullptr))
+        {
+            frame.next++;
+        }
 
-        printChildren(children);
-        line += indentation;
-        line += "</" + NODE_TYPE_STRINGS[(int) node->type] + ">";
+        if (frame.next < children.size())
+        {
+            Node *child = children[frame.next++];
+            bool first = !frame.printed;
+            frame.printed = true;
+
+            // The push can move the frame.
+            int depth = stack.size();
+            printOpen(child, depth, first);
+            if (hasChildren(child)) stack.push_back({child, 0, false});
+        }
+        else
+        {
+            Node *parent = frame.node;
+            stack.pop_back();
+            printClose(parent, stack.size());
+        }
     }
 
-    // No children: Close off the tag.
-    else line += " />";
+    if (format == JSON) append('\n');
+    flush();
+}
 
-    printLine();
+void ParseTreePrinter::printOpen(Node *node, int depth, bool first)
+{
+    const string &typeName = NODE_TYPE_STRINGS[(int) node->type];
+
+    switch (format)
+    {
+        case XML :
+        {
+            appendIndentation(depth);
+            append('<');
+            append(typeName);
+            printXmlAttributes(node);
+            append(hasChildren(node) ? ">\n" : " />\n");
+            break;
+        }
+
+        case JSON :
+        {
+            if (!first) append(',');
+            append("{\"type\":\"");
+            append(typeName);
+            append('"');
+            printJsonMembers(node);
+            append(hasChildren(node) ? ",\"children\":[" : "}");
+            break;
+        }
+
+        default : printBinary(node); break;
+    }
 }
 
-void ParseTreePrinter::printChildren(vector<Node *> children)
+void ParseTreePrinter::printClose(Node *node, int depth)
 {
-    string saveIndentation = indentation;
-    indentation += INDENT_SIZE;
-    for (Node *child : children) print(child);
-    indentation = saveIndentation;
+    switch (format)
+    {
+        case XML :
+        {
+            appendIndentation(depth);
+            append("</");
+            append(NODE_TYPE_STRINGS[(int) node->type]);
+            append(">\n");
+            break;
+        }
+
+        case JSON : append("]}"); break;
+
+        default : break;  // binary nodes carry their child counts
+    }
 }
 
-void ParseTreePrinter::printLine()
+void ParseTreePrinter::printXmlAttributes(Node *node)
 {
-    cout << line << endl;
-    line = "";
+    char number[64];
+
+    switch (node->type)
+    {
+        case PROGRAM :
+        case VARIABLE :
+        {
+            append(' ');
+            append(node->text);
+            break;
+        }
+
+        case INTEGER_CONSTANT :
+        {
+            append(' ');
+            appendLong(node->value.L);
+            break;
+        }
+
+        case REAL_CONSTANT :
+        {
+            // Like to_string.
+            int count = snprintf(number, sizeof(number), " %f", node->value.D);
+            if (count < (int) sizeof(number)) append(number, count);
+            else append(" " + to_string(node->value.D));
+            break;
+        }
+
+        case STRING_CONSTANT :
+        {
+            append(" '");
+            append(node->text);
+            append('\'');
+            break;
+        }
+
+        default : break;
+    }
+
+    int line = lineNumber(node);
+    if (line > 0)
+    {
+        append(" line ");
+        appendLong(line);
+    }
 }
 
-}  // namespace intermediate
+void ParseTreePrinter::printJsonMembers(Node *node)
+{
+    switch (node->type)
+    {
+        case PROGRAM :
+        case VARIABLE :
+        {
+            append(",\"text\":");
+            printJsonString(node->text);
+            break;
+        }
+
+        case INTEGER_CONSTANT :
+        {
+            append(",\"value\":");
+            appendLong(node->value.L);
+            break;
+        }
+
+        case REAL_CONSTANT :
+        {
+            // Enough digits to read back the same double.
+            // JSON has no infinity or NaN.
+            append(",\"value\":");
+            if (isfinite(node->value.D))
+            {
+                char number[32];
+                int count = snprintf(number, sizeof(number), "%.17g",
+                                     node->value.D);
+                append(number, count);
+            }
+            else append("null");
+            break;
+        }
+
+        case STRING_CONSTANT :
+        {
+            append(",\"value\":");
+            printJsonString(node->text);
+            break;
+        }
+
+        default : break;
+    }
+
+    int line = lineNumber(node);
+    if (line > 0)
+    {
+        append(",\"line\":");
+        appendLong(line);
+    }
+}
+
+void ParseTreePrinter::printBinary(Node *node)
+{
+    append((char) node->type);
+    printUnsigned(lineNumber(node));
+    printUnsigned(childCount(node));
+
+    switch (node->type)
+    {
+        case PROGRAM :
+        case VARIABLE :
+        {
+            printUnsigned(node->text.size());
+            append(node->text);
+            break;
+        }
+
+        case INTEGER_CONSTANT :
+        {
+            // Zigzag, so that a small negative number is short too.
+            long value = node->value.L;
+            printUnsigned(((unsigned long) value << 1) ^ (value >> 63));
+            break;
+        }
 
+        case REAL_CONSTANT :
+        {
+            char bytes[sizeof(double)];
+            memcpy(bytes, &node->value.D, sizeof(double));
+            append(bytes, sizeof(double));
+            break;
+        }
+
+        case STRING_CONSTANT :
+        {
+            printUnsigned(node->text.size());
+            append(node->text);
+            break;
+        }
+
+        default : break;
+    }
+}
+
+void ParseTreePrinter::printJsonString(const ArenaString &str)
+{
+    append('"');
+
+    for (char ch : str)
+    {
+        if      (ch == '"')  append("\\\"");
+        else if (ch == '\\') append("\\\\");
+        else if ((unsigned char) ch < 0x20)
+        {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\u%04x", ch);
+            append(escape, 6);
+        }
+        else append(ch);
+    }
+
+    append('"');
+}
+
+void ParseTreePrinter::printUnsigned(unsigned long value)
+{
+    while (value >= 0x80)
+    {
+        append((char) ((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+
+    append((char) value);
+}
+
+int ParseTreePrinter::lineNumber(Node *node)
+{
+    return (node->offset >= 0) && (lines != nullptr)
+                ? lines->lineNumber(node->offset) : 0;
+}
+
+size_t ParseTreePrinter::childCount(Node *node) const
+{
+    size_t count = 0;
+    for (Node *child : node->children) if (child != nullptr) count++;
+
+    return count;
+}
+
+void ParseTreePrinter::append(const char *text, size_t count)
+{
+    if (length + count > buffer.size())
+    {
+        flush();
+
+        // Too big to buffer: write it straight out.
+        if (count > buffer.size())
+        {
+            out->write(text, count);
+            return;
+        }
+    }
+
+    memcpy(&buffer[length], text, count);
+    length += count;
+}
+
+void ParseTreePrinter::append(const char *text)
+{
+    append(text, strlen(text));
+}
+
+void ParseTreePrinter::append(char ch)
+{
+    if (length == buffer.size()) flush();
+    buffer[length++] = ch;
+}
+
+void ParseTreePrinter::appendLong(long value)
+{
+    // Digits from the right, without snprintf's format parsing.
+    char digits[24];
+    char *p = digits + sizeof(digits);
+    unsigned long magnitude = value < 0 ? 0 - (unsigned long) value : value;
+
+    do
+    {
+        *--p = '0' + magnitude%10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    if (value < 0) *--p = '-';
+    append(p, digits + sizeof(digits) - p);
+}
+
+void ParseTreePrinter::appendIndentation(int depth)
+{
+    static const char SPACES[] = "                                        "
+                                 "                                        ";
+    size_t count = depth*INDENT_SIZE;
+
+    while (count > 0)
+    {
+        size_t chunk = min(count, sizeof(SPACES) - 1);
+        append(SPACES, chunk);
+        count -= chunk;
+    }
+}
+
+void ParseTreePrinter::flush()
+{
+    out->write(buffer.data(), length);
+    out->flush();
+    length = 0;
+}
+
+}  // namespace intermediate
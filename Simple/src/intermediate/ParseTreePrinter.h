@@ -8,25 +8,70 @@
 #ifndef PARSETREEPRINTER_H_
 #define PARSETREEPRINTER_H_
 
+#include <iostream>
 #include <string>
 #include <vector>
 
 #include "Node.h"
+#include "LineMap.h"
 
 namespace intermediate {
 
 using namespace std;
 
+/**
+ * Print a parse tree in one of three formats:
+ *
+ *     XML     an indented tag per node, the default
+ *     JSON    one line of nested objects with type, text or value,
+ *             line and children members
+ *     BINARY  "STRE", then each node in preorder: its type byte, its
+ *             line number and non-null child count as unsigned LEB128,
+ *             then a PROGRAM or VARIABLE's name, or a constant's value:
+ *             a zigzag LEB128 integer, a native double, or a LEB128
+ *             length and the string's bytes
+ *
+ * The tree is walked with an explicit stack, so a deep tree can't
+ * overflow the call stack. The output goes through a fixed buffer.
+ * Neither allocates per node.
+ */
 class ParseTreePrinter
 {
+public:
+    static const int XML = 0;
+    static const int JSON = 1;
+    static const int BINARY = 2;
+
 private:
-    static const string INDENT_SIZE;
+    static const int INDENT_SIZE = 4;
+    static const int BUFFER_SIZE = 64*1024;
+
+    /**
+     * A node whose children are being printed.
+     */
+    struct Frame
+    {
+        Node *node;
+        size_t next;   // index of the next child to print
+        bool printed;  // true once a child has been printed
+    };
 
-    string indentation;  // indentation of a line
-    string line;         // output line
+    LineMap *lines;        // to print the nodes' line numbers
+    int format;            // XML, JSON or BINARY
+    ostream *out;          // where the tree goes
+    vector<char> buffer;   // output not yet written, allocated by print()
+    size_t length;         // of the output in the buffer
+    vector<Frame> stack;   // path from the root to the current node
 
 public:
-    ParseTreePrinter() : indentation(""), line("") {}
+    /**
+     * Constructor.
+     * @param lines the source's line map, or null to omit line numbers.
+     * @param format XML, JSON or BINARY.
+     * @param out the output stream.
+     */
+    ParseTreePrinter(LineMap *lines, int format = XML, ostream &out = cout)
+        : lines(lines), format(format), out(&out), length(0) {}
 
     /**
      * Print a parse tree.
@@ -36,15 +81,62 @@ public:
 
 private:
     /**
-     * Print a parse tree node's child nodes.
-     * @param children the array list of child nodes.
+     * Print a node's opening tag or object, or all of it in binary.
+     * @param node the node.
+     * @param depth its depth in the tree.
+     * @param first true if it's its parent's first child printed.
+     */
+    void printOpen(Node *node, int depth, bool first);
+
+    /**
+     * Print a node's closing tag or the end of its object.
+     * @param node the node.
+     * @param depth its depth in the tree.
      */
-    void printChildren(vector<Node *> children);
+    void printClose(Node *node, int depth);
 
     /**
-     * Print an output line.
+     * Print a node's name or value as an XML attribute.
+     * @param node the node.
      */
-    void printLine();
+    void printXmlAttributes(Node *node);
+
+    /**
+     * Print a node's name or value as JSON members.
+     * @param node the node.
+     */
+    void printJsonMembers(Node *node);
+
+    /**
+     * Print a node in binary, except for its children.
+     * @param node the node.
+     */
+    void printBinary(Node *node);
+
+    /**
+     * Print a string as a quoted JSON string.
+     * @param str the string.
+     */
+    void printJsonString(const ArenaString &str);
+
+    /**
+     * Print an unsigned LEB128 number.
+     * @param value the number.
+     */
+    void printUnsigned(unsigned long value);
+
+    int lineNumber(Node *node);
+    bool hasChildren(Node *node) const { return !node->children.empty(); }
+    size_t childCount(Node *node) const;
+
+    void append(const char *text, size_t count);
+    void append(const string &text) { append(text.data(), text.size()); }
+    void append(const ArenaString &text) { append(text.data(), text.size()); }
+    void append(const char *text);
+    void append(char ch);
+    void appendLong(long value);
+    void appendIndentation(int depth);
+    void flush();
 };
 
 }  // namespace intermediate
@@ -9,6 +9,7 @@
 #define SYMTAB_H_
 
 #include <string>
+#include <string_view>
 #include <map>
 
 #include "SymtabEntry.h"
@@ -17,12 +18,39 @@ namespace intermediate {
 
 using namespace std;
 
+/**
+ * The symbol table. Its map and the map's keys are in the arena with
+ * its entries, so it needs no finalizer.
+ */
 class Symtab
 {
 private:
-    map<string, SymtabEntry *> contents;
+    // Compare a name in the arena with any other string without copying.
+    struct NameLess
+    {
+        typedef void is_transparent;
+
+        bool operator ()(string_view name1, string_view name2) const
+        {
+            return name1 < name2;
+        }
+    };
+
+    typedef pair<const ArenaString, SymtabEntry *> Pair;
+
+    map<ArenaString, SymtabEntry *, NameLess, ArenaMemory<Pair>> contents;
 
 public:
+    // Allocate the table from the symbol table's allocator.
+    static void *operator new(size_t size)
+    {
+        return Allocator::allocate<Symtab>(Subsystem::SYMTAB, size);
+    }
+    static void operator delete(void *symtab, size_t size)
+    {
+        Allocator::release(Subsystem::SYMTAB, symtab, size);
+    }
+
     SymtabEntry *enter(string name)
     {
         SymtabEntry *entry = new SymtabEntry(name);
@@ -31,13 +59,18 @@ public:
         return entry;
     }
 
-    SymtabEntry *lookup(string name)
+    SymtabEntry *lookup(string_view name)
     {
-        return contents.find(name) != contents.end() ? contents[name]
-                                                     : nullptr;
+        auto found = contents.find(name);
+        return found != contents.end() ? found->second : nullptr;
     }
+
+    int size() const { return contents.size(); }
 };
 
+template<>
+struct NeedsFinalizer<Symtab> { static const bool value = false; };
+
 }  // namespace intermediate
 
 #endif /* SYMTAB_H_ */
@@ -10,6 +10,9 @@
 
 #include <string>
 
+#include "Allocator.h"
+#include "ValueType.h"
+
 namespace intermediate {
 
 using namespace std;
@@ -17,18 +20,67 @@ using namespace std;
 class SymtabEntry
 {
 private:
-    string name;
-    double value;
+    ArenaString name;  // in the arena, so the entry needs no finalizer
+    ValueType type;  // INTEGER or REAL
+    double value;    // the value of a REAL variable
+    long integer;    // the value of an INTEGER variable
 
 public:
-    SymtabEntry(string name) : name(name), value(0.0) {}
+    SymtabEntry(string name)
+        : name(name), type(ValueType::REAL), value(0.0), integer(0) {}
+
+    // Allocate entries from the symbol table's allocator.
+    static void *operator new(size_t size)
+    {
+        return Allocator::allocate<SymtabEntry>(Subsystem::SYMTAB, size);
+    }
+    static void operator delete(void *entry, size_t size)
+    {
+        Allocator::release(Subsystem::SYMTAB, entry, size);
+    }
 
     string getName()  const { return name;  }
-    double getValue() const { return value; }
+    ValueType getType() const { return type; }
+
+    double getValue() const
+    {
+        return type == ValueType::INTEGER ? (double) integer : value;
+    }
+
+    long getInteger() const
+    {
+        return type == ValueType::INTEGER ? integer : (long) value;
+    }
 
-    void setValue(const double value) { this->value = value; }
+    /**
+     * Set the variable's type, keeping its value.
+     * @param type INTEGER or REAL.
+     */
+    void setType(const ValueType type)
+    {
+        if (type == this->type) return;
+
+        if (type == ValueType::INTEGER) integer = (long) value;
+        else                            value   = integer;
+        this->type = type;
+    }
+
+    void setValue(const double value)
+    {
+        if (type == ValueType::INTEGER) integer = (long) value;
+        else                            this->value = value;
+    }
+
+    void setInteger(const long integer)
+    {
+        if (type == ValueType::INTEGER) this->integer = integer;
+        else                            value = integer;
+    }
 };
 
+template<>
+struct NeedsFinalizer<SymtabEntry> { static const bool value = false; };
+
 }  // namespace intermediate
 
 #endif /* SYMTABENTRY_H_ */
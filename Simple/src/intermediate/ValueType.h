@@ -0,0 +1,34 @@
+/**
+ * Value type for a simple interpreter.
+ *
+ * (c) 2020 by Ronald Mak
+ * Department of Computer Science
+ * San Jose State University
+ */
+#ifndef VALUETYPE_H_
+#define VALUETYPE_H_
+
+#include <string>
+
+namespace intermediate {
+
+using namespace std;
+
+/**
+ * The static type of an expression or a variable, as the type checker
+ * infers it. Variables aren't declared, so a variable is an INTEGER
+ * only if every value ever assigned to it is.
+ */
+enum class ValueType
+{
+    UNKNOWN, INTEGER, REAL, BOOLEAN, STRING
+};
+
+static const string VALUE_TYPE_STRINGS[] =
+{
+    "UNKNOWN", "INTEGER", "REAL", "BOOLEAN", "STRING"
+};
+
+}  // namespace intermediate
+
+#endif /* VALUETYPE_H_ */